@@ -0,0 +1,360 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <seagrass.h>
+#include <triggerfish.h>
+#include <squid.h>
+
+/*
+ * Measures the executor and prints the results as a single JSON document on
+ * stdout so that runs can be compared against each other.
+ *
+ * usage: aquarium-squid-bench [-n tasks] [-l samples] [-p producers]
+ *                             [-t threads] [-s]
+ *
+ *  -n  tasks per throughput, fan out and shutdown run (default 100000)
+ *  -l  round trips sampled for latency percentiles (default 10000)
+ *  -p  most producer threads, doubled from one up to it (default 4)
+ *  -t  executor threads (default count of online processors)
+ *  -s  enable work stealing
+ */
+
+#define FAN_OUT_BREADTH                                     8
+
+struct settings {
+    uintmax_t tasks;
+    uintmax_t samples;
+    uintmax_t producers;
+    uintmax_t threads;
+    bool is_stealing;
+};
+
+static struct settings settings = {
+        .tasks = 100000,
+        .samples = 10000,
+        .producers = 4
+};
+
+static bool is_first = true;
+
+static uint64_t nanos(void) {
+    struct timespec now;
+    seagrass_required_true(!clock_gettime(CLOCK_MONOTONIC, &now));
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
+static double seconds(const uint64_t ns) {
+    return (double) ns / 1e9;
+}
+
+/* opens the JSON object of a result, the caller adds the fields and closes
+ * it */
+static void result(const char *const benchmark) {
+    printf("%s\n    {\"benchmark\":\"%s\"", is_first ? "" : ",", benchmark);
+    is_first = false;
+}
+
+static struct triggerfish_strong *create(struct squid_executor **const out) {
+    struct squid_executor_options options;
+    seagrass_required_true(squid_executor_options_init(&options));
+    options.threads.maximum = settings.threads;
+    options.threads.prestart = settings.threads;
+    options.work_stealing.is_enabled = settings.is_stealing;
+    struct triggerfish_strong *instance;
+    seagrass_required_true(squid_executor_of_with_options(&options,
+                                                          &instance));
+    seagrass_required_true(triggerfish_strong_instance(instance,
+                                                       (void **) out));
+    return instance;
+}
+
+static void empty(void *const args,
+                  bool (*const is_cancelled)(void),
+                  struct triggerfish_strong **const out,
+                  uintmax_t *const error) {
+    atomic_fetch_add_explicit((atomic_uintmax_t *) args, 1,
+                              memory_order_relaxed);
+}
+
+static void nothing(void *const args,
+                    bool (*const is_cancelled)(void),
+                    struct triggerfish_strong **const out,
+                    uintmax_t *const error) {
+}
+
+struct producer {
+    pthread_t thread;
+    struct squid_executor *executor;
+    pthread_barrier_t *barrier;
+    atomic_uintmax_t *done;
+    uintmax_t count;
+    bool is_execute;
+};
+
+static void *produce(void *const args) {
+    struct producer *const producer = args;
+    pthread_barrier_wait(producer->barrier);
+    for (uintmax_t i = 0; i < producer->count; i++) {
+        if (producer->is_execute) {
+            seagrass_required_true(squid_executor_execute(
+                    producer->executor, empty, producer->done));
+            continue;
+        }
+        struct triggerfish_strong *future;
+        seagrass_required_true(squid_executor_submit(
+                producer->executor, empty, producer->done, &future));
+        seagrass_required_true(triggerfish_strong_release(future));
+    }
+    return NULL;
+}
+
+/* empty tasks from a number of producers until all of them have run */
+static void throughput(const uintmax_t producers, const bool is_execute) {
+    struct squid_executor *executor;
+    struct triggerfish_strong *const instance = create(&executor);
+    struct producer *const items = calloc(producers, sizeof(*items));
+    seagrass_required_true(NULL != items);
+    pthread_barrier_t barrier;
+    seagrass_required_true(!pthread_barrier_init(&barrier, NULL,
+                                                 1 + producers));
+    atomic_uintmax_t done = 0;
+    uintmax_t total = 0;
+    for (uintmax_t i = 0; i < producers; i++) {
+        items[i] = (struct producer) {
+                .executor = executor,
+                .barrier = &barrier,
+                .done = &done,
+                .count = settings.tasks / producers
+                         + (i < settings.tasks % producers ? 1 : 0),
+                .is_execute = is_execute
+        };
+        total += items[i].count;
+        seagrass_required_true(!pthread_create(&items[i].thread, NULL,
+                                               produce, &items[i]));
+    }
+    pthread_barrier_wait(&barrier);
+    const uint64_t start = nanos();
+    while (atomic_load(&done) < total) {
+        sched_yield();
+    }
+    const uint64_t elapsed = nanos() - start;
+    for (uintmax_t i = 0; i < producers; i++) {
+        seagrass_required_true(!pthread_join(items[i].thread, NULL));
+    }
+    seagrass_required_true(!pthread_barrier_destroy(&barrier));
+    free(items);
+    seagrass_required_true(triggerfish_strong_release(instance));
+    result("throughput");
+    printf(",\"function\":\"%s\",\"producers\":%" PRIuMAX ","
+           "\"tasks\":%" PRIuMAX ",\"seconds\":%.6f,"
+           "\"tasks_per_second\":%.0f}",
+           is_execute ? "execute" : "submit", producers, total,
+           seconds(elapsed), (double) total / seconds(elapsed));
+}
+
+static int compare(const void *const a, const void *const b) {
+    const uint64_t x = *(const uint64_t *) a;
+    const uint64_t y = *(const uint64_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+static uint64_t percentile(const uint64_t *const sorted,
+                           const uintmax_t count,
+                           const double fraction) {
+    uintmax_t index = (uintmax_t) (fraction * (double) count);
+    return sorted[index < count ? index : count - 1];
+}
+
+/* one task at a time from submit until get returns */
+static void latency(void) {
+    struct squid_executor *executor;
+    struct triggerfish_strong *const instance = create(&executor);
+    uint64_t *const samples = malloc(settings.samples * sizeof(*samples));
+    seagrass_required_true(NULL != samples);
+    for (uintmax_t i = 0; i < settings.samples; i++) {
+        const uint64_t start = nanos();
+        struct triggerfish_strong *future;
+        seagrass_required_true(squid_executor_submit(executor, nothing, NULL,
+                                                     &future));
+        struct squid_future *object;
+        seagrass_required_true(triggerfish_strong_instance(
+                future, (void **) &object));
+        struct triggerfish_strong *out;
+        seagrass_required_true(squid_future_get(object, &out, NULL));
+        samples[i] = nanos() - start;
+        seagrass_required_true(triggerfish_strong_release(future));
+    }
+    qsort(samples, settings.samples, sizeof(*samples), compare);
+    seagrass_required_true(triggerfish_strong_release(instance));
+    result("latency");
+    printf(",\"samples\":%" PRIuMAX ",\"p50_ns\":%" PRIu64 ","
+           "\"p90_ns\":%" PRIu64 ",\"p99_ns\":%" PRIu64 ","
+           "\"p999_ns\":%" PRIu64 ",\"max_ns\":%" PRIu64 "}",
+           settings.samples,
+           percentile(samples, settings.samples, 0.5),
+           percentile(samples, settings.samples, 0.9),
+           percentile(samples, settings.samples, 0.99),
+           percentile(samples, settings.samples, 0.999),
+           samples[settings.samples - 1]);
+    free(samples);
+}
+
+struct node {
+    struct squid_executor *executor;
+    uintmax_t depth;
+};
+
+/* submits its children and waits for all of them before it is done */
+static void fan(void *const args,
+                bool (*const is_cancelled)(void),
+                struct triggerfish_strong **const out,
+                uintmax_t *const error) {
+    const struct node *const node = args;
+    if (!node->depth) {
+        return;
+    }
+    struct node children[FAN_OUT_BREADTH];
+    struct triggerfish_strong *futures[FAN_OUT_BREADTH];
+    for (uintmax_t i = 0; i < FAN_OUT_BREADTH; i++) {
+        children[i] = (struct node) {
+                .executor = node->executor,
+                .depth = node->depth - 1
+        };
+        seagrass_required_true(squid_executor_submit(
+                node->executor, fan, &children[i], &futures[i]));
+    }
+    for (uintmax_t i = 0; i < FAN_OUT_BREADTH; i++) {
+        struct squid_future *future;
+        seagrass_required_true(triggerfish_strong_instance(
+                futures[i], (void **) &future));
+        struct triggerfish_strong *result;
+        seagrass_required_true(squid_future_get(future, &result, NULL));
+        seagrass_required_true(triggerfish_strong_release(futures[i]));
+    }
+}
+
+/* trees of tasks that are as close to settings.tasks as a whole tree gets */
+static void fan_out(void) {
+    uintmax_t depth = 0;
+    uintmax_t size = 1;
+    for (uintmax_t level = 1; size + level * FAN_OUT_BREADTH <= settings.tasks;
+         depth++) {
+        level *= FAN_OUT_BREADTH;
+        size += level;
+    }
+    struct squid_executor *executor;
+    struct triggerfish_strong *const instance = create(&executor);
+    const struct node root = {
+            .executor = executor,
+            .depth = depth
+    };
+    const uint64_t start = nanos();
+    struct triggerfish_strong *future;
+    seagrass_required_true(squid_executor_submit(executor, fan,
+                                                 (void *) &root, &future));
+    struct squid_future *object;
+    seagrass_required_true(triggerfish_strong_instance(future,
+                                                       (void **) &object));
+    struct triggerfish_strong *out;
+    seagrass_required_true(squid_future_get(object, &out, NULL));
+    const uint64_t elapsed = nanos() - start;
+    seagrass_required_true(triggerfish_strong_release(future));
+    seagrass_required_true(triggerfish_strong_release(instance));
+    result("fan_out");
+    printf(",\"breadth\":%d,\"depth\":%" PRIuMAX ",\"tasks\":%" PRIuMAX ","
+           "\"seconds\":%.6f,\"tasks_per_second\":%.0f}",
+           FAN_OUT_BREADTH, depth, size, seconds(elapsed),
+           (double) size / seconds(elapsed));
+}
+
+/* from shutdown until every thread has exited, with tasks left queued */
+static void terminate(const uintmax_t queued, const bool is_now) {
+    struct squid_executor *executor;
+    struct triggerfish_strong *const instance = create(&executor);
+    atomic_uintmax_t done = 0;
+    for (uintmax_t i = 0; i < queued; i++) {
+        seagrass_required_true(squid_executor_execute(executor, empty,
+                                                      &done));
+    }
+    const uint64_t start = nanos();
+    uintmax_t count = 0;
+    if (is_now) {
+        seagrass_required_true(squid_executor_shutdown_now(executor,
+                                                           &count));
+    } else {
+        seagrass_required_true(squid_executor_shutdown(executor));
+    }
+    seagrass_required_true(squid_executor_await_termination(executor, NULL));
+    const uint64_t elapsed = nanos() - start;
+    seagrass_required_true(triggerfish_strong_release(instance));
+    result("shutdown");
+    printf(",\"function\":\"%s\",\"queued\":%" PRIuMAX ","
+           "\"ran\":%" PRIuMAX ",\"withdrawn\":%" PRIuMAX ","
+           "\"seconds\":%.6f}",
+           is_now ? "shutdown_now" : "shutdown", queued, atomic_load(&done),
+           count, seconds(elapsed));
+}
+
+static bool parse(const char *const text, uintmax_t *const out) {
+    char *end;
+    const uintmax_t value = strtoumax(text, &end, 10);
+    if (!*text || *end || !value) {
+        return false;
+    }
+    *out = value;
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    const long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    settings.threads = processors > 1 ? (uintmax_t) processors : 1;
+    int option;
+    while (-1 != (option = getopt(argc, argv, "n:l:p:t:s"))) {
+        bool is_valid = true;
+        switch (option) {
+            case 'n':
+                is_valid = parse(optarg, &settings.tasks);
+                break;
+            case 'l':
+                is_valid = parse(optarg, &settings.samples);
+                break;
+            case 'p':
+                is_valid = parse(optarg, &settings.producers);
+                break;
+            case 't':
+                is_valid = parse(optarg, &settings.threads);
+                break;
+            case 's':
+                settings.is_stealing = true;
+                break;
+            default:
+                is_valid = false;
+        }
+        if (!is_valid) {
+            fprintf(stderr, "usage: %s [-n tasks] [-l samples] "
+                            "[-p producers] [-t threads] [-s]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    printf("{\"version\":\"%s\",\"processors\":%ld,\"threads\":%" PRIuMAX ","
+           "\"work_stealing\":%s,\"results\":[",
+           SQUID_VERSION, processors, settings.threads,
+           settings.is_stealing ? "true" : "false");
+    for (uintmax_t producers = 1; producers <= settings.producers;
+         producers *= 2) {
+        throughput(producers, false);
+        throughput(producers, true);
+    }
+    latency();
+    fan_out();
+    terminate(0, false);
+    terminate(settings.tasks, false);
+    terminate(settings.tasks, true);
+    printf("\n]}\n");
+    return EXIT_SUCCESS;
+}
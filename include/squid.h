@@ -8,5 +8,8 @@
 #include <squid/error.h>
 #include <squid/executor.h>
 #include <squid/future.h>
+#include <squid/parallel.h>
+#include <squid/strand.h>
+#include <squid/trace.h>
 
 #endif /* _SQUID_SQUID_H_ */
@@ -4,6 +4,7 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <time.h>
 
 #define SQUID_EXECUTOR_ERROR_OUT_IS_NULL                    1
 #define SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL                 2
@@ -11,11 +12,203 @@
 #define SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN          4
 #define SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL               5
 #define SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED         6
+#define SQUID_EXECUTOR_ERROR_OPTIONS_IS_NULL                7
+#define SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID             8
+#define SQUID_EXECUTOR_ERROR_TASKS_IS_NULL                  9
+#define SQUID_EXECUTOR_ERROR_COUNT_IS_ZERO                  10
+#define SQUID_EXECUTOR_ERROR_TIMED_OUT                      11
+#define SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL                  12
+#define SQUID_EXECUTOR_ERROR_PRIORITY_IS_INVALID            13
+#define SQUID_EXECUTOR_ERROR_PERIOD_IS_ZERO                 14
+#define SQUID_EXECUTOR_ERROR_DEADLINE_IS_NULL               15
+#define SQUID_EXECUTOR_ERROR_DEADLINE_IS_INVALID            16
+
+/* CPUs that the affinity option can name */
+#define SQUID_EXECUTOR_CPUS                                 1024
 
 struct triggerfish_strong;
 struct squid_executor;
 struct squid_future;
 
+enum squid_executor_rejection {
+    SQUID_EXECUTOR_REJECTION_FAIL = 0,
+    SQUID_EXECUTOR_REJECTION_BLOCK = 1,
+    SQUID_EXECUTOR_REJECTION_CALLER_RUNS = 2,
+    SQUID_EXECUTOR_REJECTION_DISCARD_OLDEST = 3
+};
+
+enum squid_executor_backend {
+    SQUID_EXECUTOR_BACKEND_DEFAULT = 0,
+    SQUID_EXECUTOR_BACKEND_LINKED = 1,
+    SQUID_EXECUTOR_BACKEND_RING = 2,
+    SQUID_EXECUTOR_BACKEND_DEADLINE = 3
+};
+
+enum squid_executor_priority {
+    SQUID_EXECUTOR_PRIORITY_HIGH = 0,
+    SQUID_EXECUTOR_PRIORITY_NORMAL = 1,
+    SQUID_EXECUTOR_PRIORITY_LOW = 2
+};
+
+struct squid_executor_options {
+    struct {
+        /**
+         * @brief Threads that are kept alive even when idle.
+         */
+        uintmax_t minimum;
+        /**
+         * @brief Upper bound of threads, once reached tasks are queued
+         * until a thread becomes available.
+         */
+        uintmax_t maximum;
+        /**
+         * @brief Threads that are created along with the executor.
+         */
+        uintmax_t prestart;
+        /**
+         * @brief Bytes of stack that each thread is created with, rounded
+         * up to the page size. Zero for the system default.
+         */
+        size_t stack_size;
+        /**
+         * @brief Prefix of the name each thread is given, followed by the
+         * order in which it was started, such as <i>squid-w3</i>. The name
+         * is cut short to the 15 characters the system allows, the number
+         * being kept whole. <i>NULL</i> to leave threads unnamed.
+         * <p>The prefix is copied so it need not outlive the options.</p>
+         */
+        const char *name;
+        /**
+         * @brief Called on each thread as it starts, before it runs any
+         * task, or <i>NULL</i>.
+         */
+        void (*on_start)(void *context);
+        /**
+         * @brief Called on each thread as it exits, after it has run its
+         * last task, or <i>NULL</i>. Awaiting termination returns only once
+         * it has been called on every thread.
+         */
+        void (*on_exit)(void *context);
+        /**
+         * @brief Passed to on_start and on_exit.
+         */
+        void *context;
+    } threads;
+    struct {
+        /**
+         * @brief Give each thread its own deque where tasks submitted from
+         * within that thread are placed and let idle threads steal tasks
+         * from the deques of other threads.
+         * <p>Requires a bounded maximum of threads.</p>
+         */
+        bool is_enabled;
+        /**
+         * @brief Capacity of each thread's deque, once full tasks are
+         * placed in the shared queue.
+         */
+        uintmax_t capacity;
+    } work_stealing;
+    struct {
+        /**
+         * @brief Bound on the tasks waiting in each priority lane of the
+         * shared queue, zero for an unbounded queue.
+         * <p>A ring backend rounds the capacity up to a power of two.</p>
+         */
+        uintmax_t capacity;
+        /**
+         * @brief What happens to tasks that do not fit in a bounded queue.
+         * <ul>
+         * <li>FAIL rejects them with
+         * {@link SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL}.</li>
+         * <li>BLOCK waits for room, but runs them on the submitting thread
+         * instead if that is one of the executor's own threads.</li>
+         * <li>CALLER_RUNS runs them on the submitting thread.</li>
+         * <li>DISCARD_OLDEST drops the longest waiting tasks to make room,
+         * cancelling their futures.</li>
+         * </ul>
+         */
+        enum squid_executor_rejection rejection;
+        /**
+         * @brief Milliseconds that BLOCK waits for room before failing with
+         * {@link SQUID_EXECUTOR_ERROR_TIMED_OUT}, zero to wait without a
+         * time limit.
+         */
+        uintmax_t timeout;
+        /**
+         * @brief Data structure behind the shared queue.
+         * <ul>
+         * <li>DEFAULT picks RING for a bounded queue and LINKED
+         * otherwise.</li>
+         * <li>LINKED is a lock-free linked queue whose nodes are recycled
+         * through a pool, it may be bounded or unbounded.</li>
+         * <li>RING is a lock-free array of slots allocated up front, each on
+         * its own cache line, which avoids per task allocations under heavy
+         * contention. It requires a bounded queue.</li>
+         * <li>DEADLINE is a heap guarded by a mutex that hands out the task
+         * with the earliest deadline first, see
+         * {@link squid_executor_submit_with_deadline}. Tasks without a
+         * deadline follow those with one in the order they were submitted.
+         * It may be bounded or unbounded but cannot be combined with work
+         * stealing.</li>
+         * </ul>
+         */
+        enum squid_executor_backend backend;
+    } queue;
+    struct {
+        /**
+         * @brief Threads serve the priority lanes strictly in order, except
+         * that every aging-th task a thread takes comes from one of the
+         * lower lanes, taking turns, so that they cannot be starved. Zero
+         * for strict priority.
+         */
+        uintmax_t aging;
+    } priority;
+    struct {
+        /**
+         * @brief Cancel tasks whose deadline has passed by the time a thread
+         * gets to them instead of running them.
+         * <p>Retrieving the result of such a task fails with
+         * {@link SQUID_FUTURE_ERROR_DEADLINE_HAS_PASSED}.</p>
+         */
+        bool is_enforced;
+    } deadline;
+    struct {
+        /**
+         * @brief CPUs that threads are restricted to, CPU n being bit
+         * n % 64 of word n / 64. All bits clear for no restriction.
+         */
+        uint64_t cpus[SQUID_EXECUTOR_CPUS / 64];
+        /**
+         * @brief Spread threads evenly over the NUMA nodes and keep each
+         * on the CPUs of its node, less those left out of cpus.
+         */
+        bool is_numa_aware;
+        /**
+         * @brief Give each NUMA node a queue of its own for normal priority
+         * tasks. Tasks go to the queue of the node they are submitted from
+         * and threads serve the queue of their own node before those of
+         * the others.
+         * <p>Requires NUMA awareness. The queue capacity applies to each
+         * node's queue.</p>
+         */
+        bool is_queue_per_node;
+    } affinity;
+};
+
+/**
+ * @brief Initialize executor options with default values.
+ * <p>Defaults are no minimum, no prestarted threads, an unbounded
+ * maximum, work stealing disabled, an unbounded queue, lower priority
+ * lanes served every 32nd task, deadlines that are not enforced and
+ * threads that are free to run on any CPU, with the default stack size, no
+ * name and no hooks which matches the behaviour of
+ * {@link squid_executor_of}.</p>
+ * @param [in] object options to be initialized.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OPTIONS_IS_NULL if object is <i>NULL</i>.
+ */
+bool squid_executor_options_init(struct squid_executor_options *object);
+
 /**
  * @brief Retrieve global executor reference.
  * @param [out] out receive global executor reference.
@@ -37,8 +230,35 @@ bool squid_executor_reference(struct triggerfish_strong **out);
  */
 bool squid_executor_of(struct triggerfish_strong **out);
 
+/**
+ * @brief Create executor instance with options.
+ * @param [in] options to configure the executor with.
+ * @param [out] out receive newly created executor.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OPTIONS_IS_NULL if options is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID if maximum threads is
+ * zero, if either minimum or prestart threads exceed maximum threads, if
+ * the stack size is below the system's minimum, if work stealing is
+ * enabled with a zero capacity or an unbounded maximum, if the queue
+ * capacity, rejection or backend is out of range, if the ring backend is
+ * chosen for an unbounded queue, if a queue per node is asked for without
+ * NUMA awareness or if none of the CPUs in the affinity are known to the
+ * system.
+ * @throws SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to create instance.
+ * @throws SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED if we failed to create
+ * the prestart threads.
+ * @note <b>out</b> must be released once done with it.
+ */
+bool squid_executor_of_with_options(
+        const struct squid_executor_options *options,
+        struct triggerfish_strong **out);
+
 /**
  * @brief Shutdown executor.
+ * <p>Scheduled tasks that have yet to come due are cancelled. Returns once
+ * all of the executor's threads have exited.</p>
  * @param [in] object instance to be shutdown.
  * @return On success true, otherwise false if an error has occurred.
  * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
@@ -47,6 +267,43 @@ bool squid_executor_of(struct triggerfish_strong **out);
  */
 bool squid_executor_shutdown(struct squid_executor *object);
 
+/**
+ * @brief Shutdown executor without running the tasks that are still queued.
+ * <p>Pending tasks are detached from the executor in one go. Their futures
+ * are cancelled and fire-and-forget tasks are dropped. Tasks that are
+ * already running find is_cancelled returning true and are expected to wrap
+ * up. Scheduled tasks that have yet to come due are cancelled as well.
+ * Returns once all of the executor's threads have exited.</p>
+ * @param [in] object instance to be shutdown.
+ * @param [out] out receive count of pending and scheduled tasks that were
+ * drained.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN if executor is already
+ * in the process of shutting down.
+ */
+bool squid_executor_shutdown_now(struct squid_executor *object,
+                                 uintmax_t *out);
+
+/**
+ * @brief Wait for all of the executor's threads to exit.
+ * <p>Threads only exit once the executor has been shutdown, or when they
+ * have been idle for long enough and there are more than the minimum
+ * number of threads.</p>
+ * @param [in] object executor instance.
+ * @param [in] deadline optional absolute time measured against
+ * <i>CLOCK_MONOTONIC</i>, if <i>NULL</i> we wait without a time limit.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_DEADLINE_IS_INVALID if deadline has a
+ * negative number of seconds or nanoseconds outside of [0, 999999999].
+ * @throws SQUID_EXECUTOR_ERROR_TIMED_OUT if there were still threads left
+ * by the time deadline passed.
+ */
+bool squid_executor_await_termination(struct squid_executor *object,
+                                      const struct timespec *deadline);
+
 /**
  * @brief Check if executor will accept tasks.
  * @param [in] object executor instance.
@@ -81,11 +338,116 @@ bool squid_executor_count(const struct squid_executor *object,
 bool squid_executor_ready(const struct squid_executor *object,
                           uintmax_t *out);
 
+/**
+ * @brief Retrieve count of tasks waiting in a priority lane.
+ * <p>Tasks waiting in the deques of work stealing threads are not
+ * included. The count is approximate while tasks are being submitted or
+ * taken.</p>
+ * @param [in] object executor instance.
+ * @param [in] priority of the lane.
+ * @param [out] out receive count of waiting tasks.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_PRIORITY_IS_INVALID if priority is out of
+ * range.
+ * @throws SQUID_EXECUTOR_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_executor_pending(const struct squid_executor *object,
+                            enum squid_executor_priority priority,
+                            uintmax_t *out);
+
+/**
+ * @brief Retrieve count of task queue nodes and records served from the pool.
+ * <p>Together with {@link squid_executor_pool_misses} this gives the hit
+ * rate of the pools that recycle task queue nodes and the task records of
+ * {@link squid_executor_execute}.</p>
+ * @param [in] object executor instance.
+ * @param [out] out receive count of pool hits.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_executor_pool_hits(const struct squid_executor *object,
+                              uintmax_t *out);
+
+/**
+ * @brief Retrieve count of task queue nodes and records that had to be
+ * allocated.
+ * @param [in] object executor instance.
+ * @param [out] out receive count of pool misses.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_executor_pool_misses(const struct squid_executor *object,
+                                uintmax_t *out);
+
+#define SQUID_EXECUTOR_STATS_BUCKETS                        40
+
+/**
+ * @brief Activity of an executor since it was created.
+ * <p>Bucket i of a histogram counts durations of at least 2<sup>i</sup>
+ * but less than 2<sup>i+1</sup> nanoseconds. The first bucket also counts
+ * shorter ones and the last bucket all that are longer.</p>
+ */
+struct squid_executor_stats {
+    /**
+     * @brief Tasks handed to the queues, scheduled tasks count each time
+     * they come due.
+     */
+    uintmax_t submitted;
+    /**
+     * @brief Tasks that have been run.
+     */
+    uintmax_t completed;
+    /**
+     * @brief Tasks that were taken off the queues without being run.
+     */
+    uintmax_t cancelled;
+    /**
+     * @brief Tasks currently waiting in the queues and deques.
+     */
+    uintmax_t pending;
+    struct {
+        uintmax_t created;
+        uintmax_t retired;
+    } threads;
+    struct {
+        /**
+         * @brief Time from being handed to the queues until being run.
+         */
+        uintmax_t wait[SQUID_EXECUTOR_STATS_BUCKETS];
+        /**
+         * @brief Time spent running.
+         */
+        uintmax_t run[SQUID_EXECUTOR_STATS_BUCKETS];
+    } histogram;
+};
+
+/**
+ * @brief Retrieve activity counters of executor.
+ * <p>Each of the executor's threads keeps counters of its own which are
+ * summed up here, so the result is approximate while tasks are being
+ * submitted or run.</p>
+ * @param [in] object executor instance.
+ * @param [out] out receive counters.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_executor_stats(const struct squid_executor *object,
+                          struct squid_executor_stats *out);
+
 typedef void (*squid_function)(void *args,
                                bool (*is_cancelled)(void),
                                struct triggerfish_strong **out,
                                uintmax_t *error);
 
+struct squid_executor_task {
+    squid_function function;
+    void *args;
+};
+
 /**
  * @brief Submit task for execution.
  * @param [in] object executor instance.
@@ -100,6 +462,10 @@ typedef void (*squid_function)(void *args,
  * shutting down and therefore not accepting anymore requests.
  * @throws SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED if we failed to create
  * a thread.
+ * @throws SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL if the queue is bounded and
+ * there is no room for the task.
+ * @throws SQUID_EXECUTOR_ERROR_TIMED_OUT if the queue is bounded and we gave
+ * up waiting for room for the task.
  * @note <b>out</b> must be released once done with it.
  */
 bool squid_executor_submit(struct squid_executor *object,
@@ -107,4 +473,235 @@ bool squid_executor_submit(struct squid_executor *object,
                            void *args,
                            struct triggerfish_strong **out);
 
+/**
+ * @brief Submit task for execution in a priority lane.
+ * <p>{@link squid_executor_submit} submits with normal priority. Tasks of
+ * a higher priority are taken before those of a lower one, see the aging
+ * in the executor's options. Only normal priority tasks are placed in the
+ * deques of work stealing threads.</p>
+ * @param [in] object executor instance.
+ * @param [in] priority of the task.
+ * @param [in] function of the task to run.
+ * @param [in] args to pass on to the executing function.
+ * @param [out] out receive future strong reference.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_PRIORITY_IS_INVALID if priority is out of
+ * range.
+ * @throws SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL if function is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN if executor is busy
+ * shutting down and therefore not accepting anymore requests.
+ * @throws SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED if we failed to create
+ * a thread.
+ * @throws SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL if the queue is bounded and
+ * there is no room for the task.
+ * @throws SQUID_EXECUTOR_ERROR_TIMED_OUT if the queue is bounded and we gave
+ * up waiting for room for the task.
+ * @note <b>out</b> must be released once done with it.
+ */
+bool squid_executor_submit_with_priority(
+        struct squid_executor *object,
+        enum squid_executor_priority priority,
+        squid_function function,
+        void *args,
+        struct triggerfish_strong **out);
+
+/**
+ * @brief Submit task for execution by a deadline.
+ * <p>The task is queued with normal priority. With the DEADLINE backend
+ * threads take the task with the earliest deadline first, other backends
+ * keep to the order of submission. If deadlines are enforced the task is
+ * cancelled instead of run once its deadline has passed.</p>
+ * @param [in] object executor instance.
+ * @param [in] deadline absolute time measured against
+ * <i>CLOCK_MONOTONIC</i>.
+ * @param [in] function of the task to run.
+ * @param [in] args to pass on to the executing function.
+ * @param [out] out receive future strong reference.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_DEADLINE_IS_NULL if deadline is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL if function is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_DEADLINE_IS_INVALID if deadline has a
+ * negative number of seconds or nanoseconds outside of [0, 999999999].
+ * @throws SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN if executor is busy
+ * shutting down and therefore not accepting anymore requests.
+ * @throws SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED if we failed to create
+ * a thread.
+ * @throws SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL if the queue is bounded and
+ * there is no room for the task.
+ * @throws SQUID_EXECUTOR_ERROR_TIMED_OUT if the queue is bounded and we gave
+ * up waiting for room for the task.
+ * @throws SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to queue the task.
+ * @note <b>out</b> must be released once done with it.
+ */
+bool squid_executor_submit_with_deadline(struct squid_executor *object,
+                                         const struct timespec *deadline,
+                                         squid_function function,
+                                         void *args,
+                                         struct triggerfish_strong **out);
+
+/**
+ * @brief Submit task for execution once delay has passed.
+ * <p>The task is kept on a hierarchical timer wheel, which takes constant
+ * time to arm and to cancel, until it comes due. It is then queued with
+ * normal priority by the executor's timer thread. That thread is started
+ * along with the first scheduled task and exits once there are none
+ * left. Cancelling the future takes the task off the wheel right away.</p>
+ * <p>So as not to hold up the other timers, the timer thread never waits
+ * for room in a bounded queue nor runs a task itself. A task that comes due
+ * while the queue is full is cancelled instead, unless the rejection is
+ * DISCARD_OLDEST.</p>
+ * @param [in] object executor instance.
+ * @param [in] delay in milliseconds, at a resolution of one millisecond.
+ * @param [in] function of the task to run.
+ * @param [in] args to pass on to the executing function.
+ * @param [out] out receive future strong reference.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL if function is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN if executor is busy
+ * shutting down and therefore not accepting anymore requests.
+ * @throws SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED if we failed to create
+ * the timer thread.
+ * @throws SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to create the future.
+ * @note <b>out</b> must be released once done with it.
+ */
+bool squid_executor_schedule(struct squid_executor *object,
+                             uintmax_t delay,
+                             squid_function function,
+                             void *args,
+                             struct triggerfish_strong **out);
+
+/**
+ * @brief Submit task to run once delay has passed and every period after.
+ * <p>Runs are due at fixed points in time, a run that starts late does not
+ * push back the ones after it and a run that overlaps with when the next
+ * one is due is followed right away. The future only completes once
+ * function reports an error, otherwise the task repeats until it is
+ * cancelled or the executor is shutdown. Each run releases the result of
+ * the one before. See {@link squid_executor_schedule}.</p>
+ * @param [in] object executor instance.
+ * @param [in] delay in milliseconds until the first run.
+ * @param [in] period in milliseconds between the start of two runs.
+ * @param [in] function of the task to run.
+ * @param [in] args to pass on to the executing function.
+ * @param [out] out receive future strong reference.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_PERIOD_IS_ZERO if period is zero.
+ * @throws SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL if function is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN if executor is busy
+ * shutting down and therefore not accepting anymore requests.
+ * @throws SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED if we failed to create
+ * the timer thread.
+ * @throws SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to create the future.
+ * @note <b>out</b> must be released once done with it.
+ */
+bool squid_executor_schedule_at_fixed_rate(struct squid_executor *object,
+                                           uintmax_t delay,
+                                           uintmax_t period,
+                                           squid_function function,
+                                           void *args,
+                                           struct triggerfish_strong **out);
+
+/**
+ * @brief Execute task without creating a future for it.
+ * <p>The task is queued as a compact record taken from a pool, so there is
+ * no future to allocate or reference count. Should <b>out</b> be set by
+ * function it is released once function returns, <b>error</b> is
+ * ignored. Tasks still queued when the executor is shutdown are dropped
+ * without being run.</p>
+ * @param [in] object executor instance.
+ * @param [in] function of the task to run.
+ * @param [in] args to pass on to the executing function.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL if function is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN if executor is busy
+ * shutting down and therefore not accepting anymore requests.
+ * @throws SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED if we failed to create
+ * a thread.
+ * @throws SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL if the queue is bounded and
+ * there is no room for the task.
+ * @throws SQUID_EXECUTOR_ERROR_TIMED_OUT if the queue is bounded and we gave
+ * up waiting for room for the task.
+ * @throws SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to queue the task.
+ */
+bool squid_executor_execute(struct squid_executor *object,
+                            squid_function function,
+                            void *args);
+
+/**
+ * @brief Submit a batch of tasks for execution.
+ * <p>The executor reference is upgraded once for the whole batch, the
+ * tasks are linked into the queue with a single splice and no more idle
+ * threads are woken up than there are tasks. Either all tasks are
+ * submitted or none are.</p>
+ * @param [in] object executor instance.
+ * @param [in] tasks array of tasks to run.
+ * @param [in] count of tasks.
+ * @param [out] out array of <b>count</b> that receives the future strong
+ * references in the same order as tasks.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_TASKS_IS_NULL if tasks is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_COUNT_IS_ZERO if count is zero.
+ * @throws SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL if the function of any task
+ * is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN if executor is busy
+ * shutting down and therefore not accepting anymore requests.
+ * @throws SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED if we failed to create
+ * a thread.
+ * @throws SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL if the queue is bounded and
+ * there is no room for all tasks.
+ * @throws SQUID_EXECUTOR_ERROR_TIMED_OUT if the queue is bounded and we gave
+ * up waiting for room for all tasks.
+ * @throws SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to submit the tasks.
+ * @note each of the futures in <b>out</b> must be released once done with
+ * it.
+ */
+bool squid_executor_submit_all(struct squid_executor *object,
+                               const struct squid_executor_task *tasks,
+                               uintmax_t count,
+                               struct triggerfish_strong **out);
+
+/**
+ * @brief Execute a batch of tasks without creating futures for them.
+ * <p>Batch counterpart of {@link squid_executor_execute}. Either all tasks
+ * are queued or none are.</p>
+ * @param [in] object executor instance.
+ * @param [in] tasks array of tasks to run.
+ * @param [in] count of tasks.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_TASKS_IS_NULL if tasks is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_COUNT_IS_ZERO if count is zero.
+ * @throws SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL if the function of any task
+ * is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN if executor is busy
+ * shutting down and therefore not accepting anymore requests.
+ * @throws SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED if we failed to create
+ * a thread.
+ * @throws SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL if the queue is bounded and
+ * there is no room for all tasks.
+ * @throws SQUID_EXECUTOR_ERROR_TIMED_OUT if the queue is bounded and we gave
+ * up waiting for room for all tasks.
+ * @throws SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to queue the tasks.
+ */
+bool squid_executor_execute_all(struct squid_executor *object,
+                                const struct squid_executor_task *tasks,
+                                uintmax_t count);
+
 #endif /* _SQUID_EXECUTOR_H_ */
@@ -4,13 +4,26 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <time.h>
+#include <squid/executor.h>
 
 #define SQUID_FUTURE_ERROR_OBJECT_IS_NULL                   1
 #define SQUID_FUTURE_ERROR_OUT_IS_NULL                      2
 #define SQUID_FUTURE_ERROR_FUTURE_IS_CANCELLED              3
 #define SQUID_FUTURE_ERROR_FUTURE_IS_DONE                   4
+#define SQUID_FUTURE_ERROR_FUNCTION_IS_NULL                 5
+#define SQUID_FUTURE_ERROR_MEMORY_ALLOCATION_FAILED         6
+#define SQUID_FUTURE_ERROR_EXECUTOR_IS_BUSY_SHUTTING_DOWN   7
+#define SQUID_FUTURE_ERROR_FUTURES_IS_NULL                  8
+#define SQUID_FUTURE_ERROR_COUNT_IS_ZERO                    9
+#define SQUID_FUTURE_ERROR_DEADLINE_IS_NULL                 10
+#define SQUID_FUTURE_ERROR_TIMED_OUT                        11
+#define SQUID_FUTURE_ERROR_FUTURE_IS_NOT_READY              12
+#define SQUID_FUTURE_ERROR_DEADLINE_HAS_PASSED              13
+#define SQUID_FUTURE_ERROR_DEADLINE_IS_INVALID              14
 
 struct triggerfish_strong;
+struct squid_executor;
 struct squid_future;
 
 enum squid_future_status {
@@ -33,6 +46,8 @@ bool squid_future_status(const struct squid_future *object,
 
 /**
  * @brief Cancel future's task.
+ * <p>A scheduled task that has yet to come due is taken off its executor's
+ * timer wheel right away.</p>
  * @param [in] object future instance.
  * @param [out] out receive status of future before it was cancelled.
  * @return On success true, otherwise false if an error has occurred.
@@ -44,6 +59,10 @@ bool squid_future_cancel(struct squid_future *object,
 
 /**
  * @brief Retrieve result.
+ * <p>When called from one of the threads of future's executor, a future
+ * that is still queued is run right away by the calling thread. Otherwise
+ * the calling thread runs other queued tasks of the executor while it
+ * waits, so it must not hold on to anything those tasks may need.</p>
  * @param [in] object future instance.
  * @param [out] out receive result.
  * @param [out] error optionally receive error code.
@@ -51,11 +70,133 @@ bool squid_future_cancel(struct squid_future *object,
  * @throws SQUID_FUTURE_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
  * @throws SQUID_FUTURE_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
  * @throws SQUID_FUTURE_ERROR_FUTURE_IS_CANCELLED if future was cancelled.
+ * @throws SQUID_FUTURE_ERROR_DEADLINE_HAS_PASSED if future was cancelled
+ * because its deadline had passed before it could run.
  * @note <b>out</b> must be released once done with it.
  */
 bool squid_future_get(struct squid_future *object,
                       struct triggerfish_strong **out,
                       uintmax_t *error);
 
+/**
+ * @brief Retrieve result, waiting no longer than until deadline.
+ * <p>Executor threads help out while waiting like they do in
+ * {@link squid_future_get}, a task that is run may keep them past the
+ * deadline.</p>
+ * @param [in] object future instance.
+ * @param [in] deadline absolute time measured against
+ * <i>CLOCK_MONOTONIC</i>.
+ * @param [out] out receive result.
+ * @param [out] error optionally receive error code.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_FUTURE_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_FUTURE_ERROR_DEADLINE_IS_NULL if deadline is <i>NULL</i>.
+ * @throws SQUID_FUTURE_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_FUTURE_ERROR_DEADLINE_IS_INVALID if deadline has a negative
+ * number of seconds or nanoseconds outside of [0, 999999999].
+ * @throws SQUID_FUTURE_ERROR_TIMED_OUT if future was neither done nor
+ * cancelled by the time deadline passed.
+ * @throws SQUID_FUTURE_ERROR_FUTURE_IS_CANCELLED if future was cancelled.
+ * @throws SQUID_FUTURE_ERROR_DEADLINE_HAS_PASSED if future was cancelled
+ * because its deadline had passed before it could run.
+ * @note <b>out</b> must be released once done with it.
+ */
+bool squid_future_get_until(struct squid_future *object,
+                            const struct timespec *deadline,
+                            struct triggerfish_strong **out,
+                            uintmax_t *error);
+
+/**
+ * @brief Retrieve result without waiting.
+ * @param [in] object future instance.
+ * @param [out] out receive result.
+ * @param [out] error optionally receive error code.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_FUTURE_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_FUTURE_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_FUTURE_ERROR_FUTURE_IS_NOT_READY if future is neither done
+ * nor cancelled yet.
+ * @throws SQUID_FUTURE_ERROR_FUTURE_IS_CANCELLED if future was cancelled.
+ * @throws SQUID_FUTURE_ERROR_DEADLINE_HAS_PASSED if future was cancelled
+ * because its deadline had passed before it could run.
+ * @note <b>out</b> must be released once done with it.
+ */
+bool squid_future_try_get(struct squid_future *object,
+                          struct triggerfish_strong **out,
+                          uintmax_t *error);
+
+/**
+ * @brief Continue with another task once future has completed.
+ * <p>Instead of blocking a thread in {@link squid_future_get} the
+ * continuation is scheduled when future is done. Its function receives
+ * the completed future as <b>args</b> so that the result can be retrieved
+ * without blocking. If executor is <i>NULL</i> function is run inline by
+ * the thread completing future, which is only meant for cheap
+ * continuations. If future is cancelled its continuations are cancelled
+ * as well.</p>
+ * @param [in] object future instance.
+ * @param [in] executor to run continuation on or <i>NULL</i> to run it
+ * inline.
+ * @param [in] function of the continuation.
+ * @param [out] out receive future strong reference of continuation.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_FUTURE_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_FUTURE_ERROR_FUNCTION_IS_NULL if function is <i>NULL</i>.
+ * @throws SQUID_FUTURE_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_FUTURE_ERROR_EXECUTOR_IS_BUSY_SHUTTING_DOWN if executor is
+ * busy shutting down and therefore not accepting anymore requests.
+ * @throws SQUID_FUTURE_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to create the continuation.
+ * @note <b>out</b> must be released once done with it.
+ */
+bool squid_future_then(struct squid_future *object,
+                       struct squid_executor *executor,
+                       squid_function function,
+                       struct triggerfish_strong **out);
+
+/**
+ * @brief Create future that completes once all futures have completed.
+ * <p>Each of the futures counts down a single counter as it is either done
+ * or cancelled and whoever waits on the returned future is woken up once,
+ * when the last of them completes. The outcome of each of the futures is
+ * to be retrieved from the futures themselves.</p>
+ * @param [in] futures array of futures to wait for.
+ * @param [in] count of futures.
+ * @param [out] out receive future strong reference of combinator.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_FUTURE_ERROR_FUTURES_IS_NULL if futures or any of its
+ * items is <i>NULL</i>.
+ * @throws SQUID_FUTURE_ERROR_COUNT_IS_ZERO if count is zero.
+ * @throws SQUID_FUTURE_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_FUTURE_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to create the combinator.
+ * @note <b>out</b> must be released once done with it.
+ */
+bool squid_future_when_all(struct squid_future *const *futures,
+                           uintmax_t count,
+                           struct triggerfish_strong **out);
+
+/**
+ * @brief Create future that completes once any of the futures completes.
+ * <p>The index of the first future to be either done or cancelled is
+ * reported as the <b>error</b> of the returned future.</p>
+ * @param [in] futures array of futures to wait for.
+ * @param [in] count of futures.
+ * @param [in] is_cancelling if true the other futures are cancelled once
+ * the first one has completed.
+ * @param [out] out receive future strong reference of combinator.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_FUTURE_ERROR_FUTURES_IS_NULL if futures or any of its
+ * items is <i>NULL</i>.
+ * @throws SQUID_FUTURE_ERROR_COUNT_IS_ZERO if count is zero.
+ * @throws SQUID_FUTURE_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_FUTURE_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to create the combinator.
+ * @note <b>out</b> must be released once done with it.
+ */
+bool squid_future_when_any(struct squid_future *const *futures,
+                           uintmax_t count,
+                           bool is_cancelling,
+                           struct triggerfish_strong **out);
 
 #endif /* _SQUID_FUTURE_H_ */
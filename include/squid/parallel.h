@@ -0,0 +1,115 @@
+#ifndef _SQUID_PARALLEL_H_
+#define _SQUID_PARALLEL_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <squid/executor.h>
+
+#define SQUID_PARALLEL_ERROR_EXECUTOR_IS_NULL               1
+#define SQUID_PARALLEL_ERROR_FUNCTION_IS_NULL               2
+#define SQUID_PARALLEL_ERROR_RANGE_IS_INVALID               3
+#define SQUID_PARALLEL_ERROR_MEMORY_ALLOCATION_FAILED       4
+#define SQUID_PARALLEL_ERROR_REDUCTION_IS_NULL              5
+#define SQUID_PARALLEL_ERROR_REDUCTION_IS_INVALID           6
+#define SQUID_PARALLEL_ERROR_OUT_IS_NULL                    7
+
+struct squid_executor;
+
+typedef void (*squid_parallel_function)(uintmax_t begin,
+                                        uintmax_t end,
+                                        void *context);
+
+struct squid_parallel_reduction {
+    /**
+     * @brief Size in bytes of a partial result.
+     */
+    size_t size;
+    /**
+     * @brief Partial result of an empty range, each partial result starts
+     * out as a copy of it.
+     */
+    const void *identity;
+    /**
+     * @brief Fold the iterations from begin up to but excluding end into
+     * partial.
+     */
+    void (*accumulate)(uintmax_t begin,
+                       uintmax_t end,
+                       void *partial,
+                       void *context);
+    /**
+     * @brief Fold other into partial.
+     * <p>Must be associative, partial results are combined in no particular
+     * grouping.</p>
+     */
+    void (*combine)(void *partial, const void *other, void *context);
+};
+
+/**
+ * @brief Run function over a range of iterations in parallel.
+ * <p>The range is handed out to the calling thread and to helper tasks on
+ * the executor, one less than there are processors or executor threads,
+ * whichever is fewer. Whoever runs out of work takes over half of what is
+ * left of a busy participant's range, so ranges are split in two over and
+ * over only as long as someone is idle. No future is created for any of
+ * the sub-ranges.</p>
+ * <p>The calling thread takes part in the work and returns once every
+ * iteration is done. If the executor has no room for helpers, or is
+ * shutting down, the calling thread does the work on its own.</p>
+ * @param [in] executor instance whose threads help out.
+ * @param [in] begin first iteration.
+ * @param [in] end iteration past the last one.
+ * @param [in] grain largest count of iterations that function is called
+ * with at once, ranges no larger than it are not split any further. Zero
+ * to derive one from the size of the range and the count of participants.
+ * @param [in] function called with sub-ranges until the range is covered.
+ * @param [in] context to be passed to the function.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_PARALLEL_ERROR_EXECUTOR_IS_NULL if executor is <i>NULL</i>.
+ * @throws SQUID_PARALLEL_ERROR_FUNCTION_IS_NULL if function is <i>NULL</i>.
+ * @throws SQUID_PARALLEL_ERROR_RANGE_IS_INVALID if begin is past end.
+ * @throws SQUID_PARALLEL_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to set up the work.
+ */
+bool squid_parallel_for(struct squid_executor *executor,
+                        uintmax_t begin,
+                        uintmax_t end,
+                        uintmax_t grain,
+                        squid_parallel_function function,
+                        void *context);
+
+/**
+ * @brief Reduce a range of iterations to a single result in parallel.
+ * <p>Work is shared out like {@link squid_parallel_for}. Each participant
+ * accumulates into a partial result of its own, which are then combined
+ * on the calling thread.</p>
+ * @param [in] executor instance whose threads help out.
+ * @param [in] begin first iteration.
+ * @param [in] end iteration past the last one.
+ * @param [in] grain largest count of iterations that are accumulated at
+ * once, or zero to derive one.
+ * @param [in] reduction how partial results are computed and combined.
+ * @param [in] context to be passed to the reduction functions.
+ * @param [out] out receive result, must have room for
+ * <b>reduction->size</b> bytes.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_PARALLEL_ERROR_EXECUTOR_IS_NULL if executor is <i>NULL</i>.
+ * @throws SQUID_PARALLEL_ERROR_REDUCTION_IS_NULL if reduction is
+ * <i>NULL</i>.
+ * @throws SQUID_PARALLEL_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_PARALLEL_ERROR_REDUCTION_IS_INVALID if the size of reduction
+ * is zero or any of its members are <i>NULL</i>.
+ * @throws SQUID_PARALLEL_ERROR_RANGE_IS_INVALID if begin is past end.
+ * @throws SQUID_PARALLEL_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to set up the work.
+ */
+bool squid_parallel_reduce(struct squid_executor *executor,
+                           uintmax_t begin,
+                           uintmax_t end,
+                           uintmax_t grain,
+                           const struct squid_parallel_reduction *reduction,
+                           void *context,
+                           void *out);
+
+#endif /* _SQUID_PARALLEL_H_ */
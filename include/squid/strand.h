@@ -0,0 +1,77 @@
+#ifndef _SQUID_STRAND_H_
+#define _SQUID_STRAND_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <squid/executor.h>
+
+#define SQUID_STRAND_ERROR_OUT_IS_NULL                      1
+#define SQUID_STRAND_ERROR_OBJECT_IS_NULL                   2
+#define SQUID_STRAND_ERROR_MEMORY_ALLOCATION_FAILED         3
+#define SQUID_STRAND_ERROR_IS_BUSY_SHUTTING_DOWN            4
+#define SQUID_STRAND_ERROR_FUNCTION_IS_NULL                 5
+#define SQUID_STRAND_ERROR_EXECUTOR_IS_NULL                 6
+
+struct triggerfish_strong;
+struct squid_executor;
+struct squid_strand;
+
+/**
+ * @brief Create strand instance.
+ * <p>A strand is a serial executor layered on top of an executor. Tasks
+ * submitted to it run one at a time, in the order they were submitted, on
+ * the threads of the underlying executor. A strand holds no thread of its
+ * own and takes up none of the executor's threads while it has nothing to
+ * run.</p>
+ * @param [in] executor which runs the tasks of the strand.
+ * @param [out] out receive newly created strand.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_STRAND_ERROR_EXECUTOR_IS_NULL if executor is <i>NULL</i>.
+ * @throws SQUID_STRAND_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_STRAND_ERROR_IS_BUSY_SHUTTING_DOWN if executor is shutting
+ * down.
+ * @throws SQUID_STRAND_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to create instance.
+ * @note <b>out</b> must be released once done with it.
+ */
+bool squid_strand_of(struct squid_executor *executor,
+                     struct triggerfish_strong **out);
+
+/**
+ * @brief Submit task for execution after those submitted before it.
+ * <p>Each task sees the effects of the ones that ran before it on the
+ * strand, so state that is only touched from within the strand's tasks
+ * needs no lock of its own. Tasks are cancelled rather than run once the
+ * underlying executor is shutting down, or if it rejects them.</p>
+ * @param [in] object strand instance.
+ * @param [in] function task to be executed.
+ * @param [in] args arguments to be passed to the function.
+ * @param [out] out receive future of the task.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_STRAND_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_STRAND_ERROR_FUNCTION_IS_NULL if function is <i>NULL</i>.
+ * @throws SQUID_STRAND_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_STRAND_ERROR_IS_BUSY_SHUTTING_DOWN if the underlying executor
+ * is shutting down.
+ * @throws SQUID_STRAND_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to submit task.
+ * @note <b>out</b> must be released once done with it.
+ */
+bool squid_strand_submit(struct squid_strand *object,
+                         squid_function function,
+                         void *args,
+                         struct triggerfish_strong **out);
+
+/**
+ * @brief Retrieve count of tasks submitted that have yet to finish.
+ * <p>This includes the task currently running, if any.</p>
+ * @param [in] object strand instance.
+ * @param [out] out receive count of tasks.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_STRAND_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_STRAND_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_strand_pending(const struct squid_strand *object, uintmax_t *out);
+
+#endif /* _SQUID_STRAND_H_ */
@@ -0,0 +1,38 @@
+#ifndef _SQUID_TRACE_H_
+#define _SQUID_TRACE_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SQUID_TRACE_ERROR_PATH_IS_NULL                      1
+#define SQUID_TRACE_ERROR_IS_DISABLED                       2
+#define SQUID_TRACE_ERROR_FILE_OPEN_FAILED                  3
+#define SQUID_TRACE_ERROR_FILE_WRITE_FAILED                 4
+
+/**
+ * @brief Write the task events recorded so far as a Chrome trace.
+ * <p>Events are only recorded if the library was built with
+ * <i>SQUID_TRACE</i> defined, otherwise recording them costs nothing.
+ * Each thread records the tasks it queues and the tasks it runs into a
+ * buffer of its own, dropping events once that buffer is full. Dumping
+ * empties the buffers so that a later dump picks up where this one left
+ * off.</p>
+ * <p>The file is in the JSON format of the Chrome trace viewer, which
+ * Perfetto reads as well. A slice on the thread that ran a task spans from
+ * its start until it finished and names the task's function. Its arguments
+ * tell how long the task waited in the queue, and an arrow leads to it from
+ * the thread that queued it.</p>
+ * @param [in] path of the file to be written, it is replaced if it exists.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_TRACE_ERROR_PATH_IS_NULL if path is <i>NULL</i>.
+ * @throws SQUID_TRACE_ERROR_IS_DISABLED if the library was built without
+ * tracing.
+ * @throws SQUID_TRACE_ERROR_FILE_OPEN_FAILED if path could not be opened
+ * for writing.
+ * @throws SQUID_TRACE_ERROR_FILE_WRITE_FAILED if writing to the file
+ * failed, the events that were taken out of the buffers are lost.
+ */
+bool squid_trace_dump(const char *path);
+
+#endif /* _SQUID_TRACE_H_ */
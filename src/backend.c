@@ -0,0 +1,337 @@
+#include <assert.h>
+#include <errno.h>
+#include <seagrass.h>
+#include <squid.h>
+
+#include "private/backend.h"
+#include "private/executer.h"
+
+#ifdef TEST
+#include <test/cmocka.h>
+#endif
+
+/* reserve room for count items before they become visible */
+static bool reserve(struct squid_executor *const object,
+                    struct squid_executor_lane *const lane,
+                    const uintmax_t count) {
+    assert(object);
+    assert(lane);
+    const uintmax_t capacity = object->queue.capacity;
+    if (!capacity) {
+        atomic_fetch_add(&lane->count, count);
+        return true;
+    }
+    uintmax_t used = atomic_load(&lane->count);
+    do {
+        if (count > capacity || used > capacity - count) {
+            squid_error = SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL;
+            return false;
+        }
+    } while (!atomic_compare_exchange_weak(&lane->count, &used,
+                                           count + used));
+    return true;
+}
+
+static bool linked_init(struct squid_executor *const object,
+                        struct squid_executor_lane *const lane) {
+    assert(object);
+    assert(lane);
+    if (!squid_queue_init(&lane->linked)) {
+        seagrass_required_true(SQUID_QUEUE_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    object->queue.capacity = object->options.queue.capacity;
+    return true;
+}
+
+static void linked_invalidate(struct squid_executor *const object,
+                              struct squid_executor_lane *const lane) {
+    assert(object);
+    assert(lane);
+    seagrass_required_true(squid_queue_invalidate(&lane->linked));
+}
+
+static bool linked_add_all(struct squid_executor *const object,
+                           struct squid_executor_lane *const lane,
+                           void *const *const items,
+                           const uintmax_t count) {
+    assert(object);
+    assert(lane);
+    assert(items);
+    assert(count);
+    if (!reserve(object, lane, count)) {
+        return false;
+    }
+    if (!squid_queue_add_all(&lane->linked, items, count)) {
+        seagrass_required_true(SQUID_QUEUE_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        atomic_fetch_sub(&lane->count, count);
+        squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    return true;
+}
+
+static bool linked_remove(struct squid_executor *const object,
+                          struct squid_executor_lane *const lane,
+                          void **const out) {
+    assert(object);
+    assert(lane);
+    assert(out);
+    if (!squid_queue_remove(&lane->linked, out)) {
+        seagrass_required_true(SQUID_QUEUE_ERROR_QUEUE_IS_EMPTY
+                               == squid_error);
+        return false;
+    }
+    atomic_fetch_sub(&lane->count, 1);
+    return true;
+}
+
+static uintmax_t linked_drain(struct squid_executor *const object,
+                              struct squid_executor_lane *const lane,
+                              void (*const function)(void *, void *),
+                              void *const args) {
+    assert(object);
+    assert(lane);
+    assert(function);
+    uintmax_t count;
+    seagrass_required_true(squid_queue_drain(&lane->linked, function,
+                                             args, &count));
+    atomic_fetch_sub(&lane->count, count);
+    return count;
+}
+
+static bool linked_is_empty(const struct squid_executor *const object,
+                            const struct squid_executor_lane *const lane) {
+    assert(object);
+    assert(lane);
+    bool result;
+    seagrass_required_true(squid_queue_is_empty(&lane->linked, &result));
+    return result;
+}
+
+static uintmax_t linked_count(const struct squid_executor *const object,
+                              const struct squid_executor_lane *const lane) {
+    assert(object);
+    assert(lane);
+    /* room is reserved before the items are linked in, so the count may
+     * briefly run ahead of what can be removed */
+    return atomic_load(&lane->count);
+}
+
+const struct squid_backend squid_backend_linked = {
+        .init = linked_init,
+        .invalidate = linked_invalidate,
+        .add_all = linked_add_all,
+        .remove = linked_remove,
+        .drain = linked_drain,
+        .is_empty = linked_is_empty,
+        .count = linked_count
+};
+
+static bool ring_init(struct squid_executor *const object,
+                      struct squid_executor_lane *const lane) {
+    assert(object);
+    assert(lane);
+    if (!squid_ring_init(&lane->ring, object->options.queue.capacity)) {
+        seagrass_required_true(SQUID_RING_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    object->queue.capacity = 1 + lane->ring.mask;
+    return true;
+}
+
+static void ring_invalidate(struct squid_executor *const object,
+                            struct squid_executor_lane *const lane) {
+    assert(object);
+    assert(lane);
+    seagrass_required_true(squid_ring_invalidate(&lane->ring));
+}
+
+static bool ring_add_all(struct squid_executor *const object,
+                         struct squid_executor_lane *const lane,
+                         void *const *const items,
+                         const uintmax_t count) {
+    assert(object);
+    assert(lane);
+    assert(items);
+    assert(count);
+    if (!squid_ring_add_all(&lane->ring, items, count)) {
+        seagrass_required_true(SQUID_RING_ERROR_RING_IS_FULL == squid_error);
+        squid_error = SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL;
+        return false;
+    }
+    return true;
+}
+
+static bool ring_remove(struct squid_executor *const object,
+                        struct squid_executor_lane *const lane,
+                        void **const out) {
+    assert(object);
+    assert(lane);
+    assert(out);
+    if (!squid_ring_remove(&lane->ring, out)) {
+        seagrass_required_true(SQUID_RING_ERROR_RING_IS_EMPTY == squid_error);
+        return false;
+    }
+    return true;
+}
+
+static uintmax_t ring_drain(struct squid_executor *const object,
+                            struct squid_executor_lane *const lane,
+                            void (*const function)(void *, void *),
+                            void *const args) {
+    assert(object);
+    assert(lane);
+    assert(function);
+    uintmax_t count = 0;
+    void *item;
+    for (; ring_remove(object, lane, &item); count++) {
+        function(item, args);
+    }
+    return count;
+}
+
+static uintmax_t ring_count(const struct squid_executor *const object,
+                            const struct squid_executor_lane *const lane) {
+    assert(object);
+    assert(lane);
+    uintmax_t count;
+    seagrass_required_true(squid_ring_count(&lane->ring, &count));
+    return count;
+}
+
+static bool ring_is_empty(const struct squid_executor *const object,
+                          const struct squid_executor_lane *const lane) {
+    return !ring_count(object, lane);
+}
+
+const struct squid_backend squid_backend_ring = {
+        .init = ring_init,
+        .invalidate = ring_invalidate,
+        .add_all = ring_add_all,
+        .remove = ring_remove,
+        .drain = ring_drain,
+        .is_empty = ring_is_empty,
+        .count = ring_count
+};
+
+static bool deadline_init(struct squid_executor *const object,
+                          struct squid_executor_lane *const lane) {
+    assert(object);
+    assert(lane);
+    int error;
+    if ((error = pthread_mutex_init(&lane->ordered.mutex, NULL))) {
+        seagrass_required_true(ENOMEM == error || EAGAIN == error);
+        squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    seagrass_required_true(squid_heap_init(&lane->ordered.heap));
+    object->queue.capacity = object->options.queue.capacity;
+    return true;
+}
+
+static void deadline_invalidate(struct squid_executor *const object,
+                                struct squid_executor_lane *const lane) {
+    assert(object);
+    assert(lane);
+    seagrass_required_true(squid_heap_invalidate(&lane->ordered.heap));
+    seagrass_required_true(!pthread_mutex_destroy(&lane->ordered.mutex));
+}
+
+static bool deadline_add_all(struct squid_executor *const object,
+                             struct squid_executor_lane *const lane,
+                             void *const *const items,
+                             const uintmax_t count) {
+    assert(object);
+    assert(lane);
+    assert(items);
+    assert(count);
+    if (!reserve(object, lane, count)) {
+        return false;
+    }
+    seagrass_required_true(!pthread_mutex_lock(&lane->ordered.mutex));
+    const bool result = squid_heap_reserve(&lane->ordered.heap, count);
+    if (result) {
+        for (uintmax_t i = 0; i < count; i++) {
+            uint64_t deadline;
+            seagrass_required_true(squid_executor_deadline(items[i],
+                                                           &deadline));
+            seagrass_required_true(squid_heap_add(&lane->ordered.heap,
+                                                  deadline, items[i]));
+        }
+    }
+    seagrass_required_true(!pthread_mutex_unlock(&lane->ordered.mutex));
+    if (!result) {
+        seagrass_required_true(SQUID_HEAP_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        atomic_fetch_sub(&lane->count, count);
+        squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    return true;
+}
+
+static bool deadline_remove(struct squid_executor *const object,
+                            struct squid_executor_lane *const lane,
+                            void **const out) {
+    assert(object);
+    assert(lane);
+    assert(out);
+    /* spares idle threads the mutex */
+    if (!atomic_load(&lane->count)) {
+        return false;
+    }
+    seagrass_required_true(!pthread_mutex_lock(&lane->ordered.mutex));
+    const bool result = squid_heap_remove(&lane->ordered.heap, out);
+    seagrass_required_true(!pthread_mutex_unlock(&lane->ordered.mutex));
+    if (!result) {
+        seagrass_required_true(SQUID_HEAP_ERROR_HEAP_IS_EMPTY
+                               == squid_error);
+        return false;
+    }
+    atomic_fetch_sub(&lane->count, 1);
+    return true;
+}
+
+static uintmax_t deadline_drain(struct squid_executor *const object,
+                                struct squid_executor_lane *const lane,
+                                void (*const function)(void *, void *),
+                                void *const args) {
+    assert(object);
+    assert(lane);
+    assert(function);
+    uintmax_t count = 0;
+    void *item;
+    for (; deadline_remove(object, lane, &item); count++) {
+        function(item, args);
+    }
+    return count;
+}
+
+static uintmax_t deadline_count(const struct squid_executor *const object,
+                                const struct squid_executor_lane *const lane) {
+    assert(object);
+    assert(lane);
+    /* as with the linked queue room is reserved up front */
+    return atomic_load(&lane->count);
+}
+
+static bool deadline_is_empty(const struct squid_executor *const object,
+                              const struct squid_executor_lane *const lane) {
+    return !deadline_count(object, lane);
+}
+
+const struct squid_backend squid_backend_deadline = {
+        .init = deadline_init,
+        .invalidate = deadline_invalidate,
+        .add_all = deadline_add_all,
+        .remove = deadline_remove,
+        .drain = deadline_drain,
+        .is_empty = deadline_is_empty,
+        .count = deadline_count
+};
@@ -0,0 +1,143 @@
+#include <stdlib.h>
+#include <squid.h>
+
+#include "private/deque.h"
+
+#ifdef TEST
+#include <test/cmocka.h>
+#endif
+
+bool squid_deque_init(struct squid_deque *const object,
+                      const uintmax_t capacity) {
+    if (!object) {
+        squid_error = SQUID_DEQUE_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!capacity || capacity > (SIZE_MAX / 2) / sizeof(void *)) {
+        squid_error = SQUID_DEQUE_ERROR_CAPACITY_IS_INVALID;
+        return false;
+    }
+    uintmax_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    *object = (struct squid_deque) {0};
+    object->items = calloc(size, sizeof(*object->items));
+    if (!object->items) {
+        squid_error = SQUID_DEQUE_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    object->mask = size - 1;
+    return true;
+}
+
+bool squid_deque_invalidate(struct squid_deque *const object) {
+    if (!object) {
+        squid_error = SQUID_DEQUE_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    free(object->items);
+    *object = (struct squid_deque) {0};
+    return true;
+}
+
+bool squid_deque_push(struct squid_deque *const object, void *const item) {
+    if (!object) {
+        squid_error = SQUID_DEQUE_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    const intmax_t b = atomic_load_explicit(&object->bottom,
+                                            memory_order_relaxed);
+    const intmax_t t = atomic_load_explicit(&object->top,
+                                            memory_order_acquire);
+    if (b - t > (intmax_t) object->mask) {
+        squid_error = SQUID_DEQUE_ERROR_DEQUE_IS_FULL;
+        return false;
+    }
+    atomic_store_explicit(&object->items[b & object->mask], item,
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&object->bottom, 1 + b, memory_order_relaxed);
+    return true;
+}
+
+bool squid_deque_pop(struct squid_deque *const object, void **const out) {
+    if (!object) {
+        squid_error = SQUID_DEQUE_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_DEQUE_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    const intmax_t b = atomic_load_explicit(&object->bottom,
+                                            memory_order_relaxed) - 1;
+    atomic_store_explicit(&object->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    intmax_t t = atomic_load_explicit(&object->top, memory_order_relaxed);
+    if (t > b) {
+        atomic_store_explicit(&object->bottom, 1 + b, memory_order_relaxed);
+        squid_error = SQUID_DEQUE_ERROR_DEQUE_IS_EMPTY;
+        return false;
+    }
+    void *const item = atomic_load_explicit(&object->items[b & object->mask],
+                                            memory_order_relaxed);
+    if (t == b) {
+        /* last item, race against thieves for it */
+        const bool result = atomic_compare_exchange_strong_explicit(
+                &object->top, &t, 1 + t, memory_order_seq_cst,
+                memory_order_relaxed);
+        atomic_store_explicit(&object->bottom, 1 + b, memory_order_relaxed);
+        if (!result) {
+            squid_error = SQUID_DEQUE_ERROR_DEQUE_IS_EMPTY;
+            return false;
+        }
+    }
+    *out = item;
+    return true;
+}
+
+bool squid_deque_steal(struct squid_deque *const object, void **const out) {
+    if (!object) {
+        squid_error = SQUID_DEQUE_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_DEQUE_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    intmax_t t = atomic_load_explicit(&object->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    const intmax_t b = atomic_load_explicit(&object->bottom,
+                                            memory_order_acquire);
+    if (t >= b) {
+        squid_error = SQUID_DEQUE_ERROR_DEQUE_IS_EMPTY;
+        return false;
+    }
+    void *const item = atomic_load_explicit(&object->items[t & object->mask],
+                                            memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&object->top, &t, 1 + t,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed)) {
+        squid_error = SQUID_DEQUE_ERROR_DEQUE_IS_CONTENDED;
+        return false;
+    }
+    *out = item;
+    return true;
+}
+
+bool squid_deque_count(const struct squid_deque *const object,
+                       uintmax_t *const out) {
+    if (!object) {
+        squid_error = SQUID_DEQUE_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_DEQUE_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    const intmax_t t = atomic_load(&object->top);
+    const intmax_t b = atomic_load(&object->bottom);
+    *out = b > t ? b - t : 0;
+    return true;
+}
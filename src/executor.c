@@ -1,18 +1,35 @@
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
 #include <pthread.h>
 #include <assert.h>
 #include <time.h>
 #include <errno.h>
+#include <unistd.h>
 #include <seagrass.h>
 #include <squid.h>
 
 #include "private/executer.h"
 #include "private/future.h"
+#include "private/futex.h"
+#include "private/numa.h"
+#include "private/strand.h"
+#include "private/trace.h"
+
+#if defined(__linux__)
+#include <sys/prctl.h>
+#endif
 
 #ifdef TEST
 #include <test/cmocka.h>
 #endif
 
+#define SPINS                                               128
+
+_Static_assert(SQUID_EXECUTOR_CPUS == SQUID_NUMA_CPUS,
+               "affinity and NUMA CPU sets must be of the same size");
+
 static struct triggerfish_strong *executor_ref;
 static struct squid_executor *instance;
 static pthread_rwlock_t lock = PTHREAD_RWLOCK_INITIALIZER;
@@ -48,46 +65,445 @@ bool squid_executor_reference(struct triggerfish_strong **const out) {
     return result;
 }
 
-static void invalidate(struct squid_executor *const object) {
+/* fire-and-forget tasks are queued as their pool index with the low bit set */
+static inline bool is_record(const void *const item) {
+    return (uintptr_t) item & 1;
+}
+
+static inline void *record_item(const uint32_t index) {
+    return (void *) ((uintptr_t) index << 1 | 1);
+}
+
+static inline uint32_t record_index(const void *const item) {
+    return (uint32_t) ((uintptr_t) item >> 1);
+}
+
+/* milliseconds on the monotonic clock are the ticks of the timer wheel */
+static uint64_t ticks(void) {
+    struct timespec now;
+    seagrass_required_true(!clock_gettime(CLOCK_MONOTONIC, &now));
+    return (uint64_t) now.tv_sec * 1000 + (uint64_t) now.tv_nsec / 1000000;
+}
+
+/* nanoseconds on the monotonic clock time tasks for the histograms */
+static uint64_t nanos(void) {
+    struct timespec now;
+    seagrass_required_true(!clock_gettime(CLOCK_MONOTONIC, &now));
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
+static uintmax_t bucket(const uint64_t duration) {
+    if (duration < 2) {
+        return 0;
+    }
+    const uintmax_t log = 63 - (uintmax_t) __builtin_clzll(duration);
+    return log < SQUID_EXECUTOR_STATS_BUCKETS
+           ? log
+           : SQUID_EXECUTOR_STATS_BUCKETS - 1;
+}
+
+/* counters of the calling thread if it is one of home's threads */
+static _Thread_local struct squid_executor_counters *counters;
+static _Thread_local struct squid_executor *home; /* whose thread we are */
+static _Thread_local uintmax_t node; /* index of the node home placed us on */
+
+static struct squid_executor_counters *counters_of(
+        const struct squid_executor *const executor) {
+    assert(executor);
+    return counters && home == executor ? counters : executor->stats.shared;
+}
+
+static void tally(struct squid_executor_counters *const of,
+                  atomic_uintmax_t *const counter,
+                  const uintmax_t amount) {
+    assert(of);
+    assert(counter);
+    if (of == counters) {
+        /* nobody else writes to our own counters so there is nothing to
+         * contend for */
+        atomic_store_explicit(counter, amount + atomic_load_explicit(
+                counter, memory_order_relaxed), memory_order_relaxed);
+    } else {
+        atomic_fetch_add_explicit(counter, amount, memory_order_relaxed);
+    }
+}
+
+/* counters are allocated on cache lines of their own */
+static struct squid_executor_counters *allocate(void) {
+    const size_t size = (sizeof(struct squid_executor_counters)
+                         + SQUID_EXECUTOR_CACHE_LINE - 1)
+                        & ~(size_t) (SQUID_EXECUTOR_CACHE_LINE - 1);
+    void *const memory = malloc(size + SQUID_EXECUTOR_CACHE_LINE);
+    if (!memory) {
+        return NULL;
+    }
+    struct squid_executor_counters *const object
+            = (struct squid_executor_counters *) (
+                    ((uintptr_t) memory + SQUID_EXECUTOR_CACHE_LINE - 1)
+                    & ~(uintptr_t) (SQUID_EXECUTOR_CACHE_LINE - 1));
+    *object = (struct squid_executor_counters) {
+            .memory = memory
+    };
+    return object;
+}
+
+/* lets the strand of future, if any, move on once future is finished */
+static void advance(struct squid_future *const future) {
+    assert(future);
+    if (!future->strand) {
+        return;
+    }
+    struct squid_strand *strand;
+    seagrass_required_true(triggerfish_strong_instance(
+            future->strand, (void **) &strand));
+    seagrass_required_true(squid_strand_advance(strand));
+}
+
+static void discard(struct squid_executor *const object, void *const item) {
+    assert(object);
+    assert(item);
+    struct squid_executor_counters *const of = counters_of(object);
+    if (is_record(item)) {
+        seagrass_required_true(squid_pool_release(&object->records,
+                                                  record_index(item)));
+        tally(of, &of->cancelled, 1);
+    } else {
+        /* a task that will never run must not leave anyone waiting on it */
+        struct squid_future *future;
+        seagrass_required_true(triggerfish_strong_instance(
+                item, (void **) &future));
+        /* a thread waiting for it may have taken it and counts it then */
+        const bool is_taken = atomic_exchange(&future->is_queued, false);
+        if (squid_future_cancel(future, NULL)) {
+            if (is_taken) {
+                tally(of, &of->cancelled, 1);
+            }
+        } else {
+            seagrass_required_true(SQUID_FUTURE_ERROR_FUTURE_IS_DONE
+                                   == squid_error);
+        }
+        advance(future);
+        seagrass_required_true(triggerfish_strong_release(item));
+    }
+}
+
+static void drop(void *const item, void *const args) {
+    discard(args, item);
+}
+
+static void unblock(struct squid_executor *const object) {
+    assert(object);
+    atomic_fetch_add(&object->queue.epoch, 1);
+    seagrass_required_true(squid_futex_wake(&object->queue.epoch,
+                                            UINTMAX_MAX));
+}
+
+static bool take(struct squid_executor *const object,
+                 struct squid_executor_lane *const lane,
+                 void **const out) {
+    assert(object);
+    assert(lane);
+    assert(out);
+    if (!object->queue.backend->remove(object, lane, out)) {
+        return false;
+    }
+    if (object->queue.capacity) {
+        /* pairs with the fence in block() so that either we see the blocked
+         * submitter or it sees the room we just made */
+        atomic_thread_fence(memory_order_seq_cst);
+        if (atomic_load(&object->queue.blocked)) {
+            unblock(object);
+        }
+    }
+    return true;
+}
+
+static uintmax_t drain(struct squid_executor *const object) {
     assert(object);
-    int error;
-    if ((error = pthread_mutex_destroy(&object->threads.mutex))) {
-        seagrass_required_true(error == EINVAL);
+    uintmax_t count = 0;
+    for (uintmax_t i = 0; i < SQUID_EXECUTOR_LANES; i++) {
+        count += object->queue.backend->drain(
+                object, &object->queue.lanes[i], drop, object);
     }
-    if ((error = pthread_cond_destroy(&object->threads.condition))) {
-        seagrass_required_true(error == EINVAL);
+    for (uintmax_t i = 0; object->placement.is_queue_per_node
+                          && i < object->placement.count; i++) {
+        count += object->queue.backend->drain(
+                object, &object->placement.nodes[i].lane, drop, object);
     }
+    if (count && object->queue.capacity) {
+        unblock(object);
+    }
+    return count;
+}
+
+static uintmax_t unschedule_all(struct squid_executor *object);
+
+static void invalidate(struct squid_executor *const object) {
+    assert(object);
     if (!triggerfish_weak_destroy(object->self)) {
         seagrass_required_true(TRIGGERFISH_WEAK_ERROR_OBJECT_IS_NULL
                                == triggerfish_error);
     }
-    seagrass_required_true(lionfish_concurrent_linked_queue_sr_invalidate(
-            &object->tasks));
+    void *out;
+    if (object->queue.backend) {
+        drain(object);
+        for (uintmax_t i = 0; i < SQUID_EXECUTOR_LANES; i++) {
+            object->queue.backend->invalidate(object,
+                                              &object->queue.lanes[i]);
+        }
+        for (uintmax_t i = 0; object->placement.is_queue_per_node
+                              && i < object->placement.count; i++) {
+            object->queue.backend->invalidate(
+                    object, &object->placement.nodes[i].lane);
+        }
+    }
+    free(object->placement.nodes);
+    if (object->threads.workers) {
+        for (uintmax_t i = 0; i < object->options.threads.maximum; i++) {
+            struct squid_deque *const tasks
+                    = &object->threads.workers[i].tasks;
+            while (squid_deque_pop(tasks, &out)) {
+                discard(object, out);
+            }
+            seagrass_required_true(squid_deque_invalidate(tasks));
+        }
+        free(object->threads.workers);
+    }
+    seagrass_required_true(squid_pool_invalidate(&object->records));
+    unschedule_all(object);
+    struct squid_executor_counters *next = atomic_load(
+            &object->stats.counters);
+    while (next) {
+        struct squid_executor_counters *const of = next;
+        next = of->next;
+        free(of->memory);
+    }
+    if (object->stats.shared) {
+        free(object->stats.shared->memory);
+    }
+    seagrass_required_true(squid_wheel_invalidate(&object->timer.wheel));
+    seagrass_required_true(!pthread_mutex_destroy(&object->timer.mutex));
     *object = (struct squid_executor) {0};
 }
 
+bool squid_executor_options_init(struct squid_executor_options *const object) {
+    if (!object) {
+        squid_error = SQUID_EXECUTOR_ERROR_OPTIONS_IS_NULL;
+        return false;
+    }
+    *object = (struct squid_executor_options) {
+            .threads.maximum = UINTMAX_MAX,
+            .work_stealing.capacity = 1024,
+            .priority.aging = 32
+    };
+    return true;
+}
+
+static bool options_are_valid(const struct squid_executor_options *const object) {
+    assert(object);
+    if (!object->threads.maximum
+        || object->threads.minimum > object->threads.maximum
+        || object->threads.prestart > object->threads.maximum) {
+        return false;
+    }
+#ifdef PTHREAD_STACK_MIN
+    if (object->threads.stack_size
+        && object->threads.stack_size < PTHREAD_STACK_MIN) {
+        return false;
+    }
+#endif
+    if (object->work_stealing.is_enabled
+        && (!object->work_stealing.capacity
+            || object->work_stealing.capacity
+               > (SIZE_MAX / 2) / sizeof(void *)
+            || object->threads.maximum
+               > SIZE_MAX / sizeof(struct squid_executor_worker))) {
+        return false;
+    }
+    if (object->queue.capacity > (SIZE_MAX / 2)
+                                 / (sizeof(uintmax_t) + sizeof(void *))
+        || object->queue.rejection > SQUID_EXECUTOR_REJECTION_DISCARD_OLDEST
+        || object->queue.timeout / 1000 > INT32_MAX
+        || object->queue.backend > SQUID_EXECUTOR_BACKEND_DEADLINE
+        || (SQUID_EXECUTOR_BACKEND_RING == object->queue.backend
+            && !object->queue.capacity)
+        || (SQUID_EXECUTOR_BACKEND_DEADLINE == object->queue.backend
+            && object->work_stealing.is_enabled)) {
+        return false;
+    }
+    if (object->affinity.is_queue_per_node
+        && !object->affinity.is_numa_aware) {
+        return false;
+    }
+    return true;
+}
+
+static bool is_empty(const uint64_t *const cpus) {
+    assert(cpus);
+    for (uintmax_t i = 0; i < SQUID_NUMA_WORDS; i++) {
+        if (cpus[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* works out the CPUs that the threads of each node may run on */
+static bool prepare(struct squid_executor *const object) {
+    assert(object);
+    const struct squid_executor_options *const options = &object->options;
+    const bool is_restricted = !is_empty(options->affinity.cpus);
+    const bool is_numa_aware = options->affinity.is_numa_aware;
+    if (!is_restricted && !is_numa_aware) {
+        return true;
+    }
+    uintmax_t count;
+    seagrass_required_true(squid_numa_count(&count));
+    struct squid_executor_node *const nodes
+            = calloc(is_numa_aware ? count : 1, sizeof(*nodes));
+    if (!nodes) {
+        squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    bool is_placeable = false;
+    for (uintmax_t i = 0; i < count; i++) {
+        uint64_t cpus[SQUID_NUMA_WORDS];
+        seagrass_required_true(squid_numa_cpus(i, cpus));
+        /* without NUMA awareness all nodes are lumped together */
+        struct squid_executor_node *const of = &nodes[is_numa_aware ? i : 0];
+        for (uintmax_t k = 0; k < SQUID_NUMA_WORDS; k++) {
+            of->cpus[k] |= cpus[k] & (is_restricted
+                                      ? options->affinity.cpus[k]
+                                      : UINT64_MAX);
+        }
+        is_placeable = is_placeable || !is_empty(of->cpus);
+    }
+    if (!is_placeable) {
+        free(nodes);
+        squid_error = SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID;
+        return false;
+    }
+    object->placement.nodes = nodes;
+    object->placement.count = is_numa_aware ? count : 1;
+    if (!options->affinity.is_queue_per_node) {
+        return true;
+    }
+    for (uintmax_t i = 0; i < object->placement.count; i++) {
+        if (!object->queue.backend->init(object, &nodes[i].lane)) {
+            seagrass_required_true(
+                    SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED
+                    == squid_error);
+            while (i) {
+                object->queue.backend->invalidate(object, &nodes[--i].lane);
+            }
+            return false;
+        }
+    }
+    object->placement.is_queue_per_node = true;
+    return true;
+}
+
 bool squid_executor_init(struct squid_executor *const object) {
     if (!object) {
         squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
         return false;
     }
-    *object = (struct squid_executor) {0};
-    int error;
-    if ((error = pthread_mutex_init(&object->threads.mutex, NULL))
-        || (error = pthread_cond_init(&object->threads.condition, NULL))) {
-        seagrass_required_true(ENOMEM == error);
+    struct squid_executor_options options;
+    seagrass_required_true(squid_executor_options_init(&options));
+    return squid_executor_init_with_options(object, &options);
+}
+
+bool squid_executor_init_with_options(
+        struct squid_executor *const object,
+        const struct squid_executor_options *const options) {
+    if (!object) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!options) {
+        squid_error = SQUID_EXECUTOR_ERROR_OPTIONS_IS_NULL;
+        return false;
+    }
+    if (!options_are_valid(options)) {
+        squid_error = SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID;
+        return false;
+    }
+    *object = (struct squid_executor) {
+            .options = *options,
+            .timer.mutex = PTHREAD_MUTEX_INITIALIZER
+    };
+    /* the caller's prefix need not outlive the options */
+    if (options->threads.name) {
+        (void) snprintf(object->threads.name, sizeof(object->threads.name),
+                        "%s", options->threads.name);
+    }
+    object->options.threads.name = *object->threads.name
+                                   ? object->threads.name : NULL;
+    seagrass_required_true(squid_wheel_init(&object->timer.wheel, ticks()));
+    const struct squid_backend *const backend
+            = SQUID_EXECUTOR_BACKEND_DEADLINE == options->queue.backend
+              ? &squid_backend_deadline
+              : SQUID_EXECUTOR_BACKEND_RING == options->queue.backend
+                || (SQUID_EXECUTOR_BACKEND_DEFAULT == options->queue.backend
+                    && options->queue.capacity)
+                ? &squid_backend_ring
+                : &squid_backend_linked;
+    for (uintmax_t i = 0; i < SQUID_EXECUTOR_LANES; i++) {
+        if (!backend->init(object, &object->queue.lanes[i])) {
+            seagrass_required_true(
+                    SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED
+                    == squid_error);
+            while (i) {
+                backend->invalidate(object, &object->queue.lanes[--i]);
+            }
+            invalidate(object);
+            squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
+            return false;
+        }
+    }
+    object->queue.backend = backend;
+    if (!squid_pool_init(&object->records,
+                         sizeof(struct squid_executor_record))) {
+        seagrass_required_true(SQUID_POOL_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
         invalidate(object);
         squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
         return false;
     }
-    if (!lionfish_concurrent_linked_queue_sr_init(&object->tasks, 8)) {
-        seagrass_required_true(
-                LIONFISH_CONCURRENT_LINKED_QUEUE_SR_ERROR_MEMORY_ALLOCATION_FAILED
-                == lionfish_error);
+    if (!(object->stats.shared = allocate())) {
         invalidate(object);
         squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
         return false;
     }
+    if (options->work_stealing.is_enabled) {
+        object->threads.workers = calloc(options->threads.maximum,
+                                         sizeof(*object->threads.workers));
+        if (!object->threads.workers) {
+            invalidate(object);
+            squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
+            return false;
+        }
+        for (uintmax_t i = 0; i < options->threads.maximum; i++) {
+            struct squid_executor_worker *const worker
+                    = &object->threads.workers[i];
+            worker->executor = object;
+            if (!squid_deque_init(&worker->tasks,
+                                  options->work_stealing.capacity)) {
+                seagrass_required_true(
+                        SQUID_DEQUE_ERROR_MEMORY_ALLOCATION_FAILED
+                        == squid_error);
+                invalidate(object);
+                squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
+                return false;
+            }
+        }
+    }
+    if (!prepare(object)) {
+        const uintmax_t error = squid_error;
+        invalidate(object);
+        squid_error = error;
+        return false;
+    }
     atomic_store(&object->is_running, true);
     return true;
 }
@@ -105,6 +521,69 @@ bool squid_executor_invalidate(struct squid_executor *const object) {
     return true;
 }
 
+static void wake(struct squid_executor *const object, const uintmax_t count) {
+    assert(object);
+    atomic_fetch_add(&object->threads.epoch, 1);
+    seagrass_required_true(squid_futex_wake(&object->threads.epoch, count));
+}
+
+/* must be the last the thread does with object, which those awaiting
+ * termination may free as soon as the count drops to zero */
+static void depart(struct squid_executor *const object) {
+    assert(object);
+    atomic_int *const live = &object->threads.live;
+    if (1 == atomic_fetch_sub(live, 1)) {
+        /* a private futex is only a key, waking it touches no memory */
+        seagrass_required_true(squid_futex_wake(live, UINTMAX_MAX));
+    }
+}
+
+static void leave(struct squid_executor *const object) {
+    assert(object);
+    uintmax_t value;
+    const uintmax_t count = atomic_fetch_sub(&object->threads.count, 1);
+    seagrass_required_true(seagrass_uintmax_t_subtract(count, 1, &value));
+    depart(object);
+}
+
+static void notify(struct squid_executor *const object,
+                   const uintmax_t count) {
+    assert(object);
+    /* pairs with the fence in park() so that either we see the sleeper or
+     * the sleeper sees our task */
+    atomic_thread_fence(memory_order_seq_cst);
+    const uintmax_t sleeping = atomic_load(&object->threads.sleeping);
+    if (sleeping) {
+        wake(object, count < sleeping ? count : sleeping);
+    }
+}
+
+static bool is_valid(const struct timespec *const deadline) {
+    assert(deadline);
+    return deadline->tv_sec >= 0 && deadline->tv_nsec >= 0
+           && deadline->tv_nsec < 1000000000;
+}
+
+static bool await(struct squid_executor *const object,
+                  const struct timespec *const deadline) {
+    assert(object);
+    while (true) {
+        const int live = atomic_load(&object->threads.live);
+        if (!live) {
+            return true;
+        }
+        if (!squid_futex_wait(&object->threads.live, live, deadline)) {
+            seagrass_required_true(SQUID_FUTEX_ERROR_TIMED_OUT
+                                   == squid_error);
+            if (!atomic_load(&object->threads.live)) {
+                return true;
+            }
+            squid_error = SQUID_EXECUTOR_ERROR_TIMED_OUT;
+            return false;
+        }
+    }
+}
+
 bool squid_executor_shutdown(struct squid_executor *const object) {
     if (!object) {
         squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
@@ -117,23 +596,69 @@ bool squid_executor_shutdown(struct squid_executor *const object) {
         squid_error = SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN;
         return false;
     }
-    do {
-        if (!atomic_load(&object->threads.count)) {
-            break;
-        }
-        if (atomic_load(&object->threads.ready)) {
-            seagrass_required_true(!pthread_cond_broadcast(
-                    &object->threads.condition));
+    unblock(object);
+    unschedule_all(object);
+    wake(object, UINTMAX_MAX);
+    seagrass_required_true(await(object, NULL));
+    return true;
+}
+
+bool squid_executor_shutdown_now(struct squid_executor *const object,
+                                 uintmax_t *const out) {
+    if (!object) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_EXECUTOR_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    bool expected = true;
+    const bool desired = false;
+    if (!atomic_compare_exchange_strong(&object->is_running, &expected,
+                                        desired)) {
+        squid_error = SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN;
+        return false;
+    }
+    unblock(object);
+    /* detach the shared queue in one go instead of letting the threads pick
+     * off the pending tasks one at a time */
+    uintmax_t count = drain(object) + unschedule_all(object);
+    if (object->threads.workers) {
+        for (uintmax_t i = 0; i < object->options.threads.maximum; i++) {
+            struct squid_deque *const tasks
+                    = &object->threads.workers[i].tasks;
+            void *item;
+            while (true) {
+                if (squid_deque_steal(tasks, &item)) {
+                    discard(object, item);
+                    count++;
+                } else if (SQUID_DEQUE_ERROR_DEQUE_IS_EMPTY == squid_error) {
+                    break;
+                }
+            }
         }
-        const struct timespec delay = {
-                .tv_nsec = 100000000 /* 100 milliseconds */
-        };
-        seagrass_required_true(!nanosleep(&delay, NULL)
-                               || errno == EINTR);
-    } while (true);
+    }
+    wake(object, UINTMAX_MAX);
+    seagrass_required_true(await(object, NULL));
+    *out = count;
     return true;
 }
 
+bool squid_executor_await_termination(
+        struct squid_executor *const object,
+        const struct timespec *const deadline) {
+    if (!object) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (deadline && !is_valid(deadline)) {
+        squid_error = SQUID_EXECUTOR_ERROR_DEADLINE_IS_INVALID;
+        return false;
+    }
+    return await(object, deadline);
+}
+
 static void on_destroy(void *const object) {
     struct squid_executor *const executor = object;
     seagrass_required_true(!pthread_rwlock_wrlock(&lock));
@@ -148,20 +673,43 @@ static void on_destroy(void *const object) {
     seagrass_required_true(squid_executor_invalidate(executor));
 }
 
+static bool spawn(struct squid_executor *object);
+
 bool squid_executor_of(struct triggerfish_strong **const out) {
     if (!out) {
         squid_error = SQUID_EXECUTOR_ERROR_OUT_IS_NULL;
         return false;
     }
+    struct squid_executor_options options;
+    seagrass_required_true(squid_executor_options_init(&options));
+    return squid_executor_of_with_options(&options, out);
+}
+
+bool squid_executor_of_with_options(
+        const struct squid_executor_options *const options,
+        struct triggerfish_strong **const out) {
+    if (!options) {
+        squid_error = SQUID_EXECUTOR_ERROR_OPTIONS_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_EXECUTOR_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    if (!options_are_valid(options)) {
+        squid_error = SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID;
+        return false;
+    }
     struct squid_executor *object = malloc(sizeof(*object));
     if (!object) {
         squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
         return false;
     }
-    if (!squid_executor_init(object)) {
+    if (!squid_executor_init_with_options(object, options)) {
+        /* the affinity can only be checked against the topology */
         seagrass_required_true(
-                SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED
-                == squid_error);
+                SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED == squid_error
+                || SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID == squid_error);
         free(object);
         return false;
     }
@@ -179,8 +727,18 @@ bool squid_executor_of(struct triggerfish_strong **const out) {
                 TRIGGERFISH_WEAK_ERROR_MEMORY_ALLOCATION_FAILED
                 == triggerfish_error);
         seagrass_required_true(triggerfish_strong_release(strong));
+        squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
         return false;
     }
+    for (uintmax_t i = 0; i < options->threads.prestart; i++) {
+        if (!spawn(object)) {
+            seagrass_required_true(SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED
+                                   == squid_error);
+            seagrass_required_true(triggerfish_strong_release(strong));
+            squid_error = SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED;
+            return false;
+        }
+    }
     *out = strong;
     return true;
 }
@@ -213,174 +771,1635 @@ bool squid_executor_ready(const struct squid_executor *const object,
     return true;
 }
 
-bool squid_executor_is_running(const struct squid_executor *const object,
-                               bool *const out) {
+bool squid_executor_pending(const struct squid_executor *const object,
+                            const enum squid_executor_priority priority,
+                            uintmax_t *const out) {
     if (!object) {
         squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
         return false;
     }
+    if ((uintmax_t) priority >= SQUID_EXECUTOR_LANES) {
+        squid_error = SQUID_EXECUTOR_ERROR_PRIORITY_IS_INVALID;
+        return false;
+    }
     if (!out) {
         squid_error = SQUID_EXECUTOR_ERROR_OUT_IS_NULL;
         return false;
     }
-    *out = atomic_load(&object->is_running);
+    *out = object->queue.backend
+           ? object->queue.backend->count(object,
+                                          &object->queue.lanes[priority])
+           : 0;
+    for (uintmax_t i = 0; SQUID_EXECUTOR_PRIORITY_NORMAL == priority
+                          && object->placement.is_queue_per_node
+                          && i < object->placement.count; i++) {
+        *out += object->queue.backend->count(
+                object, &object->placement.nodes[i].lane);
+    }
     return true;
 }
 
-static _Thread_local struct squid_future *task;
-
-static bool is_cancelled(void) {
-    enum squid_future_status status;
-    seagrass_required_true(squid_future_status(task, &status));
-    if (SQUID_FUTURE_STATUS_CANCELLED == status) {
-        return true;
+bool squid_executor_pool_hits(const struct squid_executor *const object,
+                              uintmax_t *const out) {
+    if (!object) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
+        return false;
     }
-    struct squid_executor *executor;
-    seagrass_required_true(triggerfish_strong_instance(
-            task->executor, (void **) &executor));
-    if (!atomic_load(&executor->is_running)) {
-        atomic_store(&task->status, SQUID_FUTURE_STATUS_CANCELLED);
-        return true;
+    if (!out) {
+        squid_error = SQUID_EXECUTOR_ERROR_OUT_IS_NULL;
+        return false;
     }
-    return false;
+    uintmax_t count;
+    seagrass_required_true(squid_pool_hits(&object->records, &count));
+    for (uintmax_t i = 0; i < SQUID_EXECUTOR_LANES; i++) {
+        uintmax_t nodes;
+        seagrass_required_true(squid_pool_hits(
+                &object->queue.lanes[i].linked.nodes, &nodes));
+        count += nodes;
+    }
+    for (uintmax_t i = 0; object->placement.is_queue_per_node
+                          && i < object->placement.count; i++) {
+        uintmax_t nodes;
+        seagrass_required_true(squid_pool_hits(
+                &object->placement.nodes[i].lane.linked.nodes, &nodes));
+        count += nodes;
+    }
+    *out = count;
+    return true;
 }
 
-static void *routine(void *object) {
-    seagrass_required(object);
-    (void) pthread_detach(pthread_self());
-    struct squid_executor *const executor = object;
-    struct triggerfish_strong *self;
-    if (!triggerfish_weak_strong(executor->self, &self)) {
-        seagrass_required_true(TRIGGERFISH_WEAK_ERROR_STRONG_IS_INVALID
-                               == triggerfish_error);
-        return NULL;
+bool squid_executor_pool_misses(const struct squid_executor *const object,
+                                uintmax_t *const out) {
+    if (!object) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
+        return false;
     }
-    struct triggerfish_strong *out;
-    loop:
-    while (lionfish_concurrent_linked_queue_sr_remove(&executor->tasks,
-                                                      &out)) {
-        seagrass_required_true(!pthread_cond_signal(
-                &executor->threads.condition));
-        seagrass_required_true(triggerfish_strong_instance(
-                out, (void **) &task));
-        if (atomic_load(&executor->is_running)) {
-            enum squid_future_status expected = SQUID_FUTURE_STATUS_PENDING;
-            if (atomic_compare_exchange_strong(&task->status,
-                                               (int *) &expected,
-                                               SQUID_FUTURE_STATUS_RUNNING)) {
-                task->function(task->args, is_cancelled, &task->out,
-                               &task->error);
+    if (!out) {
+        squid_error = SQUID_EXECUTOR_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    uintmax_t count;
+    seagrass_required_true(squid_pool_misses(&object->records, &count));
+    for (uintmax_t i = 0; i < SQUID_EXECUTOR_LANES; i++) {
+        uintmax_t nodes;
+        seagrass_required_true(squid_pool_misses(
+                &object->queue.lanes[i].linked.nodes, &nodes));
+        count += nodes;
+    }
+    for (uintmax_t i = 0; object->placement.is_queue_per_node
+                          && i < object->placement.count; i++) {
+        uintmax_t nodes;
+        seagrass_required_true(squid_pool_misses(
+                &object->placement.nodes[i].lane.linked.nodes, &nodes));
+        count += nodes;
+    }
+    *out = count;
+    return true;
+}
+
+static void merge(const struct squid_executor_counters *const of,
+                  struct squid_executor_stats *const out) {
+    assert(of);
+    assert(out);
+    out->submitted += atomic_load_explicit(&of->submitted,
+                                           memory_order_relaxed);
+    out->completed += atomic_load_explicit(&of->completed,
+                                           memory_order_relaxed);
+    out->cancelled += atomic_load_explicit(&of->cancelled,
+                                           memory_order_relaxed);
+    for (uintmax_t i = 0; i < SQUID_EXECUTOR_STATS_BUCKETS; i++) {
+        out->histogram.wait[i] += atomic_load_explicit(
+                &of->wait[i], memory_order_relaxed);
+        out->histogram.run[i] += atomic_load_explicit(
+                &of->run[i], memory_order_relaxed);
+    }
+}
+
+bool squid_executor_stats(const struct squid_executor *const object,
+                          struct squid_executor_stats *const out) {
+    if (!object) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_EXECUTOR_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    *out = (struct squid_executor_stats) {
+            .threads = {
+                    .created = atomic_load(&object->threads.created),
+                    .retired = atomic_load(&object->threads.retired)
+            }
+    };
+    if (object->stats.shared) {
+        merge(object->stats.shared, out);
+    }
+    for (const struct squid_executor_counters *of
+            = atomic_load(&object->stats.counters); of; of = of->next) {
+        merge(of, out);
+    }
+    for (uintmax_t i = 0; i < SQUID_EXECUTOR_LANES && object->queue.backend;
+         i++) {
+        out->pending += object->queue.backend->count(
+                object, &object->queue.lanes[i]);
+    }
+    for (uintmax_t i = 0; object->placement.is_queue_per_node
+                          && i < object->placement.count; i++) {
+        out->pending += object->queue.backend->count(
+                object, &object->placement.nodes[i].lane);
+    }
+    if (object->threads.workers) {
+        for (uintmax_t i = 0; i < object->options.threads.maximum; i++) {
+            uintmax_t count;
+            seagrass_required_true(squid_deque_count(
+                    &object->threads.workers[i].tasks, &count));
+            out->pending += count;
+        }
+    }
+    return true;
+}
+
+bool squid_executor_is_running(const struct squid_executor *const object,
+                               bool *const out) {
+    if (!object) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_EXECUTOR_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    *out = atomic_load(&object->is_running);
+    return true;
+}
+
+static _Thread_local struct squid_future *task;
+static _Thread_local struct squid_executor_worker *worker;
+static _Thread_local struct squid_executor *current;
+static _Thread_local uintmax_t seed;
+static _Thread_local uintmax_t turn;
+
+static bool is_cancelled(void) {
+    if (!task) {
+        /* records have no status of their own */
+        return !atomic_load(&current->is_running);
+    }
+    enum squid_future_status status;
+    seagrass_required_true(squid_future_status(task, &status));
+    if (SQUID_FUTURE_STATUS_CANCELLED == status) {
+        return true;
+    }
+    if (!atomic_load(&current->is_running)) {
+        atomic_store(&task->status, SQUID_FUTURE_STATUS_CANCELLED);
+        return true;
+    }
+    return false;
+}
+
+static bool retire(struct squid_executor *const executor) {
+    assert(executor);
+    uintmax_t count = atomic_load(&executor->threads.count);
+    do {
+        if (atomic_load(&executor->is_running)
+            && count <= executor->options.threads.minimum) {
+            return false;
+        }
+    } while (!atomic_compare_exchange_weak(&executor->threads.count,
+                                           &count, count - 1));
+    atomic_fetch_add_explicit(&executor->threads.retired, 1,
+                              memory_order_relaxed);
+    return true;
+}
+
+static void claim(struct squid_executor *const executor) {
+    assert(executor);
+    if (!executor->threads.workers) {
+        return;
+    }
+    /* at most count - 1 other threads hold a worker so one will be free */
+    for (uintmax_t i = 0;; i = (1 + i) % executor->options.threads.maximum) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(
+                &executor->threads.workers[i].is_claimed, &expected, true)) {
+            worker = &executor->threads.workers[i];
+            break;
+        }
+    }
+    seed = (uintptr_t) &seed ^ (uintptr_t) worker;
+    seed |= 1;
+}
+
+static void unclaim(void) {
+    if (!worker) {
+        return;
+    }
+    atomic_store(&worker->is_claimed, false);
+    worker = NULL;
+}
+
+static void enlist(struct squid_executor *const executor) {
+    assert(executor);
+    struct squid_executor_counters *next = atomic_load(
+            &executor->stats.counters);
+    /* those of retired threads are taken over rather than added to */
+    for (struct squid_executor_counters *of = next; of; of = of->next) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&of->is_claimed, &expected,
+                                           true)) {
+            counters = of;
+            return;
+        }
+    }
+    struct squid_executor_counters *const object = allocate();
+    if (!object) {
+        /* we make do with the shared counters */
+        return;
+    }
+    atomic_store(&object->is_claimed, true);
+    do {
+        object->next = next;
+    } while (!atomic_compare_exchange_weak(&executor->stats.counters, &next,
+                                           object));
+    counters = object;
+}
+
+static void delist(void) {
+    if (!counters) {
+        return;
+    }
+    atomic_store(&counters->is_claimed, false);
+    counters = NULL;
+}
+
+/* joins the node with the fewest threads among those we may run on */
+static void place(struct squid_executor *const executor) {
+    assert(executor);
+    node = 0;
+    if (!executor->placement.nodes) {
+        return;
+    }
+    uintmax_t fewest = UINTMAX_MAX;
+    for (uintmax_t i = 0; i < executor->placement.count; i++) {
+        struct squid_executor_node *const of = &executor->placement.nodes[i];
+        const uintmax_t threads = atomic_load(&of->threads);
+        if (!is_empty(of->cpus) && threads < fewest) {
+            fewest = threads;
+            node = i;
+        }
+    }
+    struct squid_executor_node *const of = &executor->placement.nodes[node];
+    atomic_fetch_add(&of->threads, 1);
+    /* we run wherever we are let if the CPUs have since been taken away */
+    if (!squid_numa_pin(of->cpus)) {
+        seagrass_required_true(SQUID_NUMA_ERROR_AFFINITY_FAILED
+                               == squid_error);
+    }
+}
+
+static void displace(struct squid_executor *const executor) {
+    assert(executor);
+    if (executor->placement.nodes) {
+        atomic_fetch_sub(&executor->placement.nodes[node].threads, 1);
+    }
+}
+
+static bool steal(struct squid_executor *const executor,
+                  void **const out) {
+    assert(executor);
+    assert(out);
+    assert(worker);
+    /* xorshift to pick a random victim to start with */
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    const uintmax_t maximum = executor->options.threads.maximum;
+    const uintmax_t offset = seed % maximum;
+    for (uintmax_t i = 0; i < maximum; i++) {
+        struct squid_executor_worker *const victim
+                = &executor->threads.workers[(offset + i) % maximum];
+        if (victim == worker) {
+            continue;
+        }
+        do {
+            if (squid_deque_steal(&victim->tasks, out)) {
+                return true;
+            }
+        } while (SQUID_DEQUE_ERROR_DEQUE_IS_CONTENDED == squid_error);
+        seagrass_required_true(SQUID_DEQUE_ERROR_DEQUE_IS_EMPTY
+                               == squid_error);
+    }
+    return false;
+}
+
+/* our own node's queue comes first, then those of the nodes after it */
+static bool nearest(struct squid_executor *const executor,
+                    void **const out) {
+    assert(executor);
+    assert(out);
+    const uintmax_t count = executor->placement.count;
+    for (uintmax_t i = 0; i < count; i++) {
+        struct squid_executor_node *const of
+                = &executor->placement.nodes[(node + i) % count];
+        if (take(executor, &of->lane, out)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool next(struct squid_executor *const executor,
+                 void **const out) {
+    assert(executor);
+    assert(out);
+    /* every aging-th turn starts with one of the lower lanes instead */
+    uintmax_t first = SQUID_EXECUTOR_PRIORITY_HIGH;
+    const uintmax_t aging = executor->options.priority.aging;
+    if (aging && !(++turn % aging)) {
+        first = 1 + (turn / aging) % (SQUID_EXECUTOR_LANES - 1);
+    }
+    for (uintmax_t i = 0; i < SQUID_EXECUTOR_LANES; i++) {
+        const uintmax_t lane = (first + i) % SQUID_EXECUTOR_LANES;
+        /* our deque only holds normal priority tasks */
+        if (SQUID_EXECUTOR_PRIORITY_NORMAL == lane && worker) {
+            if (squid_deque_pop(&worker->tasks, out)) {
+                return true;
+            }
+            seagrass_required_true(SQUID_DEQUE_ERROR_DEQUE_IS_EMPTY
+                                   == squid_error);
+        }
+        if (SQUID_EXECUTOR_PRIORITY_NORMAL == lane
+            && executor->placement.is_queue_per_node) {
+            if (nearest(executor, out)) {
+                return true;
+            }
+        } else if (take(executor, &executor->queue.lanes[lane], out)) {
+            return true;
+        }
+    }
+    return worker && steal(executor, out);
+}
+
+static bool is_idle(struct squid_executor *const executor) {
+    assert(executor);
+    for (uintmax_t i = 0; i < SQUID_EXECUTOR_LANES; i++) {
+        if (!executor->queue.backend->is_empty(
+                executor, &executor->queue.lanes[i])) {
+            return false;
+        }
+    }
+    for (uintmax_t i = 0; executor->placement.is_queue_per_node
+                          && i < executor->placement.count; i++) {
+        if (!executor->queue.backend->is_empty(
+                executor, &executor->placement.nodes[i].lane)) {
+            return false;
+        }
+    }
+    if (executor->threads.workers) {
+        for (uintmax_t i = 0; i < executor->options.threads.maximum; i++) {
+            uintmax_t count;
+            seagrass_required_true(squid_deque_count(
+                    &executor->threads.workers[i].tasks, &count));
+            if (count) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static bool park(struct squid_executor *const executor) {
+    assert(executor);
+    for (uintmax_t i = 0; i < SPINS; i++) {
+        if (!is_idle(executor) || !atomic_load(&executor->is_running)) {
+            return true;
+        }
+        relax();
+    }
+    struct timespec deadline;
+    seagrass_required_true(!clock_gettime(CLOCK_MONOTONIC, &deadline));
+    seagrass_required_true((deadline.tv_sec += 60) >= 0);
+    const int epoch = atomic_load(&executor->threads.epoch);
+    uintmax_t value;
+    seagrass_required_true(seagrass_uintmax_t_add(
+            1, atomic_fetch_add(&executor->threads.sleeping, 1), &value));
+    atomic_thread_fence(memory_order_seq_cst);
+    bool result = true;
+    if (is_idle(executor) && atomic_load(&executor->is_running)
+        && !(result = squid_futex_wait(&executor->threads.epoch, epoch,
+                                       &deadline))) {
+        seagrass_required_true(SQUID_FUTEX_ERROR_TIMED_OUT == squid_error);
+    }
+    seagrass_required_true(seagrass_uintmax_t_subtract(
+            atomic_fetch_sub(&executor->threads.sleeping, 1), 1, &value));
+    return result;
+}
+
+static void execute(struct squid_executor *const executor,
+                    const uint32_t index) {
+    assert(executor);
+    struct squid_executor_record *record;
+    seagrass_required_true(squid_pool_at(&executor->records, index,
+                                         (void **) &record));
+    const struct squid_executor_record copy = *record;
+    seagrass_required_true(squid_pool_release(&executor->records, index));
+    struct squid_executor_counters *const of = counters_of(executor);
+    if (!atomic_load(&executor->is_running)) {
+        tally(of, &of->cancelled, 1);
+        return;
+    }
+    const uint64_t start = nanos();
+    SQUID_TRACE_RECORD(SQUID_TRACE_KIND_START, record_item(index),
+                       copy.task.function, copy.queued_at, start);
+    tally(of, &of->wait[bucket(start - copy.queued_at)], 1);
+    /* records may also run on a submitting thread or from within a task */
+    struct squid_future *const previous = task;
+    struct squid_executor *const previous_executor = current;
+    task = NULL;
+    current = executor;
+    struct triggerfish_strong *out = NULL;
+    uintmax_t error;
+    copy.task.function(copy.task.args, is_cancelled, &out, &error);
+    if (out) {
+        seagrass_required_true(triggerfish_strong_release(out));
+    }
+    task = previous;
+    current = previous_executor;
+    const uint64_t end = nanos();
+    SQUID_TRACE_RECORD(SQUID_TRACE_KIND_FINISH, record_item(index),
+                       copy.task.function, copy.queued_at, end);
+    tally(of, &of->run[bucket(end - start)], 1);
+    tally(of, &of->completed, 1);
+}
+
+static bool rearm(struct squid_executor *executor,
+                  struct squid_future *future);
+
+/* cancels future rather than let it run past its deadline */
+static bool is_late(struct squid_executor *const executor,
+                    struct squid_future *const future) {
+    assert(executor);
+    assert(future);
+    if (!future->deadline || !executor->options.deadline.is_enforced) {
+        return false;
+    }
+    struct timespec now;
+    seagrass_required_true(!clock_gettime(CLOCK_MONOTONIC, &now));
+    if ((uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec
+        < future->deadline) {
+        return false;
+    }
+    /* set ahead of the status so that those who see it cancelled see why */
+    atomic_store(&future->is_late, true);
+    enum squid_future_status expected = SQUID_FUTURE_STATUS_PENDING;
+    if (!atomic_compare_exchange_strong(&future->status, (int *) &expected,
+                                        SQUID_FUTURE_STATUS_CANCELLED)) {
+        atomic_store(&future->is_late, false);
+    }
+    return true;
+}
+
+/* runs future unless another thread got to it first, returns whether it
+ * went back onto the timer wheel, is_taken if we took it off the queue and
+ * count it as cancelled should it not run */
+static bool invoke(struct squid_executor *const executor,
+                   struct squid_future *const future,
+                   const bool is_taken) {
+    assert(executor);
+    assert(future);
+    struct squid_executor_counters *const of = counters_of(executor);
+    bool is_run = false;
+    /* inline continuations run from within another task */
+    struct squid_future *const previous = task;
+    struct squid_executor *const previous_executor = current;
+    task = future;
+    current = executor;
+    bool is_rearmed = false;
+    enum squid_future_status expected = SQUID_FUTURE_STATUS_PENDING;
+    if (atomic_load(&executor->is_running)) {
+        /* combinators have no function and are completed by inputs */
+        if (task->function && !is_late(executor, task)
+            && atomic_compare_exchange_strong(&task->status,
+                                           (int *) &expected,
+                                           SQUID_FUTURE_STATUS_RUNNING)) {
+            /* inline continuations were never queued and are not counted */
+            const uint64_t queued_at = task->queued_at;
+            const uint64_t start = nanos();
+            SQUID_TRACE_RECORD(SQUID_TRACE_KIND_START, task, task->function,
+                               queued_at, start);
+            if (queued_at) {
+                tally(of, &of->wait[bucket(start - queued_at)], 1);
+            }
+            task->function(task->args, is_cancelled, &task->out,
+                           &task->error);
+            const uint64_t end = nanos();
+            SQUID_TRACE_RECORD(SQUID_TRACE_KIND_FINISH, task, task->function,
+                               queued_at, end);
+            if (queued_at) {
+                tally(of, &of->run[bucket(end - start)], 1);
+                tally(of, &of->completed, 1);
+            }
+            is_run = true;
+            if (!(is_rearmed = rearm(executor, task))) {
                 expected = SQUID_FUTURE_STATUS_RUNNING;
                 atomic_compare_exchange_strong(&task->status,
                                                (int *) &expected,
                                                SQUID_FUTURE_STATUS_DONE);
             }
+        }
+    } else {
+        /* a waiting thread may have claimed it ahead of us */
+        atomic_compare_exchange_strong(&task->status, (int *) &expected,
+                                       SQUID_FUTURE_STATUS_CANCELLED);
+    }
+    task = previous;
+    current = previous_executor;
+    if (is_taken && !is_run
+        && SQUID_FUTURE_STATUS_CANCELLED == atomic_load(&future->status)) {
+        tally(of, &of->cancelled, 1);
+    }
+    return is_rearmed;
+}
+
+static void run(struct squid_executor *const executor,
+                struct squid_future *const future) {
+    assert(executor);
+    assert(future);
+    if (!invoke(executor, future,
+                atomic_exchange(&future->is_queued, false))) {
+        seagrass_required_true(squid_future_notify(future));
+        advance(future);
+    }
+}
+
+static void perform(struct squid_executor *const executor,
+                    void *const item) {
+    assert(executor);
+    assert(item);
+    if (is_record(item)) {
+        execute(executor, record_index(item));
+        return;
+    }
+    struct squid_future *future;
+    seagrass_required_true(triggerfish_strong_instance(
+            item, (void **) &future));
+    run(executor, future);
+    seagrass_required_true(triggerfish_strong_release(item));
+}
+
+/* prefix followed by the order the thread started in, such as squid-w3 */
+static void name(struct squid_executor *const executor) {
+    assert(executor);
+    const uintmax_t index = atomic_fetch_add_explicit(
+            &executor->threads.started, 1, memory_order_relaxed);
+    if (!*executor->threads.name) {
+        return;
+    }
+    char number[24];
+    const int length = snprintf(number, sizeof(number), "%ju", index);
+    /* the number is kept whole at the expense of the prefix */
+    const int room = (int) sizeof(executor->threads.name) - 1 - length;
+    char name[sizeof(executor->threads.name) + sizeof(number)];
+    (void) snprintf(name, sizeof(name), "%.*s%s", room > 0 ? room : 0,
+                    executor->threads.name, number);
+#if defined(__linux__)
+    (void) prctl(PR_SET_NAME, name, 0, 0, 0);
+#endif
+}
+
+static void *routine(void *object) {
+    seagrass_required(object);
+    (void) pthread_detach(pthread_self());
+    struct squid_executor *const executor = object;
+    struct triggerfish_strong *self;
+    uintmax_t value;
+    if (!triggerfish_weak_strong(executor->self, &self)) {
+        seagrass_required_true(TRIGGERFISH_WEAK_ERROR_STRONG_IS_INVALID
+                               == triggerfish_error);
+        leave(executor);
+        return NULL;
+    }
+    current = executor;
+    home = executor;
+    place(executor);
+    enlist(executor);
+    claim(executor);
+    name(executor);
+    if (executor->options.threads.on_start) {
+        executor->options.threads.on_start(executor->options.threads.context);
+    }
+    void *out;
+    loop:
+    while (next(executor, &out)) {
+        perform(executor, out);
+    }
+    seagrass_required_true(seagrass_uintmax_t_add(
+            1, atomic_fetch_add(&executor->threads.ready, 1), &value));
+    const bool is_woken = park(executor);
+    seagrass_required_true(seagrass_uintmax_t_subtract(
+            atomic_fetch_sub(&executor->threads.ready, 1), 1, &value));
+    if (atomic_load(&executor->is_running)
+        && (is_woken || !is_idle(executor))) {
+        goto loop;
+    }
+    unclaim();
+    if (!retire(executor)) {
+        claim(executor);
+        goto loop;
+    }
+    if (executor->options.threads.on_exit) {
+        executor->options.threads.on_exit(executor->options.threads.context);
+    }
+    current = NULL;
+    delist();
+    displace(executor);
+    home = NULL;
+    depart(executor);
+    seagrass_required_true(triggerfish_strong_release(self));
+    return NULL;
+}
+
+static bool spawn(struct squid_executor *const object) {
+    assert(object);
+    uintmax_t count = atomic_load(&object->threads.count);
+    do {
+        if (count >= object->options.threads.maximum) {
+            return true;
+        }
+    } while (!atomic_compare_exchange_weak(&object->threads.count,
+                                           &count, 1 + count));
+    atomic_fetch_add(&object->threads.live, 1);
+    pthread_attr_t attributes;
+    seagrass_required_true(!pthread_attr_init(&attributes));
+    if (object->options.threads.stack_size) {
+        const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+        size_t size = object->options.threads.stack_size;
+        if (size % page && size <= SIZE_MAX - page) {
+            size += page - size % page;
+        }
+        seagrass_required_true(!pthread_attr_setstacksize(&attributes, size));
+    }
+    pthread_t thread;
+    const int error = pthread_create(&thread, &attributes, routine, object);
+    seagrass_required_true(!pthread_attr_destroy(&attributes));
+    if (error) {
+        seagrass_required_true(EAGAIN == error);
+        leave(object);
+        squid_error = SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED;
+        return false;
+    }
+    atomic_fetch_add_explicit(&object->threads.created, 1,
+                              memory_order_relaxed);
+    return true;
+}
+
+static bool block(struct squid_executor *const object,
+                  struct squid_executor_lane *const lane,
+                  void *const *const items,
+                  const uintmax_t count) {
+    assert(object);
+    assert(lane);
+    assert(items);
+    assert(count);
+    const uintmax_t timeout = object->options.queue.timeout;
+    struct timespec deadline;
+    if (timeout) {
+        seagrass_required_true(!clock_gettime(CLOCK_MONOTONIC, &deadline));
+        deadline.tv_sec += (time_t) (timeout / 1000);
+        deadline.tv_nsec += (long) (timeout % 1000) * 1000000;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000;
+        deadline.tv_nsec %= 1000000000;
+    }
+    uintmax_t value;
+    seagrass_required_true(seagrass_uintmax_t_add(
+            1, atomic_fetch_add(&object->queue.blocked, 1), &value));
+    bool result;
+    while (true) {
+        const int epoch = atomic_load(&object->queue.epoch);
+        /* pairs with the fence in take() */
+        atomic_thread_fence(memory_order_seq_cst);
+        if ((result = object->queue.backend->add_all(object, lane, items,
+                                                     count))) {
+            break;
+        }
+        if (SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL != squid_error) {
+            seagrass_required_true(
+                    SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED
+                    == squid_error);
+            break;
+        }
+        if (!atomic_load(&object->is_running)) {
+            squid_error = SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN;
+            break;
+        }
+        if (!squid_futex_wait(&object->queue.epoch, epoch,
+                              timeout ? &deadline : NULL)) {
+            seagrass_required_true(SQUID_FUTEX_ERROR_TIMED_OUT
+                                   == squid_error);
+            /* room may have been made as we timed out */
+            if (!(result = object->queue.backend->add_all(object, lane,
+                                                          items, count))
+                && SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL == squid_error) {
+                squid_error = SQUID_EXECUTOR_ERROR_TIMED_OUT;
+            }
+            break;
+        }
+    }
+    seagrass_required_true(seagrass_uintmax_t_subtract(
+            atomic_fetch_sub(&object->queue.blocked, 1), 1, &value));
+    return result;
+}
+
+/* normal priority tasks go to the queue of the node they are submitted from */
+static struct squid_executor_lane *lane_of(struct squid_executor *const object,
+                                           const uintmax_t lane) {
+    assert(object);
+    assert(lane < SQUID_EXECUTOR_LANES);
+    if (SQUID_EXECUTOR_PRIORITY_NORMAL != lane
+        || !object->placement.is_queue_per_node) {
+        return &object->queue.lanes[lane];
+    }
+    uintmax_t index = node;
+    if (home != object) {
+        seagrass_required_true(squid_numa_current(&index));
+    }
+    return &object->placement.nodes[index < object->placement.count
+                                     ? index : 0].lane;
+}
+
+/* on success out receives the count of trailing items that did not fit and
+ * are left to the caller to run */
+static bool offer(struct squid_executor *const object,
+                  const uintmax_t lane,
+                  void *const *const items,
+                  const uintmax_t count,
+                  const enum squid_executor_rejection rejection,
+                  uintmax_t *const out) {
+    assert(object);
+    assert(lane < SQUID_EXECUTOR_LANES);
+    assert(items);
+    assert(count);
+    assert(out);
+    *out = 0;
+    struct squid_executor_lane *const queue = lane_of(object, lane);
+    if (object->queue.backend->add_all(object, queue, items, count)) {
+        return true;
+    }
+    if (SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL != squid_error) {
+        seagrass_required_true(SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        return false;
+    }
+    const uintmax_t capacity = object->queue.capacity;
+    if (SQUID_EXECUTOR_REJECTION_BLOCK == rejection && current != object) {
+        if (count <= capacity) {
+            return block(object, queue, items, count);
+        }
+    } else if (SQUID_EXECUTOR_REJECTION_BLOCK == rejection
+               || SQUID_EXECUTOR_REJECTION_CALLER_RUNS == rejection) {
+        /* our own threads must not wait for room they might have to make */
+        *out = count;
+        return true;
+    } else if (SQUID_EXECUTOR_REJECTION_DISCARD_OLDEST == rejection) {
+        /* a batch beyond the capacity pushes out its own oldest tasks */
+        const uintmax_t skip = count > capacity ? count - capacity : 0;
+        void *item;
+        while (!object->queue.backend->add_all(object, queue, items + skip,
+                                               count - skip)) {
+            if (SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL != squid_error) {
+                seagrass_required_true(
+                        SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED
+                        == squid_error);
+                return false;
+            }
+            if (take(object, queue, &item)) {
+                discard(object, item);
+            }
+        }
+        for (uintmax_t i = 0; i < skip; i++) {
+            discard(object, items[i]);
+        }
+        return true;
+    }
+    squid_error = SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL;
+    return false;
+}
+
+/* on success the queues take ownership of all items, otherwise of none */
+static bool admit(struct squid_executor *const object,
+                  const uintmax_t lane,
+                  void *const *const items,
+                  const uintmax_t count,
+                  const enum squid_executor_rejection rejection) {
+    assert(object);
+    assert(lane < SQUID_EXECUTOR_LANES);
+    assert(items);
+    assert(count);
+    const uint64_t now = nanos();
+    for (uintmax_t i = 0; i < count; i++) {
+        if (is_record(items[i])) {
+            struct squid_executor_record *record;
+            seagrass_required_true(squid_pool_at(
+                    &object->records, record_index(items[i]),
+                    (void **) &record));
+            record->queued_at = now;
+            SQUID_TRACE_RECORD(SQUID_TRACE_KIND_ENQUEUE, items[i],
+                               record->task.function, now, now);
         } else {
-            atomic_store(&task->status, SQUID_FUTURE_STATUS_CANCELLED);
+            struct squid_future *future;
+            seagrass_required_true(triggerfish_strong_instance(
+                    items[i], (void **) &future));
+            future->queued_at = now;
+            SQUID_TRACE_RECORD(SQUID_TRACE_KIND_ENQUEUE, future,
+                               future->function, now, now);
+            /* from now on a thread waiting for it may run it instead */
+            atomic_store(&future->is_queued, true);
+        }
+    }
+    /* make sure that there will be a thread for each of the tasks */
+    for (uintmax_t i = atomic_load(&object->threads.ready); i < count; i++) {
+        if (atomic_load(&object->threads.count)
+            >= object->options.threads.maximum) {
+            break;
+        }
+        if (!spawn(object)) {
+            seagrass_required_true(SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED
+                                   == squid_error);
+            if (!atomic_load(&object->threads.count)) {
+                return false;
+            }
+            break;
+        }
+    }
+    uintmax_t local = 0;
+    if (worker && worker->executor == object
+        && SQUID_EXECUTOR_PRIORITY_NORMAL == lane) {
+        /* only we push onto our deque so its free room can only grow */
+        uintmax_t used;
+        seagrass_required_true(squid_deque_count(&worker->tasks, &used));
+        const uintmax_t room = 1 + worker->tasks.mask - used;
+        local = count < room ? count : room;
+    }
+    uintmax_t rejected = 0;
+    if (local < count
+        && !offer(object, lane, items + local, count - local, rejection,
+                  &rejected)) {
+        return false;
+    }
+    struct squid_executor_counters *const of = counters_of(object);
+    tally(of, &of->submitted, count);
+    for (uintmax_t i = 0; i < local; i++) {
+        seagrass_required_true(squid_deque_push(&worker->tasks, items[i]));
+    }
+    if (count > rejected) {
+        notify(object, count - rejected);
+    }
+    for (uintmax_t i = count - rejected; i < count; i++) {
+        perform(object, items[i]);
+    }
+    return true;
+}
+
+static bool enqueue(struct squid_executor *const object,
+                    const uintmax_t lane,
+                    void *const *const items,
+                    const uintmax_t count) {
+    return admit(object, lane, items, count,
+                 object->options.queue.rejection);
+}
+
+static bool is_enqueue_error(void) {
+    return SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED == squid_error
+           || SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED == squid_error
+           || SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL == squid_error
+           || SQUID_EXECUTOR_ERROR_TIMED_OUT == squid_error
+           || SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN == squid_error;
+}
+
+static bool submit(struct squid_executor *const object,
+                   const uintmax_t lane,
+                   const uint64_t deadline,
+                   struct triggerfish_strong *const executor,
+                   squid_function const function,
+                   void *const args,
+                   struct triggerfish_strong **const out) {
+    assert(object);
+    assert(executor);
+    assert(function);
+    assert(out);
+    struct triggerfish_strong *future;
+    if (!squid_future_of(executor, function, args, &future)) {
+        seagrass_required_true(SQUID_FUTURE_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    struct squid_future *instance;
+    seagrass_required_true(triggerfish_strong_instance(
+            future, (void **) &instance));
+    instance->deadline = deadline;
+    seagrass_required_true(triggerfish_strong_retain(future));
+    if (!enqueue(object, lane, (void **) &future, 1)) {
+        seagrass_required_true(is_enqueue_error());
+        seagrass_required_true(triggerfish_strong_release(future));
+        seagrass_required_true(triggerfish_strong_release(future));
+        return false;
+    }
+    *out = future;
+    return true;
+}
+
+bool squid_executor_submit(struct squid_executor *const object,
+                           squid_function const function,
+                           void *const args,
+                           struct triggerfish_strong **const out) {
+    return squid_executor_submit_with_priority(
+            object, SQUID_EXECUTOR_PRIORITY_NORMAL, function, args, out);
+}
+
+bool squid_executor_submit_with_priority(
+        struct squid_executor *const object,
+        const enum squid_executor_priority priority,
+        squid_function const function,
+        void *const args,
+        struct triggerfish_strong **const out) {
+    if (!object) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if ((uintmax_t) priority >= SQUID_EXECUTOR_LANES) {
+        squid_error = SQUID_EXECUTOR_ERROR_PRIORITY_IS_INVALID;
+        return false;
+    }
+    if (!function) {
+        squid_error = SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_EXECUTOR_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    bool result;
+    seagrass_required_true(squid_executor_is_running(object, &result));
+    if (!result) {
+        squid_error = SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN;
+        return false;
+    }
+    struct triggerfish_strong *self;
+    if (!triggerfish_weak_strong(object->self, &self)) {
+        seagrass_required_true(TRIGGERFISH_WEAK_ERROR_STRONG_IS_INVALID
+                               == triggerfish_error);
+        squid_error = SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN;
+        return false;
+    }
+    if (!(result = submit(object, priority, 0, self, function, args, out))) {
+        seagrass_required_true(is_enqueue_error());
+    }
+    seagrass_required_true(triggerfish_strong_release(self));
+    return result;
+}
+
+bool squid_executor_submit_with_deadline(
+        struct squid_executor *const object,
+        const struct timespec *const deadline,
+        squid_function const function,
+        void *const args,
+        struct triggerfish_strong **const out) {
+    if (!object) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!deadline) {
+        squid_error = SQUID_EXECUTOR_ERROR_DEADLINE_IS_NULL;
+        return false;
+    }
+    if (!function) {
+        squid_error = SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_EXECUTOR_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    if (!is_valid(deadline)) {
+        squid_error = SQUID_EXECUTOR_ERROR_DEADLINE_IS_INVALID;
+        return false;
+    }
+    if (!atomic_load(&object->is_running)) {
+        squid_error = SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN;
+        return false;
+    }
+    struct triggerfish_strong *self;
+    if (!triggerfish_weak_strong(object->self, &self)) {
+        seagrass_required_true(TRIGGERFISH_WEAK_ERROR_STRONG_IS_INVALID
+                               == triggerfish_error);
+        squid_error = SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN;
+        return false;
+    }
+    const uint64_t seconds = (uint64_t) deadline->tv_sec;
+    uint64_t nanoseconds = seconds > (UINT64_MAX - 999999999) / 1000000000
+                           ? UINT64_MAX - 1
+                           : seconds * 1000000000
+                             + (uint64_t) deadline->tv_nsec;
+    /* zero stands for no deadline so the earliest one is a nanosecond in */
+    if (!nanoseconds) {
+        nanoseconds = 1;
+    }
+    bool result;
+    if (!(result = submit(object, SQUID_EXECUTOR_PRIORITY_NORMAL,
+                          nanoseconds, self, function, args, out))) {
+        seagrass_required_true(is_enqueue_error());
+    }
+    seagrass_required_true(triggerfish_strong_release(self));
+    return result;
+}
+
+bool squid_executor_execute(struct squid_executor *const object,
+                            squid_function const function,
+                            void *const args) {
+    if (!object) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!function) {
+        squid_error = SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL;
+        return false;
+    }
+    if (!atomic_load(&object->is_running)) {
+        squid_error = SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN;
+        return false;
+    }
+    uint32_t index;
+    if (!squid_pool_acquire(&object->records, &index)) {
+        seagrass_required_true(SQUID_POOL_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    struct squid_executor_record *record;
+    seagrass_required_true(squid_pool_at(&object->records, index,
+                                         (void **) &record));
+    *record = (struct squid_executor_record) {
+            .task = {
+                    .function = function,
+                    .args = args
+            }
+    };
+    void *const item = record_item(index);
+    if (!enqueue(object, SQUID_EXECUTOR_PRIORITY_NORMAL, &item, 1)) {
+        seagrass_required_true(is_enqueue_error());
+        seagrass_required_true(squid_pool_release(&object->records, index));
+        return false;
+    }
+    return true;
+}
+
+static bool tasks_are_valid(const struct squid_executor_task *const tasks,
+                            const uintmax_t count) {
+    assert(tasks);
+    for (uintmax_t i = 0; i < count; i++) {
+        if (!tasks[i].function) {
+            return false;
         }
-        seagrass_required_true(!pthread_cond_signal(&task->condition));
-        seagrass_required_true(triggerfish_strong_release(out));
     }
-    seagrass_required_true(
-            LIONFISH_CONCURRENT_LINKED_QUEUE_SR_ERROR_QUEUE_IS_EMPTY
-            == lionfish_error);
-    seagrass_required_true(!pthread_mutex_lock(&executor->threads.mutex));
-    struct timespec tp;
-    seagrass_required_true(!clock_gettime(CLOCK_REALTIME, &tp));
-    seagrass_required_true((tp.tv_sec += 60) >= 0);
-    uintmax_t value;
-    seagrass_required_true(seagrass_uintmax_t_add(
-            1, atomic_fetch_add(&executor->threads.ready, 1), &value));
-    int error;
-    const struct triggerfish_strong *peek;
-    while (!lionfish_concurrent_linked_queue_sr_peek(&executor->tasks,
-                                                     &peek)) {
-        seagrass_required_true(
-                LIONFISH_CONCURRENT_LINKED_QUEUE_SR_ERROR_QUEUE_IS_EMPTY
-                == lionfish_error);
-        if (!(error = pthread_cond_timedwait(&executor->threads.condition,
-                                             &executor->threads.mutex,
-                                             &tp))
-            || ETIMEDOUT == error) {
+    return true;
+}
+
+static void release_all(struct triggerfish_strong **const futures,
+                        const uintmax_t count) {
+    assert(futures);
+    for (uintmax_t i = 0; i < count; i++) {
+        seagrass_required_true(triggerfish_strong_release(futures[i]));
+    }
+}
+
+static bool submit_all(struct squid_executor *const object,
+                       struct triggerfish_strong *const executor,
+                       const struct squid_executor_task *const tasks,
+                       const uintmax_t count,
+                       struct triggerfish_strong **const out) {
+    assert(object);
+    assert(executor);
+    assert(tasks);
+    assert(count);
+    assert(out);
+    for (uintmax_t i = 0; i < count; i++) {
+        if (!squid_future_of(executor, tasks[i].function, tasks[i].args,
+                             &out[i])) {
+            seagrass_required_true(SQUID_FUTURE_ERROR_MEMORY_ALLOCATION_FAILED
+                                   == squid_error);
+            release_all(out, i);
+            squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
+            return false;
+        }
+        seagrass_required_true(triggerfish_strong_retain(out[i]));
+    }
+    if (!enqueue(object, SQUID_EXECUTOR_PRIORITY_NORMAL, (void **) out,
+                 count)) {
+        seagrass_required_true(is_enqueue_error());
+        release_all(out, count);
+        release_all(out, count);
+        return false;
+    }
+    return true;
+}
+
+bool squid_executor_submit_all(struct squid_executor *const object,
+                               const struct squid_executor_task *const tasks,
+                               const uintmax_t count,
+                               struct triggerfish_strong **const out) {
+    if (!object) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!tasks) {
+        squid_error = SQUID_EXECUTOR_ERROR_TASKS_IS_NULL;
+        return false;
+    }
+    if (!count) {
+        squid_error = SQUID_EXECUTOR_ERROR_COUNT_IS_ZERO;
+        return false;
+    }
+    if (!tasks_are_valid(tasks, count)) {
+        squid_error = SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_EXECUTOR_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    if (!atomic_load(&object->is_running)) {
+        squid_error = SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN;
+        return false;
+    }
+    struct triggerfish_strong *self;
+    if (!triggerfish_weak_strong(object->self, &self)) {
+        seagrass_required_true(TRIGGERFISH_WEAK_ERROR_STRONG_IS_INVALID
+                               == triggerfish_error);
+        squid_error = SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN;
+        return false;
+    }
+    bool result;
+    if (!(result = submit_all(object, self, tasks, count, out))) {
+        seagrass_required_true(is_enqueue_error());
+    }
+    seagrass_required_true(triggerfish_strong_release(self));
+    return result;
+}
+
+bool squid_executor_execute_all(struct squid_executor *const object,
+                                const struct squid_executor_task *const tasks,
+                                const uintmax_t count) {
+    if (!object) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!tasks) {
+        squid_error = SQUID_EXECUTOR_ERROR_TASKS_IS_NULL;
+        return false;
+    }
+    if (!count) {
+        squid_error = SQUID_EXECUTOR_ERROR_COUNT_IS_ZERO;
+        return false;
+    }
+    if (!tasks_are_valid(tasks, count)) {
+        squid_error = SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL;
+        return false;
+    }
+    if (!atomic_load(&object->is_running)) {
+        squid_error = SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN;
+        return false;
+    }
+    if (count > SIZE_MAX / sizeof(void *)) {
+        squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    void **const items = malloc(count * sizeof(void *));
+    if (!items) {
+        squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    uintmax_t i = 0;
+    for (; i < count; i++) {
+        uint32_t index;
+        if (!squid_pool_acquire(&object->records, &index)) {
+            seagrass_required_true(SQUID_POOL_ERROR_MEMORY_ALLOCATION_FAILED
+                                   == squid_error);
+            squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
             break;
         }
+        struct squid_executor_record *record;
+        seagrass_required_true(squid_pool_at(&object->records, index,
+                                             (void **) &record));
+        *record = (struct squid_executor_record) {
+                .task = tasks[i]
+        };
+        items[i] = record_item(index);
     }
-    seagrass_required_true(!pthread_mutex_unlock(&executor->threads.mutex));
-    seagrass_required_true(seagrass_uintmax_t_subtract(
-            atomic_fetch_sub(&executor->threads.ready, 1), 1, &value));
-    if (atomic_load(&executor->is_running)
-        && (!error
-            || lionfish_concurrent_linked_queue_sr_peek(&executor->tasks,
-                                                        &peek))) {
-        goto loop;
+    const bool result = i == count
+                        && enqueue(object, SQUID_EXECUTOR_PRIORITY_NORMAL,
+                                   items, count);
+    if (!result) {
+        seagrass_required_true(is_enqueue_error());
+        while (i) {
+            seagrass_required_true(squid_pool_release(
+                    &object->records, record_index(items[--i])));
+        }
+    }
+    free(items);
+    return result;
+}
+
+bool squid_executor_deadline(const void *const item, uint64_t *const out) {
+    if (!item) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_EXECUTOR_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    *out = UINT64_MAX;
+    if (is_record(item)) {
+        return true;
+    }
+    struct squid_future *future;
+    seagrass_required_true(triggerfish_strong_instance(
+            (struct triggerfish_strong *) item, (void **) &future));
+    if (future->deadline) {
+        *out = future->deadline;
+    }
+    return true;
+}
+
+bool squid_executor_resume(struct squid_future *const future) {
+    if (!future) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    struct squid_executor *executor;
+    seagrass_required_true(triggerfish_strong_instance(
+            future->executor, (void **) &executor));
+    if (future->is_inline) {
+        run(executor, future);
+        return true;
+    }
+    void *const item = future->self;
+    seagrass_required_true(triggerfish_strong_retain(item));
+    if (atomic_load(&executor->is_running)) {
+        if (enqueue(executor, SQUID_EXECUTOR_PRIORITY_NORMAL, &item, 1)) {
+            return true;
+        }
+        seagrass_required_true(is_enqueue_error());
+    }
+    seagrass_required_true(triggerfish_strong_release(item));
+    if (!squid_future_cancel(future, NULL)) {
+        seagrass_required_true(SQUID_FUTURE_ERROR_FUTURE_IS_DONE
+                               == squid_error);
+    }
+    advance(future);
+    return true;
+}
+
+bool squid_executor_help(struct squid_future *const future) {
+    if (!future) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    struct squid_executor *executor;
+    if (!home
+        || !triggerfish_strong_instance(future->executor, (void **) &executor)
+        || home != executor) {
+        squid_error = SQUID_EXECUTOR_ERROR_IS_NOT_WORKER;
+        return false;
+    }
+    /* whoever takes it off the queue later on finds it is no longer pending
+     * and only has its strand move on, timed ones must wait until due */
+    if (!future->schedule.is_timed
+        && SQUID_FUTURE_STATUS_PENDING == atomic_load(&future->status)
+        && atomic_exchange(&future->is_queued, false)) {
+        invoke(executor, future, true);
+        seagrass_required_true(squid_future_notify(future));
+        return true;
+    }
+    void *item;
+    if (!next(executor, &item)) {
+        squid_error = SQUID_EXECUTOR_ERROR_IS_IDLE;
+        return false;
+    }
+    perform(executor, item);
+    return true;
+}
+
+bool squid_executor_doze(struct squid_future *const future,
+                         const int status,
+                         const struct timespec *const deadline) {
+    if (!future) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    struct squid_executor *executor;
+    if (!home
+        || !triggerfish_strong_instance(future->executor, (void **) &executor)
+        || home != executor) {
+        squid_error = SQUID_EXECUTOR_ERROR_IS_NOT_WORKER;
+        return false;
+    }
+    const int epoch = atomic_load(&executor->threads.epoch);
+    uintmax_t value;
+    atomic_fetch_add(&future->helpers, 1);
+    seagrass_required_true(seagrass_uintmax_t_add(
+            1, atomic_fetch_add(&executor->threads.sleeping, 1), &value));
+    /* pairs with the fences in notify() and squid_future_notify() so that
+     * either we see the task or the status, or we are woken up */
+    atomic_thread_fence(memory_order_seq_cst);
+    bool result = true;
+    if (status == atomic_load(&future->status) && is_idle(executor)
+        && !(result = squid_futex_wait(&executor->threads.epoch, epoch,
+                                       deadline))) {
+        seagrass_required_true(SQUID_FUTEX_ERROR_TIMED_OUT == squid_error);
+        squid_error = SQUID_EXECUTOR_ERROR_TIMED_OUT;
     }
     seagrass_required_true(seagrass_uintmax_t_subtract(
-            atomic_fetch_sub(&executor->threads.count, 1), 1, &value));
+            atomic_fetch_sub(&executor->threads.sleeping, 1), 1, &value));
+    atomic_fetch_sub(&future->helpers, 1);
+    return result;
+}
+
+bool squid_executor_rouse(struct squid_future *const future) {
+    if (!future) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (atomic_load(&future->helpers)) {
+        struct squid_executor *executor;
+        seagrass_required_true(triggerfish_strong_instance(
+                future->executor, (void **) &executor));
+        /* the idle threads among them go back to sleep */
+        wake(executor, UINTMAX_MAX);
+    }
+    return true;
+}
+
+/* futures taken off the wheel, in the order they came due */
+struct expired {
+    struct squid_future *first;
+    struct squid_future **last;
+};
+
+static void collect(struct squid_wheel_timer *const timer, void *const args) {
+    assert(timer);
+    assert(args);
+    struct expired *const expired = args;
+    struct squid_future *const future = (struct squid_future *)
+            ((char *) timer - offsetof(struct squid_future, schedule.timer));
+    future->schedule.expired = NULL;
+    *expired->last = future;
+    expired->last = &future->schedule.expired;
+}
+
+static uintmax_t unschedule_all(struct squid_executor *const object) {
+    assert(object);
+    struct expired expired = {.last = &expired.first};
+    uintmax_t count;
+    seagrass_required_true(!pthread_mutex_lock(&object->timer.mutex));
+    seagrass_required_true(squid_wheel_drain(&object->timer.wheel, collect,
+                                             &expired, &count));
+    /* timer thread finds out that it is no longer needed */
+    atomic_fetch_add(&object->timer.epoch, 1);
+    seagrass_required_true(!pthread_mutex_unlock(&object->timer.mutex));
+    seagrass_required_true(squid_futex_wake(&object->timer.epoch, 1));
+    /* cancelling takes the timer mutex so it must wait until here */
+    for (struct squid_future *next = expired.first; next;) {
+        struct squid_future *const future = next;
+        next = future->schedule.expired;
+        discard(object, future->self);
+    }
+    return count;
+}
+
+static void fire(struct squid_executor *const object,
+                 struct squid_future *next) {
+    assert(object);
+    while (next) {
+        struct squid_future *const future = next;
+        next = future->schedule.expired;
+        /* reference held by the wheel is handed over to the queue */
+        void *const item = future->self;
+        /* waiting for room or running the task here would hold up every
+         * other timer, so a task that does not fit is cancelled instead */
+        const enum squid_executor_rejection rejection
+                = SQUID_EXECUTOR_REJECTION_DISCARD_OLDEST
+                  == object->options.queue.rejection
+                  ? SQUID_EXECUTOR_REJECTION_DISCARD_OLDEST
+                  : SQUID_EXECUTOR_REJECTION_FAIL;
+        if (atomic_load(&object->is_running)) {
+            if (admit(object, SQUID_EXECUTOR_PRIORITY_NORMAL, &item, 1,
+                      rejection)) {
+                continue;
+            }
+            seagrass_required_true(is_enqueue_error());
+        }
+        discard(object, item);
+    }
+}
+
+static void *timekeeper(void *args) {
+    seagrass_required(args);
+    (void) pthread_detach(pthread_self());
+    /* reference handed over by arm() */
+    struct triggerfish_strong *const self = args;
+    struct squid_executor *executor;
+    seagrass_required_true(triggerfish_strong_instance(
+            self, (void **) &executor));
+    while (true) {
+        const int epoch = atomic_load(&executor->timer.epoch);
+        struct expired expired = {.last = &expired.first};
+        uintmax_t count;
+        uint64_t tick;
+        seagrass_required_true(!pthread_mutex_lock(&executor->timer.mutex));
+        const bool is_idle = !atomic_load(&executor->is_running)
+                             || !executor->timer.wheel.count;
+        if (is_idle) {
+            executor->timer.is_started = false;
+        } else {
+            seagrass_required_true(squid_wheel_advance(
+                    &executor->timer.wheel, ticks(), collect, &expired,
+                    &count));
+            if (!squid_wheel_next(&executor->timer.wheel, &tick)) {
+                seagrass_required_true(SQUID_WHEEL_ERROR_WHEEL_IS_EMPTY
+                                       == squid_error);
+                tick = 0;
+            }
+            executor->timer.deadline = tick;
+        }
+        seagrass_required_true(!pthread_mutex_unlock(&executor->timer.mutex));
+        if (is_idle) {
+            break;
+        }
+        fire(executor, expired.first);
+        if (!tick) {
+            continue;
+        }
+        const struct timespec deadline = {
+                .tv_sec = (time_t) (tick / 1000),
+                .tv_nsec = (long) (tick % 1000) * 1000000
+        };
+        if (!squid_futex_wait(&executor->timer.epoch, epoch, &deadline)) {
+            seagrass_required_true(SQUID_FUTEX_ERROR_TIMED_OUT
+                                   == squid_error);
+        }
+    }
+    /* executor may be gone once we let go of it */
     seagrass_required_true(triggerfish_strong_release(self));
     return NULL;
 }
 
-static bool enqueue(struct squid_executor *const object,
-                    struct triggerfish_strong *const future) {
+/* must be called with the timer mutex held, on success the wheel holds a
+ * reference to future and out is set if the timer thread is to be woken */
+static bool arm(struct squid_executor *const object,
+                struct triggerfish_strong *const executor,
+                struct squid_future *const future,
+                const uint64_t expiry,
+                bool *const out) {
     assert(object);
+    assert(executor);
     assert(future);
-    if (!atomic_load(&object->threads.ready)) {
+    assert(out);
+    if (!object->timer.is_started) {
+        seagrass_required_true(triggerfish_strong_retain(executor));
         pthread_t thread;
         int error;
-        if ((error = pthread_create(&thread, NULL, routine, object))) {
+        if ((error = pthread_create(&thread, NULL, timekeeper, executor))) {
             seagrass_required_true(EAGAIN == error);
-            if (!atomic_load(&object->threads.count)) {
-                squid_error = SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED;
-                return false;
-            }
+            seagrass_required_true(triggerfish_strong_release(executor));
+            squid_error = SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED;
+            return false;
         }
-        uintmax_t value;
-        seagrass_required_true(seagrass_uintmax_t_add(
-                1, atomic_fetch_add(&object->threads.count, 1), &value));
+        object->timer.is_started = true;
+        object->timer.deadline = UINT64_MAX;
     }
-    if (!lionfish_concurrent_linked_queue_sr_add(&object->tasks, future)) {
-        seagrass_required_true(
-                LIONFISH_CONCURRENT_LINKED_QUEUE_SR_ERROR_MEMORY_ALLOCATION_FAILED
-                == lionfish_error);
-        squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
-        return false;
+    seagrass_required_true(triggerfish_strong_retain(future->self));
+    seagrass_required_true(squid_wheel_add(&object->timer.wheel,
+                                           &future->schedule.timer, expiry));
+    *out = expiry < object->timer.deadline;
+    if (*out) {
+        /* spare the timer thread a wake up per task in a burst */
+        object->timer.deadline = expiry;
+        atomic_fetch_add(&object->timer.epoch, 1);
     }
-    seagrass_required_true(!pthread_cond_signal(&object->threads.condition));
     return true;
 }
 
-static bool submit(struct squid_executor *const object,
-                   struct triggerfish_strong *const executor,
-                   squid_function const function,
-                   void *const args,
-                   struct triggerfish_strong **const out) {
-    assert(object);
+static bool rearm(struct squid_executor *const executor,
+                  struct squid_future *const future) {
     assert(executor);
+    assert(future);
+    const uint64_t period = future->schedule.period;
+    if (!period || future->error) {
+        return false;
+    }
+    if (future->out) {
+        seagrass_required_true(triggerfish_strong_release(future->out));
+        future->out = NULL;
+    }
+    const uint64_t expiry = future->schedule.timer.expiry;
+    bool result = false;
+    bool is_woken = false;
+    seagrass_required_true(!pthread_mutex_lock(&executor->timer.mutex));
+    enum squid_future_status expected = SQUID_FUTURE_STATUS_RUNNING;
+    /* shutdown drains the wheel after it stops running, so once we see it
+     * running under the mutex our timer will not be left behind */
+    if (atomic_load(&executor->is_running)
+        && atomic_compare_exchange_strong(&future->status, (int *) &expected,
+                                          SQUID_FUTURE_STATUS_PENDING)) {
+        if (!(result = arm(executor, future->executor, future,
+                           expiry > UINT64_MAX - period
+                           ? UINT64_MAX
+                           : expiry + period, &is_woken))) {
+            seagrass_required_true(SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED
+                                   == squid_error);
+            atomic_store(&future->status, SQUID_FUTURE_STATUS_CANCELLED);
+        }
+    }
+    seagrass_required_true(!pthread_mutex_unlock(&executor->timer.mutex));
+    if (is_woken) {
+        seagrass_required_true(squid_futex_wake(&executor->timer.epoch, 1));
+    }
+    return result;
+}
+
+static bool schedule(struct squid_executor *const object,
+                     const uintmax_t delay,
+                     const uintmax_t period,
+                     squid_function const function,
+                     void *const args,
+                     struct triggerfish_strong **const out) {
+    assert(object);
     assert(function);
     assert(out);
-    struct triggerfish_strong *future;
-    if (!squid_future_of(executor, function, args, &future)) {
+    if (!atomic_load(&object->is_running)) {
+        squid_error = SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN;
+        return false;
+    }
+    struct triggerfish_strong *self;
+    if (!triggerfish_weak_strong(object->self, &self)) {
+        seagrass_required_true(TRIGGERFISH_WEAK_ERROR_STRONG_IS_INVALID
+                               == triggerfish_error);
+        squid_error = SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN;
+        return false;
+    }
+    struct triggerfish_strong *item;
+    if (!squid_future_of(self, function, args, &item)) {
         seagrass_required_true(SQUID_FUTURE_ERROR_MEMORY_ALLOCATION_FAILED
                                == squid_error);
+        seagrass_required_true(triggerfish_strong_release(self));
         squid_error = SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED;
         return false;
     }
-    if (!enqueue(object, future)) {
+    struct squid_future *future;
+    seagrass_required_true(triggerfish_strong_instance(
+            item, (void **) &future));
+    future->schedule.period = period > UINT64_MAX ? UINT64_MAX : period;
+    future->schedule.is_timed = true;
+    const uint64_t now = ticks();
+    const uint64_t expiry = delay > UINT64_MAX - now
+                            ? UINT64_MAX
+                            : now + delay;
+    bool result = false;
+    bool is_woken = false;
+    seagrass_required_true(!pthread_mutex_lock(&object->timer.mutex));
+    if (!atomic_load(&object->is_running)) {
+        squid_error = SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN;
+    } else if (!(result = arm(object, self, future, expiry, &is_woken))) {
         seagrass_required_true(SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED
-                               == squid_error
-                               || SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED
-                                  == squid_error);
-        seagrass_required_true(triggerfish_strong_release(future));
+                               == squid_error);
+    }
+    seagrass_required_true(!pthread_mutex_unlock(&object->timer.mutex));
+    if (is_woken) {
+        seagrass_required_true(squid_futex_wake(&object->timer.epoch, 1));
+    }
+    seagrass_required_true(triggerfish_strong_release(self));
+    if (!result) {
+        seagrass_required_true(triggerfish_strong_release(item));
         return false;
     }
-    *out = future;
+    *out = item;
     return true;
 }
 
-bool squid_executor_submit(struct squid_executor *const object,
-                           squid_function const function,
-                           void *const args,
-                           struct triggerfish_strong **const out) {
+bool squid_executor_schedule(struct squid_executor *const object,
+                             const uintmax_t delay,
+                             squid_function const function,
+                             void *const args,
+                             struct triggerfish_strong **const out) {
     if (!object) {
         squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
         return false;
@@ -393,26 +2412,55 @@ bool squid_executor_submit(struct squid_executor *const object,
         squid_error = SQUID_EXECUTOR_ERROR_OUT_IS_NULL;
         return false;
     }
-    bool result;
-    seagrass_required_true(squid_executor_is_running(object, &result));
-    if (!result) {
-        squid_error = SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN;
+    return schedule(object, delay, 0, function, args, out);
+}
+
+bool squid_executor_schedule_at_fixed_rate(
+        struct squid_executor *const object,
+        const uintmax_t delay,
+        const uintmax_t period,
+        squid_function const function,
+        void *const args,
+        struct triggerfish_strong **const out) {
+    if (!object) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
         return false;
     }
-    struct triggerfish_strong *self;
-    if (!triggerfish_weak_strong(object->self, &self)) {
-        seagrass_required_true(TRIGGERFISH_WEAK_ERROR_STRONG_IS_INVALID
-                               == triggerfish_error);
-        squid_error = SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN;
+    if (!period) {
+        squid_error = SQUID_EXECUTOR_ERROR_PERIOD_IS_ZERO;
         return false;
     }
-    if (!(result = submit(object, self, function, args, out))) {
-        seagrass_required_true(SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED
-                               == squid_error
-                               || SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED
-                                  == squid_error);
+    if (!function) {
+        squid_error = SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL;
+        return false;
     }
-    seagrass_required_true(triggerfish_strong_release(self));
-    return result;
+    if (!out) {
+        squid_error = SQUID_EXECUTOR_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    return schedule(object, delay, period, function, args, out);
 }
 
+bool squid_executor_unschedule(struct squid_future *const future) {
+    if (!future) {
+        squid_error = SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    struct squid_executor *executor;
+    seagrass_required_true(triggerfish_strong_instance(
+            future->executor, (void **) &executor));
+    bool is_armed;
+    seagrass_required_true(!pthread_mutex_lock(&executor->timer.mutex));
+    seagrass_required_true(squid_wheel_is_armed(&future->schedule.timer,
+                                                &is_armed));
+    if (is_armed) {
+        seagrass_required_true(squid_wheel_remove(&executor->timer.wheel,
+                                                  &future->schedule.timer));
+    }
+    seagrass_required_true(!pthread_mutex_unlock(&executor->timer.mutex));
+    if (is_armed) {
+        /* caller still holds a reference of its own */
+        seagrass_required_true(triggerfish_strong_release(future->self));
+    }
+    return true;
+}
@@ -0,0 +1,139 @@
+#include <stdlib.h>
+#include <limits.h>
+#include <errno.h>
+#include <seagrass.h>
+#include <squid.h>
+
+#include "private/futex.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#else
+#include <pthread.h>
+#endif
+
+#ifdef TEST
+#include <test/cmocka.h>
+#endif
+
+#if defined(__linux__)
+
+bool squid_futex_wait(atomic_int *const object,
+                      const int expected,
+                      const struct timespec *const deadline) {
+    if (!object) {
+        squid_error = SQUID_FUTEX_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    /* FUTEX_WAIT_BITSET uses an absolute CLOCK_MONOTONIC deadline */
+    if (-1 == syscall(SYS_futex, object,
+                      FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG, expected,
+                      deadline, NULL, FUTEX_BITSET_MATCH_ANY)) {
+        if (ETIMEDOUT == errno) {
+            squid_error = SQUID_FUTEX_ERROR_TIMED_OUT;
+            return false;
+        }
+        seagrass_required_true(EAGAIN == errno || EINTR == errno);
+    }
+    return true;
+}
+
+bool squid_futex_wake(atomic_int *const object, const uintmax_t count) {
+    if (!object) {
+        squid_error = SQUID_FUTEX_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    seagrass_required_true(-1 != syscall(
+            SYS_futex, object, FUTEX_WAKE | FUTEX_PRIVATE_FLAG,
+            count > INT_MAX ? INT_MAX : (int) count, NULL, NULL, 0));
+    return true;
+}
+
+#else
+
+/*
+ * Without futexes we hash the address onto a fixed table of mutex and
+ * condition pairs. The value is checked under the bucket's mutex so a wake
+ * which takes the same mutex after changing the value is never lost.
+ */
+#define BUCKETS                                             64
+
+static struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+} buckets[BUCKETS];
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+static void initialize(void) {
+    for (uintmax_t i = 0; i < BUCKETS; i++) {
+        seagrass_required_true(!pthread_mutex_init(&buckets[i].mutex, NULL));
+        seagrass_required_true(!pthread_cond_init(&buckets[i].condition,
+                                                  NULL));
+    }
+}
+
+static uintmax_t bucket(const atomic_int *const object) {
+    const uintptr_t address = (uintptr_t) object;
+    return ((address >> 2) ^ (address >> 9)) % BUCKETS;
+}
+
+bool squid_futex_wait(atomic_int *const object,
+                      const int expected,
+                      const struct timespec *const deadline) {
+    if (!object) {
+        squid_error = SQUID_FUTEX_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    seagrass_required_true(!pthread_once(&once, initialize));
+    const uintmax_t i = bucket(object);
+    struct timespec tp;
+    if (deadline) {
+        /* condition variables wait against CLOCK_REALTIME */
+        struct timespec now;
+        seagrass_required_true(!clock_gettime(CLOCK_MONOTONIC, &now));
+        intmax_t nsec = (intmax_t) (deadline->tv_sec - now.tv_sec)
+                        * 1000000000 + (deadline->tv_nsec - now.tv_nsec);
+        if (nsec <= 0) {
+            squid_error = SQUID_FUTEX_ERROR_TIMED_OUT;
+            return false;
+        }
+        seagrass_required_true(!clock_gettime(CLOCK_REALTIME, &tp));
+        nsec += tp.tv_nsec;
+        tp.tv_sec += nsec / 1000000000;
+        tp.tv_nsec = nsec % 1000000000;
+    }
+    seagrass_required_true(!pthread_mutex_lock(&buckets[i].mutex));
+    int error = 0;
+    if (expected == atomic_load(object)) {
+        error = deadline
+                ? pthread_cond_timedwait(&buckets[i].condition,
+                                         &buckets[i].mutex, &tp)
+                : pthread_cond_wait(&buckets[i].condition,
+                                    &buckets[i].mutex);
+    }
+    seagrass_required_true(!pthread_mutex_unlock(&buckets[i].mutex));
+    if (ETIMEDOUT == error) {
+        squid_error = SQUID_FUTEX_ERROR_TIMED_OUT;
+        return false;
+    }
+    seagrass_required_true(!error);
+    return true;
+}
+
+bool squid_futex_wake(atomic_int *const object, const uintmax_t count) {
+    if (!object) {
+        squid_error = SQUID_FUTEX_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    seagrass_required_true(!pthread_once(&once, initialize));
+    const uintmax_t i = bucket(object);
+    seagrass_required_true(!pthread_mutex_lock(&buckets[i].mutex));
+    /* buckets are shared between addresses so wake everyone up */
+    seagrass_required_true(!pthread_cond_broadcast(&buckets[i].condition));
+    seagrass_required_true(!pthread_mutex_unlock(&buckets[i].mutex));
+    return true;
+}
+
+#endif
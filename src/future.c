@@ -1,27 +1,75 @@
 #include <stdlib.h>
 #include <assert.h>
-#include <errno.h>
 #include <seagrass.h>
 #include <squid.h>
 
 #include "private/future.h"
+#include "private/futex.h"
+#include "private/executer.h"
 
 #ifdef TEST
 #include <test/cmocka.h>
 #endif
 
+/* marks the continuations of a future as having been resumed */
+static struct squid_future_link closed;
+
+static void cancel(struct squid_future *const object) {
+    assert(object);
+    if (!squid_future_cancel(object, NULL)) {
+        seagrass_required_true(SQUID_FUTURE_ERROR_FUTURE_IS_DONE
+                               == squid_error);
+    }
+}
+
+static void resume(struct squid_future *object,
+                   struct squid_future_link *link);
+
 static void invalidate(struct squid_future *const object) {
     assert(object);
-    int error;
-    if ((error = pthread_mutex_destroy(&object->mutex))) {
-        seagrass_required_true(error == EINVAL);
+    struct squid_future_link *next = atomic_exchange(&object->continuations,
+                                                     NULL);
+    if (&closed != next) {
+        /* object never completed so its dependents see it as cancelled */
+        while (next) {
+            struct squid_future_link *const link = next;
+            next = link->next;
+            resume(object, link);
+        }
     }
-    if ((error = pthread_cond_destroy(&object->condition))) {
-        seagrass_required_true(error == EINVAL);
+    triggerfish_strong_release(object->link.reference);
+    if (object->combinator.links) {
+        for (uintmax_t i = 0; i < object->combinator.count; i++) {
+            triggerfish_strong_release(
+                    object->combinator.links[i].reference);
+        }
+        free(object->combinator.links);
     }
     triggerfish_strong_release(object->out);
     triggerfish_strong_release(object->executor);
+    triggerfish_strong_release(object->strand);
+    *object = (struct squid_future) {0};
+}
+
+/* function is NULL for combinators, which are completed by their inputs */
+static bool init(struct squid_future *const object,
+                 struct triggerfish_strong *const executor,
+                 squid_function const function,
+                 void *const args) {
+    assert(object);
+    assert(executor);
     *object = (struct squid_future) {0};
+    if (!triggerfish_strong_retain(executor)) {
+        seagrass_required_true(TRIGGERFISH_STRONG_ERROR_OBJECT_IS_INVALID
+                               == triggerfish_error);
+        invalidate(object);
+        squid_error = SQUID_FUTURE_ERROR_EXECUTOR_IS_INVALID;
+        return false;
+    }
+    object->executor = executor;
+    object->function = function;
+    object->args = args;
+    return true;
 }
 
 bool squid_future_init(struct squid_future *const object,
@@ -40,30 +88,7 @@ bool squid_future_init(struct squid_future *const object,
         squid_error = SQUID_FUTURE_ERROR_FUNCTION_IS_NULL;
         return false;
     }
-    *object = (struct squid_future) {0};
-    int error;
-    if ((error = pthread_mutex_init(&object->mutex, NULL))) {
-        seagrass_required_true(ENOMEM == error);
-        squid_error = SQUID_FUTURE_ERROR_MEMORY_ALLOCATION_FAILED;
-        return false;
-    }
-    if ((error = pthread_cond_init(&object->condition, NULL))) {
-        seagrass_required_true(ENOMEM == error);
-        invalidate(object);
-        squid_error = SQUID_FUTURE_ERROR_MEMORY_ALLOCATION_FAILED;
-        return false;
-    }
-    if (!triggerfish_strong_retain(executor)) {
-        seagrass_required_true(TRIGGERFISH_STRONG_ERROR_OBJECT_IS_INVALID
-                               == triggerfish_error);
-        invalidate(object);
-        squid_error = SQUID_FUTURE_ERROR_EXECUTOR_IS_INVALID;
-        return false;
-    }
-    object->executor = executor;
-    object->function = function;
-    object->args = args;
-    return true;
+    return init(object, executor, function, args);
 }
 
 bool squid_future_invalidate(struct squid_future *const object) {
@@ -79,28 +104,18 @@ static void on_destroy(void *const object) {
     seagrass_required_true(squid_future_invalidate(object));
 }
 
-bool squid_future_of(struct triggerfish_strong *const executor,
-                     squid_function const function,
-                     void *const args,
-                     struct triggerfish_strong **const out) {
-    if (!executor) {
-        squid_error = SQUID_FUTURE_ERROR_EXECUTOR_IS_NULL;
-        return false;
-    }
-    if (!function) {
-        squid_error = SQUID_FUTURE_ERROR_FUNCTION_IS_NULL;
-        return false;
-    }
-    if (!out) {
-        squid_error = SQUID_FUTURE_ERROR_OUT_IS_NULL;
-        return false;
-    }
+static bool of(struct triggerfish_strong *const executor,
+               squid_function const function,
+               void *const args,
+               struct triggerfish_strong **const out) {
+    assert(executor);
+    assert(out);
     struct squid_future *object = malloc(sizeof(*object));
     if (!object) {
         squid_error = SQUID_FUTURE_ERROR_MEMORY_ALLOCATION_FAILED;
         return false;
     }
-    if (!squid_future_init(object, executor, function, args)) {
+    if (!init(object, executor, function, args)) {
         seagrass_required_true(SQUID_FUTURE_ERROR_EXECUTOR_IS_INVALID
                                == squid_error);
         free(object);
@@ -118,6 +133,25 @@ bool squid_future_of(struct triggerfish_strong *const executor,
     return true;
 }
 
+bool squid_future_of(struct triggerfish_strong *const executor,
+                     squid_function const function,
+                     void *const args,
+                     struct triggerfish_strong **const out) {
+    if (!executor) {
+        squid_error = SQUID_FUTURE_ERROR_EXECUTOR_IS_NULL;
+        return false;
+    }
+    if (!function) {
+        squid_error = SQUID_FUTURE_ERROR_FUNCTION_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_FUTURE_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    return of(executor, function, args, out);
+}
+
 bool squid_future_status(const struct squid_future *object,
                          enum squid_future_status *out) {
     if (!object) {
@@ -151,30 +185,127 @@ bool squid_future_cancel(struct squid_future *const object,
             return false;
         }
     }
+    seagrass_required_true(squid_future_notify(object));
+    if (object->schedule.is_timed) {
+        /* do not leave the timer to linger until it would have come due */
+        seagrass_required_true(squid_executor_unschedule(object));
+    }
     return true;
 }
 
-bool squid_future_get(struct squid_future *const object,
-                      struct triggerfish_strong **const out,
-                      uintmax_t *const error) {
+static void complete(struct squid_future *const object) {
+    assert(object);
+    enum squid_future_status expected = SQUID_FUTURE_STATUS_PENDING;
+    /* fails if the combinator itself was cancelled in the meantime */
+    atomic_compare_exchange_strong(&object->status, (int *) &expected,
+                                   SQUID_FUTURE_STATUS_DONE);
+    seagrass_required_true(squid_future_notify(object));
+}
+
+static void combine(struct squid_future_link *const link) {
+    assert(link);
+    struct squid_future *const object = link->future;
+    if (!object->combinator.is_any) {
+        if (1 == atomic_fetch_sub(&object->combinator.remaining, 1)) {
+            complete(object);
+        }
+        return;
+    }
+    if (!atomic_exchange(&object->combinator.remaining, 0)) {
+        return;
+    }
+    /* the winner is reported through the error of the combinator */
+    object->error = link - object->combinator.links;
+    complete(object);
+    if (!object->combinator.is_cancelling) {
+        return;
+    }
+    for (uintmax_t i = 0; i < object->combinator.count; i++) {
+        struct squid_future_link *const other = &object->combinator.links[i];
+        if (other != link) {
+            cancel(other->antecedent);
+        }
+    }
+}
+
+static void resume(struct squid_future *const object,
+                   struct squid_future_link *const link) {
+    assert(object);
+    assert(link);
+    struct squid_future *const future = link->future;
+    /* future may be destroyed by the release below */
+    struct triggerfish_strong *const self = future->self;
+    if (future->combinator.links) {
+        combine(link);
+    } else if (SQUID_FUTURE_STATUS_DONE == atomic_load(&object->status)) {
+        seagrass_required_true(squid_executor_resume(future));
+    } else {
+        cancel(future);
+    }
+    seagrass_required_true(triggerfish_strong_release(self));
+}
+
+static void attach(struct squid_future *const object,
+                   struct squid_future_link *const link) {
+    assert(object);
+    assert(link);
+    /* reference held until the link has been resumed */
+    seagrass_required_true(triggerfish_strong_retain(link->future->self));
+    struct squid_future_link *next = atomic_load(&object->continuations);
+    do {
+        if (&closed == next) {
+            resume(object, link);
+            return;
+        }
+        link->next = next;
+    } while (!atomic_compare_exchange_weak(&object->continuations, &next,
+                                           link));
+}
+
+bool squid_future_notify(struct squid_future *const object) {
     if (!object) {
         squid_error = SQUID_FUTURE_ERROR_OBJECT_IS_NULL;
         return false;
     }
-    if (!out) {
-        squid_error = SQUID_FUTURE_ERROR_OUT_IS_NULL;
-        return false;
+    /* closed ahead of waking anyone so that continuations added by those
+     * who waited for future are resumed right away */
+    struct squid_future_link *next = atomic_exchange(&object->continuations,
+                                                     &closed);
+    /* pairs with the registration of waiters in squid_future_get() */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&object->waiters)) {
+        seagrass_required_true(squid_futex_wake(&object->status, UINTMAX_MAX));
     }
-    seagrass_required_true(!pthread_mutex_lock(&object->mutex));
-    while (SQUID_FUTURE_STATUS_DONE > atomic_load(&object->status)) {
-        seagrass_required_true(!pthread_cond_wait(
-                &object->condition, &object->mutex));
+    seagrass_required_true(squid_executor_rouse(object));
+    if (&closed == next) {
+        return true;
     }
-    seagrass_required_true(!pthread_cond_signal(&object->condition));
-    seagrass_required_true(!pthread_mutex_unlock(&object->mutex));
-    const enum squid_future_status status = atomic_load(&object->status);
+    /* continuations were pushed in reverse, resume them in order */
+    struct squid_future_link *reversed = NULL;
+    while (next) {
+        struct squid_future_link *const link = next;
+        next = link->next;
+        link->next = reversed;
+        reversed = link;
+    }
+    while (reversed) {
+        struct squid_future_link *const link = reversed;
+        reversed = link->next;
+        resume(object, link);
+    }
+    return true;
+}
+
+static bool retrieve(struct squid_future *const object,
+                     const int status,
+                     struct triggerfish_strong **const out,
+                     uintmax_t *const error) {
+    assert(object);
+    assert(out);
     if (SQUID_FUTURE_STATUS_CANCELLED == status) {
-        squid_error = SQUID_FUTURE_ERROR_FUTURE_IS_CANCELLED;
+        squid_error = atomic_load(&object->is_late)
+                      ? SQUID_FUTURE_ERROR_DEADLINE_HAS_PASSED
+                      : SQUID_FUTURE_ERROR_FUTURE_IS_CANCELLED;
         return false;
     }
     *out = object->out;
@@ -186,3 +317,244 @@ bool squid_future_get(struct squid_future *const object,
     }
     return true;
 }
+
+static bool get(struct squid_future *const object,
+                const struct timespec *const deadline,
+                struct triggerfish_strong **const out,
+                uintmax_t *const error) {
+    assert(object);
+    assert(out);
+    int status;
+    if (SQUID_FUTURE_STATUS_DONE > (status = atomic_load(&object->status))) {
+        atomic_fetch_add(&object->waiters, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        bool is_worker = true;
+        while (SQUID_FUTURE_STATUS_DONE
+               > (status = atomic_load(&object->status))) {
+            /* an executor thread runs queued tasks rather than sleep, which
+             * may well include the very one it is waiting for */
+            if (is_worker) {
+                if (squid_executor_help(object)) {
+                    continue;
+                }
+                if (SQUID_EXECUTOR_ERROR_IS_NOT_WORKER == squid_error) {
+                    is_worker = false;
+                } else {
+                    seagrass_required_true(SQUID_EXECUTOR_ERROR_IS_IDLE
+                                           == squid_error);
+                }
+            }
+            /* an executor thread is also woken up as tasks are queued so
+             * that it can help with them */
+            if (is_worker) {
+                if (squid_executor_doze(object, status, deadline)) {
+                    continue;
+                }
+                seagrass_required_true(SQUID_EXECUTOR_ERROR_TIMED_OUT
+                                       == squid_error);
+            } else if (squid_futex_wait(&object->status, status, deadline)) {
+                continue;
+            } else {
+                seagrass_required_true(SQUID_FUTEX_ERROR_TIMED_OUT
+                                       == squid_error);
+            }
+            /* the future may have completed as we timed out */
+            if (SQUID_FUTURE_STATUS_DONE
+                > (status = atomic_load(&object->status))) {
+                atomic_fetch_sub(&object->waiters, 1);
+                squid_error = SQUID_FUTURE_ERROR_TIMED_OUT;
+                return false;
+            }
+            break;
+        }
+        atomic_fetch_sub(&object->waiters, 1);
+    }
+    return retrieve(object, status, out, error);
+}
+
+bool squid_future_get(struct squid_future *const object,
+                      struct triggerfish_strong **const out,
+                      uintmax_t *const error) {
+    if (!object) {
+        squid_error = SQUID_FUTURE_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_FUTURE_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    return get(object, NULL, out, error);
+}
+
+bool squid_future_get_until(struct squid_future *const object,
+                            const struct timespec *const deadline,
+                            struct triggerfish_strong **const out,
+                            uintmax_t *const error) {
+    if (!object) {
+        squid_error = SQUID_FUTURE_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!deadline) {
+        squid_error = SQUID_FUTURE_ERROR_DEADLINE_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_FUTURE_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    if (deadline->tv_sec < 0 || deadline->tv_nsec < 0
+        || deadline->tv_nsec >= 1000000000) {
+        squid_error = SQUID_FUTURE_ERROR_DEADLINE_IS_INVALID;
+        return false;
+    }
+    return get(object, deadline, out, error);
+}
+
+bool squid_future_try_get(struct squid_future *const object,
+                          struct triggerfish_strong **const out,
+                          uintmax_t *const error) {
+    if (!object) {
+        squid_error = SQUID_FUTURE_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_FUTURE_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    const int status = atomic_load(&object->status);
+    if (SQUID_FUTURE_STATUS_DONE > status) {
+        squid_error = SQUID_FUTURE_ERROR_FUTURE_IS_NOT_READY;
+        return false;
+    }
+    return retrieve(object, status, out, error);
+}
+
+bool squid_future_then(struct squid_future *const object,
+                       struct squid_executor *const executor,
+                       squid_function const function,
+                       struct triggerfish_strong **const out) {
+    if (!object) {
+        squid_error = SQUID_FUTURE_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!function) {
+        squid_error = SQUID_FUTURE_ERROR_FUNCTION_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_FUTURE_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    /* inline continuations stay with the executor of their antecedent */
+    struct triggerfish_strong *strong = object->executor;
+    if (executor && (!atomic_load(&executor->is_running)
+                     || !triggerfish_weak_strong(executor->self, &strong))) {
+        squid_error = SQUID_FUTURE_ERROR_EXECUTOR_IS_BUSY_SHUTTING_DOWN;
+        return false;
+    }
+    struct triggerfish_strong *future;
+    const bool result = squid_future_of(strong, function, object, &future);
+    if (executor) {
+        seagrass_required_true(triggerfish_strong_release(strong));
+    }
+    if (!result) {
+        seagrass_required_true(SQUID_FUTURE_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        return false;
+    }
+    struct squid_future *continuation;
+    seagrass_required_true(triggerfish_strong_instance(
+            future, (void **) &continuation));
+    continuation->is_inline = !executor;
+    continuation->link = (struct squid_future_link) {
+            .future = continuation,
+            .antecedent = object
+    };
+    if (object->self) {
+        seagrass_required_true(triggerfish_strong_retain(object->self));
+        continuation->link.reference = object->self;
+    }
+    attach(object, &continuation->link);
+    *out = future;
+    return true;
+}
+
+static bool combinator_of(struct squid_future *const *const futures,
+                          const uintmax_t count,
+                          const bool is_any,
+                          const bool is_cancelling,
+                          struct triggerfish_strong **const out) {
+    if (!futures) {
+        squid_error = SQUID_FUTURE_ERROR_FUTURES_IS_NULL;
+        return false;
+    }
+    if (!count) {
+        squid_error = SQUID_FUTURE_ERROR_COUNT_IS_ZERO;
+        return false;
+    }
+    for (uintmax_t i = 0; i < count; i++) {
+        if (!futures[i]) {
+            squid_error = SQUID_FUTURE_ERROR_FUTURES_IS_NULL;
+            return false;
+        }
+    }
+    if (!out) {
+        squid_error = SQUID_FUTURE_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    if (count > SIZE_MAX / sizeof(struct squid_future_link)) {
+        squid_error = SQUID_FUTURE_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    struct squid_future_link *const links = calloc(count, sizeof(*links));
+    if (!links) {
+        squid_error = SQUID_FUTURE_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    struct triggerfish_strong *future;
+    /* without a function it is never run, its inputs complete it */
+    if (!of(futures[0]->executor, NULL, NULL, &future)) {
+        seagrass_required_true(SQUID_FUTURE_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        free(links);
+        return false;
+    }
+    struct squid_future *object;
+    seagrass_required_true(triggerfish_strong_instance(
+            future, (void **) &object));
+    object->combinator.links = links;
+    object->combinator.count = count;
+    object->combinator.is_any = is_any;
+    object->combinator.is_cancelling = is_cancelling;
+    atomic_init(&object->combinator.remaining, is_any ? 1 : count);
+    /* every link must be complete before the first one can be resumed */
+    for (uintmax_t i = 0; i < count; i++) {
+        links[i] = (struct squid_future_link) {
+                .future = object,
+                .antecedent = futures[i],
+                .reference = futures[i]->self
+        };
+        if (links[i].reference) {
+            seagrass_required_true(triggerfish_strong_retain(
+                    links[i].reference));
+        }
+    }
+    for (uintmax_t i = 0; i < count; i++) {
+        attach(futures[i], &links[i]);
+    }
+    *out = future;
+    return true;
+}
+
+bool squid_future_when_all(struct squid_future *const *const futures,
+                           const uintmax_t count,
+                           struct triggerfish_strong **const out) {
+    return combinator_of(futures, count, false, false, out);
+}
+
+bool squid_future_when_any(struct squid_future *const *const futures,
+                           const uintmax_t count,
+                           const bool is_cancelling,
+                           struct triggerfish_strong **const out) {
+    return combinator_of(futures, count, true, is_cancelling, out);
+}
@@ -0,0 +1,169 @@
+#include <stdlib.h>
+#include <assert.h>
+#include <squid.h>
+
+#include "private/heap.h"
+
+#ifdef TEST
+#include <test/cmocka.h>
+#endif
+
+/* first allocation holds this many entries, each following one doubles */
+#define MINIMUM                                             64
+
+bool squid_heap_init(struct squid_heap *const object) {
+    if (!object) {
+        squid_error = SQUID_HEAP_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    *object = (struct squid_heap) {0};
+    return true;
+}
+
+bool squid_heap_invalidate(struct squid_heap *const object) {
+    if (!object) {
+        squid_error = SQUID_HEAP_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    free(object->entries);
+    *object = (struct squid_heap) {0};
+    return true;
+}
+
+bool squid_heap_reserve(struct squid_heap *const object,
+                        const uintmax_t count) {
+    if (!object) {
+        squid_error = SQUID_HEAP_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    const uintmax_t limit = SIZE_MAX / sizeof(struct squid_heap_entry);
+    if (count > limit - object->count) {
+        squid_error = SQUID_HEAP_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    const uintmax_t needed = object->count + count;
+    if (needed <= object->size) {
+        return true;
+    }
+    uintmax_t size = object->size ? object->size : MINIMUM;
+    while (size < needed) {
+        size = size > limit / 2 ? limit : 2 * size;
+    }
+    struct squid_heap_entry *const entries
+            = realloc(object->entries, size * sizeof(*entries));
+    if (!entries) {
+        squid_error = SQUID_HEAP_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    object->entries = entries;
+    object->size = size;
+    return true;
+}
+
+static inline bool is_before(const struct squid_heap_entry *const a,
+                             const struct squid_heap_entry *const b) {
+    assert(a);
+    assert(b);
+    /* orders wrap around so compare them by their distance */
+    return a->key < b->key
+           || (a->key == b->key && (int64_t) (a->order - b->order) < 0);
+}
+
+bool squid_heap_add(struct squid_heap *const object,
+                    const uint64_t key,
+                    void *const item) {
+    if (!object) {
+        squid_error = SQUID_HEAP_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!squid_heap_reserve(object, 1)) {
+        return false;
+    }
+    const struct squid_heap_entry entry = {
+            .key = key,
+            .order = object->order++,
+            .item = item
+    };
+    uintmax_t i = object->count++;
+    while (i) {
+        const uintmax_t parent = (i - 1) / 2;
+        if (!is_before(&entry, &object->entries[parent])) {
+            break;
+        }
+        object->entries[i] = object->entries[parent];
+        i = parent;
+    }
+    object->entries[i] = entry;
+    return true;
+}
+
+bool squid_heap_remove(struct squid_heap *const object, void **const out) {
+    if (!object) {
+        squid_error = SQUID_HEAP_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_HEAP_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    if (!object->count) {
+        squid_error = SQUID_HEAP_ERROR_HEAP_IS_EMPTY;
+        return false;
+    }
+    *out = object->entries[0].item;
+    const struct squid_heap_entry last = object->entries[--object->count];
+    const uintmax_t count = object->count;
+    uintmax_t i = 0;
+    while (true) {
+        uintmax_t child = 2 * i + 1;
+        if (child >= count) {
+            break;
+        }
+        if (child + 1 < count
+            && is_before(&object->entries[child + 1],
+                         &object->entries[child])) {
+            child++;
+        }
+        if (!is_before(&object->entries[child], &last)) {
+            break;
+        }
+        object->entries[i] = object->entries[child];
+        i = child;
+    }
+    if (count) {
+        object->entries[i] = last;
+    }
+    return true;
+}
+
+bool squid_heap_first(const struct squid_heap *const object,
+                      uint64_t *const out) {
+    if (!object) {
+        squid_error = SQUID_HEAP_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_HEAP_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    if (!object->count) {
+        squid_error = SQUID_HEAP_ERROR_HEAP_IS_EMPTY;
+        return false;
+    }
+    *out = object->entries[0].key;
+    return true;
+}
+
+bool squid_heap_count(const struct squid_heap *const object,
+                      uintmax_t *const out) {
+    if (!object) {
+        squid_error = SQUID_HEAP_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_HEAP_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    *out = object->count;
+    return true;
+}
@@ -0,0 +1,224 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <pthread.h>
+#include <seagrass.h>
+#include <squid.h>
+
+#include "private/numa.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef TEST
+#include <test/cmocka.h>
+#endif
+
+#define ROOT                                "/sys/devices/system/node"
+
+static struct {
+    uintmax_t count;
+    uintmax_t ids[SQUID_NUMA_NODES]; /* as numbered by the kernel */
+    uint64_t cpus[SQUID_NUMA_NODES][SQUID_NUMA_WORDS];
+} topology;
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+bool squid_numa_parse(const char *list, uint64_t *const out) {
+    if (!list) {
+        squid_error = SQUID_NUMA_ERROR_LIST_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_NUMA_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    uint64_t cpus[SQUID_NUMA_WORDS] = {0};
+    while (*list && '\n' != *list) {
+        char *end;
+        errno = 0;
+        const unsigned long first = strtoul(list, &end, 10);
+        if (end == list || '-' == *list || '+' == *list || errno) {
+            squid_error = SQUID_NUMA_ERROR_LIST_IS_INVALID;
+            return false;
+        }
+        unsigned long last = first;
+        if ('-' == *end) {
+            list = end + 1;
+            errno = 0;
+            last = strtoul(list, &end, 10);
+            if (end == list || '-' == *list || '+' == *list || errno
+                || last < first) {
+                squid_error = SQUID_NUMA_ERROR_LIST_IS_INVALID;
+                return false;
+            }
+        }
+        if (last >= SQUID_NUMA_CPUS) {
+            squid_error = SQUID_NUMA_ERROR_LIST_IS_INVALID;
+            return false;
+        }
+        for (unsigned long i = first; i <= last; i++) {
+            cpus[i / 64] |= UINT64_C(1) << (i % 64);
+        }
+        list = end;
+        if (',' == *list) {
+            list++;
+            if (!*list || '\n' == *list) {
+                squid_error = SQUID_NUMA_ERROR_LIST_IS_INVALID;
+                return false;
+            }
+        } else if (*list && '\n' != *list) {
+            squid_error = SQUID_NUMA_ERROR_LIST_IS_INVALID;
+            return false;
+        }
+    }
+    memcpy(out, cpus, sizeof(cpus));
+    return true;
+}
+
+#if defined(__linux__)
+
+static bool read_list(const char *const path, uint64_t *const out) {
+    FILE *const file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+    char line[4096];
+    const bool result = fgets(line, sizeof(line), file)
+                        && squid_numa_parse(line, out);
+    (void) fclose(file);
+    return result;
+}
+
+static bool discover(void) {
+    uint64_t online[SQUID_NUMA_WORDS];
+    if (!read_list(ROOT "/online", online)) {
+        return false;
+    }
+    for (uintmax_t id = 0; id < SQUID_NUMA_CPUS; id++) {
+        if (!(online[id / 64] & UINT64_C(1) << (id % 64))) {
+            continue;
+        }
+        char path[sizeof(ROOT) + 64];
+        (void) snprintf(path, sizeof(path), ROOT "/node%ju/cpulist", id);
+        uint64_t cpus[SQUID_NUMA_WORDS];
+        if (!read_list(path, cpus)) {
+            return false;
+        }
+        /* memory-only nodes have no threads to place */
+        bool is_empty = true;
+        for (uintmax_t i = 0; i < SQUID_NUMA_WORDS && is_empty; i++) {
+            is_empty = !cpus[i];
+        }
+        if (is_empty) {
+            continue;
+        }
+        if (topology.count < SQUID_NUMA_NODES) {
+            topology.ids[topology.count++] = id;
+        }
+        for (uintmax_t i = 0; i < SQUID_NUMA_WORDS; i++) {
+            topology.cpus[topology.count - 1][i] |= cpus[i];
+        }
+    }
+    return topology.count > 0;
+}
+
+#else
+
+static bool discover(void) {
+    return false;
+}
+
+#endif
+
+static void initialize(void) {
+    if (discover()) {
+        return;
+    }
+    /* whatever was found before the failure is thrown away */
+    memset(&topology, 0, sizeof(topology));
+    topology.count = 1;
+    memset(topology.cpus[0], 0xff, sizeof(topology.cpus[0]));
+}
+
+bool squid_numa_count(uintmax_t *const out) {
+    if (!out) {
+        squid_error = SQUID_NUMA_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    seagrass_required_true(!pthread_once(&once, initialize));
+    *out = topology.count;
+    return true;
+}
+
+bool squid_numa_cpus(const uintmax_t node, uint64_t *const out) {
+    if (!out) {
+        squid_error = SQUID_NUMA_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    seagrass_required_true(!pthread_once(&once, initialize));
+    if (node >= topology.count) {
+        squid_error = SQUID_NUMA_ERROR_NODE_IS_OUT_OF_BOUNDS;
+        return false;
+    }
+    memcpy(out, topology.cpus[node], sizeof(topology.cpus[node]));
+    return true;
+}
+
+bool squid_numa_current(uintmax_t *const out) {
+    if (!out) {
+        squid_error = SQUID_NUMA_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    seagrass_required_true(!pthread_once(&once, initialize));
+    *out = 0;
+#if defined(__linux__)
+    unsigned cpu;
+    unsigned id;
+    if (topology.count > 1
+        && !syscall(SYS_getcpu, &cpu, &id, NULL)) {
+        for (uintmax_t i = 0; i < topology.count; i++) {
+            if (topology.ids[i] == id) {
+                *out = i;
+                break;
+            }
+        }
+    }
+#endif
+    return true;
+}
+
+bool squid_numa_pin(const uint64_t *const cpus) {
+    if (!cpus) {
+        squid_error = SQUID_NUMA_ERROR_CPUS_IS_NULL;
+        return false;
+    }
+    bool is_empty = true;
+    for (uintmax_t i = 0; i < SQUID_NUMA_WORDS && is_empty; i++) {
+        is_empty = !cpus[i];
+    }
+    if (is_empty) {
+        squid_error = SQUID_NUMA_ERROR_CPUS_IS_EMPTY;
+        return false;
+    }
+#if defined(__linux__)
+    /* the kernel takes the set as an array of unsigned longs */
+    const size_t bits = CHAR_BIT * sizeof(unsigned long);
+    unsigned long mask[SQUID_NUMA_CPUS / (CHAR_BIT * sizeof(unsigned long))]
+            = {0};
+    for (uintmax_t i = 0; i < SQUID_NUMA_CPUS; i++) {
+        if (cpus[i / 64] & UINT64_C(1) << (i % 64)) {
+            mask[i / bits] |= 1UL << (i % bits);
+        }
+    }
+    if (!syscall(SYS_sched_setaffinity, 0, sizeof(mask), mask)) {
+        return true;
+    }
+    seagrass_required_true(EINVAL == errno || EPERM == errno);
+#endif
+    squid_error = SQUID_NUMA_ERROR_AFFINITY_FAILED;
+    return false;
+}
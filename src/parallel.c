@@ -0,0 +1,368 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <seagrass.h>
+#include <squid.h>
+
+#include "private/executer.h"
+#include "private/future.h"
+#include "private/futex.h"
+#include "private/pool.h"
+#include "private/queue.h"
+
+#ifdef TEST
+#include <test/cmocka.h>
+#endif
+
+/* automatic grain aims for this many chunks per participant */
+#define CHUNKS                                              8
+
+/* sub-range waiting for an idle participant to take it over */
+struct range {
+    uintmax_t begin;
+    uintmax_t end;
+    uint32_t index;
+};
+
+struct job {
+    squid_parallel_function function;
+    const struct squid_parallel_reduction *reduction;
+    void *context;
+    uintmax_t grain;
+    struct squid_queue ranges;
+    struct squid_pool pool; /* struct range */
+    atomic_uintmax_t remaining; /* iterations yet to be done */
+    atomic_intmax_t hungry; /* idle participants less ranges left for them */
+    atomic_int epoch; /* event count idle participants sleep on */
+};
+
+struct participant {
+    struct job *job;
+    struct triggerfish_strong *future; /* NULL unless a helper task */
+    void *partial; /* NULL unless reducing */
+};
+
+static bool publish(struct job *const job,
+                    const uintmax_t begin,
+                    const uintmax_t end) {
+    assert(job);
+    assert(begin < end);
+    uint32_t index;
+    if (!squid_pool_acquire(&job->pool, &index)) {
+        seagrass_required_true(SQUID_POOL_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        return false;
+    }
+    struct range *range;
+    seagrass_required_true(squid_pool_at(&job->pool, index,
+                                         (void **) &range));
+    *range = (struct range) {
+            .begin = begin,
+            .end = end,
+            .index = index
+    };
+    if (!squid_queue_add(&job->ranges, range)) {
+        seagrass_required_true(SQUID_QUEUE_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        seagrass_required_true(squid_pool_release(&job->pool, index));
+        return false;
+    }
+    atomic_fetch_add(&job->epoch, 1);
+    seagrass_required_true(squid_futex_wake(&job->epoch, 1));
+    return true;
+}
+
+static bool take(struct job *const job,
+                 uintmax_t *const begin,
+                 uintmax_t *const end) {
+    assert(job);
+    assert(begin);
+    assert(end);
+    struct range *range;
+    if (!squid_queue_remove(&job->ranges, (void **) &range)) {
+        seagrass_required_true(SQUID_QUEUE_ERROR_QUEUE_IS_EMPTY
+                               == squid_error);
+        return false;
+    }
+    *begin = range->begin;
+    *end = range->end;
+    seagrass_required_true(squid_pool_release(&job->pool, range->index));
+    return true;
+}
+
+/* halves what is left of the range whenever another participant is idle */
+static void work(struct participant *const participant,
+                 uintmax_t begin,
+                 uintmax_t end) {
+    assert(participant);
+    struct job *const job = participant->job;
+    while (begin < end) {
+        const uintmax_t count = end - begin;
+        if (count > job->grain) {
+            intmax_t hungry = atomic_load(&job->hungry);
+            /* claim one of the idle participants for the other half */
+            if (hungry > 0
+                && atomic_compare_exchange_strong(&job->hungry, &hungry,
+                                                  hungry - 1)) {
+                const uintmax_t middle = begin + count / 2;
+                if (publish(job, middle, end)) {
+                    end = middle;
+                } else {
+                    atomic_fetch_add(&job->hungry, 1);
+                }
+                continue;
+            }
+        }
+        const uintmax_t step = count < job->grain ? count : job->grain;
+        if (job->reduction) {
+            job->reduction->accumulate(begin, begin + step,
+                                       participant->partial, job->context);
+        } else {
+            job->function(begin, begin + step, job->context);
+        }
+        begin += step;
+        if (step == atomic_fetch_sub(&job->remaining, step)) {
+            /* the idle participants are free to go */
+            atomic_fetch_add(&job->epoch, 1);
+            seagrass_required_true(squid_futex_wake(&job->epoch,
+                                                    UINTMAX_MAX));
+        }
+    }
+}
+
+static void participate(struct participant *const participant) {
+    assert(participant);
+    struct job *const job = participant->job;
+    atomic_fetch_add(&job->hungry, 1);
+    while (true) {
+        const int epoch = atomic_load(&job->epoch);
+        if (!atomic_load(&job->remaining)) {
+            break;
+        }
+        uintmax_t begin;
+        uintmax_t end;
+        if (!take(job, &begin, &end)) {
+            /* sleep until a range is split off for us or all are done */
+            seagrass_required_true(squid_futex_wait(&job->epoch, epoch,
+                                                    NULL));
+            continue;
+        }
+        /* whoever published the range has already counted us out */
+        work(participant, begin, end);
+        atomic_fetch_add(&job->hungry, 1);
+    }
+    atomic_fetch_sub(&job->hungry, 1);
+}
+
+static void help(void *const args,
+                 bool (*const is_cancelled)(void),
+                 struct triggerfish_strong **const out,
+                 uintmax_t *const error) {
+    participate(args);
+}
+
+/* a helper that has yet to start is no longer needed */
+static void withdraw(struct triggerfish_strong *const future) {
+    assert(future);
+    struct squid_future *instance;
+    seagrass_required_true(triggerfish_strong_instance(
+            future, (void **) &instance));
+    enum squid_future_status expected = SQUID_FUTURE_STATUS_PENDING;
+    if (atomic_compare_exchange_strong(&instance->status, (int *) &expected,
+                                       SQUID_FUTURE_STATUS_CANCELLED)) {
+        seagrass_required_true(squid_future_notify(instance));
+        return;
+    }
+    /* wait for it to run out of work */
+    struct triggerfish_strong *out;
+    if (!squid_future_get(instance, &out, NULL)) {
+        seagrass_required_true(SQUID_FUTURE_ERROR_FUTURE_IS_CANCELLED
+                               == squid_error);
+    }
+}
+
+static uintmax_t capacity(const struct squid_executor *const executor) {
+    assert(executor);
+    const long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    uintmax_t count = processors > 1 ? (uintmax_t) processors : 1;
+    /* the calling thread makes one on top of the executor's threads */
+    if (count - 1 > executor->options.threads.maximum) {
+        count = 1 + executor->options.threads.maximum;
+    }
+    return count;
+}
+
+static bool is_enqueue_error(void) {
+    return SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED == squid_error
+           || SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED == squid_error
+           || SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL == squid_error
+           || SQUID_EXECUTOR_ERROR_TIMED_OUT == squid_error
+           || SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN == squid_error;
+}
+
+static bool run(struct squid_executor *const executor,
+                struct job *const job,
+                const uintmax_t begin,
+                const uintmax_t end,
+                const uintmax_t grain,
+                void *const out) {
+    assert(executor);
+    assert(job);
+    assert(begin < end);
+    const uintmax_t iterations = end - begin;
+    uintmax_t count = capacity(executor);
+    job->grain = grain ? grain : iterations / (CHUNKS * count);
+    job->grain = job->grain ? job->grain : 1;
+    const uintmax_t chunks = iterations / job->grain
+                             + (iterations % job->grain ? 1 : 0);
+    count = count < chunks ? count : chunks;
+    /* partial results are laid out after the participants, each aligned */
+    const size_t alignment = _Alignof(max_align_t);
+    const size_t head = (count * sizeof(struct participant) + alignment - 1)
+                        & ~(alignment - 1);
+    size_t stride = 0;
+    if (job->reduction) {
+        stride = (job->reduction->size + alignment - 1) & ~(alignment - 1);
+        if (stride < job->reduction->size
+            || stride > (SIZE_MAX - head) / count) {
+            squid_error = SQUID_PARALLEL_ERROR_MEMORY_ALLOCATION_FAILED;
+            return false;
+        }
+    }
+    unsigned char *const memory = malloc(head + count * stride);
+    if (!memory) {
+        squid_error = SQUID_PARALLEL_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    struct participant *const participants = (struct participant *) memory;
+    for (uintmax_t i = 0; i < count; i++) {
+        participants[i] = (struct participant) {
+                .job = job
+        };
+        if (job->reduction) {
+            participants[i].partial = memory + head + i * stride;
+            memcpy(participants[i].partial, job->reduction->identity,
+                   job->reduction->size);
+        }
+    }
+    if (!squid_queue_init(&job->ranges)) {
+        seagrass_required_true(SQUID_QUEUE_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        free(memory);
+        squid_error = SQUID_PARALLEL_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    if (!squid_pool_init(&job->pool, sizeof(struct range))) {
+        seagrass_required_true(SQUID_POOL_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        seagrass_required_true(squid_queue_invalidate(&job->ranges));
+        free(memory);
+        squid_error = SQUID_PARALLEL_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    atomic_init(&job->remaining, iterations);
+    atomic_init(&job->epoch, 0);
+    /* whole range is left for the first participant to come along */
+    atomic_init(&job->hungry, -1);
+    if (!publish(job, begin, end)) {
+        seagrass_required_true(squid_pool_invalidate(&job->pool));
+        seagrass_required_true(squid_queue_invalidate(&job->ranges));
+        free(memory);
+        squid_error = SQUID_PARALLEL_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    for (uintmax_t i = 1; i < count; i++) {
+        if (!squid_executor_submit(executor, help, &participants[i],
+                                   &participants[i].future)) {
+            /* the calling thread carries on with those it has got */
+            seagrass_required_true(is_enqueue_error());
+            break;
+        }
+    }
+    participate(&participants[0]);
+    for (uintmax_t i = 1; i < count && participants[i].future; i++) {
+        withdraw(participants[i].future);
+        seagrass_required_true(triggerfish_strong_release(
+                participants[i].future));
+    }
+    if (job->reduction) {
+        memcpy(out, participants[0].partial, job->reduction->size);
+        for (uintmax_t i = 1; i < count; i++) {
+            job->reduction->combine(out, participants[i].partial,
+                                    job->context);
+        }
+    }
+    seagrass_required_true(squid_pool_invalidate(&job->pool));
+    seagrass_required_true(squid_queue_invalidate(&job->ranges));
+    free(memory);
+    return true;
+}
+
+bool squid_parallel_for(struct squid_executor *const executor,
+                        const uintmax_t begin,
+                        const uintmax_t end,
+                        const uintmax_t grain,
+                        squid_parallel_function const function,
+                        void *const context) {
+    if (!executor) {
+        squid_error = SQUID_PARALLEL_ERROR_EXECUTOR_IS_NULL;
+        return false;
+    }
+    if (!function) {
+        squid_error = SQUID_PARALLEL_ERROR_FUNCTION_IS_NULL;
+        return false;
+    }
+    if (begin > end) {
+        squid_error = SQUID_PARALLEL_ERROR_RANGE_IS_INVALID;
+        return false;
+    }
+    if (begin == end) {
+        return true;
+    }
+    struct job job = {
+            .function = function,
+            .context = context
+    };
+    return run(executor, &job, begin, end, grain, NULL);
+}
+
+bool squid_parallel_reduce(
+        struct squid_executor *const executor,
+        const uintmax_t begin,
+        const uintmax_t end,
+        const uintmax_t grain,
+        const struct squid_parallel_reduction *const reduction,
+        void *const context,
+        void *const out) {
+    if (!executor) {
+        squid_error = SQUID_PARALLEL_ERROR_EXECUTOR_IS_NULL;
+        return false;
+    }
+    if (!reduction) {
+        squid_error = SQUID_PARALLEL_ERROR_REDUCTION_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_PARALLEL_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    if (!reduction->size || !reduction->identity || !reduction->accumulate
+        || !reduction->combine) {
+        squid_error = SQUID_PARALLEL_ERROR_REDUCTION_IS_INVALID;
+        return false;
+    }
+    if (begin > end) {
+        squid_error = SQUID_PARALLEL_ERROR_RANGE_IS_INVALID;
+        return false;
+    }
+    if (begin == end) {
+        memcpy(out, reduction->identity, reduction->size);
+        return true;
+    }
+    struct job job = {
+            .reduction = reduction,
+            .context = context
+    };
+    return run(executor, &job, begin, end, grain, out);
+}
@@ -0,0 +1,206 @@
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+#include <seagrass.h>
+#include <squid.h>
+
+#include "private/pool.h"
+
+#ifdef TEST
+#include <test/cmocka.h>
+#endif
+
+/* first slab holds 2^SHIFT blocks, each following slab doubles that */
+#define SHIFT                                               6
+#define HEADER                                              \
+    (sizeof(max_align_t) > sizeof(atomic_uint_least32_t)    \
+        ? sizeof(max_align_t) : sizeof(atomic_uint_least32_t))
+
+static unsigned char *block(const struct squid_pool *const object,
+                            const uint32_t index) {
+    assert(object);
+    assert(index);
+    const uint64_t i = (uint64_t) index - 1 + (1 << SHIFT);
+    const unsigned slab = 63 - __builtin_clzll(i) - SHIFT;
+    unsigned char *const base = atomic_load_explicit(&object->slabs[slab],
+                                                     memory_order_acquire);
+    if (!base) {
+        return NULL;
+    }
+    return base + (i - ((uint64_t) 1 << (SHIFT + slab))) * object->size;
+}
+
+static bool is_valid(const struct squid_pool *const object,
+                     const uint32_t index) {
+    assert(object);
+    return index
+           && index < atomic_load_explicit(&object->used,
+                                           memory_order_relaxed)
+           && block(object, index);
+}
+
+bool squid_pool_init(struct squid_pool *const object, const size_t size) {
+    if (!object) {
+        squid_error = SQUID_POOL_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!size || size > SIZE_MAX / 2 - 2 * HEADER) {
+        squid_error = SQUID_POOL_ERROR_SIZE_IS_INVALID;
+        return false;
+    }
+    *object = (struct squid_pool) {
+            .size = HEADER + (size + HEADER - 1) / HEADER * HEADER
+    };
+    int error;
+    if ((error = pthread_mutex_init(&object->mutex, NULL))) {
+        seagrass_required_true(ENOMEM == error);
+        squid_error = SQUID_POOL_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    /* index zero is reserved to mark the end of the free list */
+    atomic_store(&object->used, 1);
+    return true;
+}
+
+bool squid_pool_invalidate(struct squid_pool *const object) {
+    if (!object) {
+        squid_error = SQUID_POOL_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    for (uintmax_t i = 0; i < SQUID_POOL_SLABS; i++) {
+        free(atomic_load(&object->slabs[i]));
+    }
+    int error;
+    if ((error = pthread_mutex_destroy(&object->mutex))) {
+        seagrass_required_true(error == EINVAL);
+    }
+    *object = (struct squid_pool) {0};
+    return true;
+}
+
+static bool grow(struct squid_pool *const object, uint32_t *const out) {
+    assert(object);
+    assert(out);
+    const uint64_t index = atomic_fetch_add(&object->used, 1);
+    if (index > UINT32_MAX) {
+        squid_error = SQUID_POOL_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    if (!block(object, (uint32_t) index)) {
+        const uint64_t i = index - 1 + (1 << SHIFT);
+        const unsigned slab = 63 - __builtin_clzll(i) - SHIFT;
+        seagrass_required_true(!pthread_mutex_lock(&object->mutex));
+        if (!atomic_load(&object->slabs[slab])) {
+            const uint64_t count = (uint64_t) 1 << (SHIFT + slab);
+            unsigned char *const base = count <= SIZE_MAX / object->size
+                                        ? malloc(count * object->size)
+                                        : NULL;
+            if (!base) {
+                seagrass_required_true(!pthread_mutex_unlock(&object->mutex));
+                squid_error = SQUID_POOL_ERROR_MEMORY_ALLOCATION_FAILED;
+                return false;
+            }
+            atomic_store_explicit(&object->slabs[slab], base,
+                                  memory_order_release);
+        }
+        seagrass_required_true(!pthread_mutex_unlock(&object->mutex));
+    }
+    atomic_fetch_add_explicit(&object->misses, 1, memory_order_relaxed);
+    *out = (uint32_t) index;
+    return true;
+}
+
+bool squid_pool_acquire(struct squid_pool *const object,
+                        uint32_t *const out) {
+    if (!object) {
+        squid_error = SQUID_POOL_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_POOL_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    uint64_t head = atomic_load(&object->head);
+    while ((uint32_t) head) {
+        /* blocks are never freed so a stale head is still safe to read */
+        atomic_uint_least32_t *const next = (atomic_uint_least32_t *)
+                block(object, (uint32_t) head);
+        const uint64_t desired = (((head >> 32) + 1) << 32)
+                                 | atomic_load(next);
+        if (atomic_compare_exchange_weak(&object->head, &head, desired)) {
+            atomic_fetch_add_explicit(&object->hits, 1,
+                                      memory_order_relaxed);
+            *out = (uint32_t) head;
+            return true;
+        }
+    }
+    return grow(object, out);
+}
+
+bool squid_pool_release(struct squid_pool *const object,
+                        const uint32_t index) {
+    if (!object) {
+        squid_error = SQUID_POOL_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!is_valid(object, index)) {
+        squid_error = SQUID_POOL_ERROR_INDEX_IS_INVALID;
+        return false;
+    }
+    atomic_uint_least32_t *const next = (atomic_uint_least32_t *)
+            block(object, index);
+    uint64_t head = atomic_load(&object->head);
+    uint64_t desired;
+    do {
+        atomic_store(next, (uint32_t) head);
+        desired = (((head >> 32) + 1) << 32) | index;
+    } while (!atomic_compare_exchange_weak(&object->head, &head, desired));
+    return true;
+}
+
+bool squid_pool_at(const struct squid_pool *const object,
+                   const uint32_t index,
+                   void **const out) {
+    if (!object) {
+        squid_error = SQUID_POOL_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!is_valid(object, index)) {
+        squid_error = SQUID_POOL_ERROR_INDEX_IS_INVALID;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_POOL_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    *out = block(object, index) + HEADER;
+    return true;
+}
+
+bool squid_pool_hits(const struct squid_pool *const object,
+                     uintmax_t *const out) {
+    if (!object) {
+        squid_error = SQUID_POOL_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_POOL_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    *out = atomic_load_explicit(&object->hits, memory_order_relaxed);
+    return true;
+}
+
+bool squid_pool_misses(const struct squid_pool *const object,
+                       uintmax_t *const out) {
+    if (!object) {
+        squid_error = SQUID_POOL_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_POOL_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    *out = atomic_load_explicit(&object->misses, memory_order_relaxed);
+    return true;
+}
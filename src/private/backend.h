@@ -0,0 +1,85 @@
+#ifndef _SQUID_PRIVATE_BACKEND_H_
+#define _SQUID_PRIVATE_BACKEND_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+struct squid_executor;
+struct squid_executor_lane;
+
+/**
+ * @brief Operations behind the shared task queues of an executor.
+ * <p>A backend keeps the state of each priority lane in the lane itself and
+ * reports errors with the executor's error codes. Apart from init and
+ * invalidate all operations may be called concurrently.</p>
+ */
+struct squid_backend {
+    /**
+     * @brief Set up the lane for the capacity in the executor's options.
+     * <p>Sets the effective capacity of the queue, zero if unbounded.</p>
+     * @throws SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED if there is
+     * insufficient memory to set up the queue.
+     */
+    bool (*init)(struct squid_executor *object,
+                 struct squid_executor_lane *lane);
+    /**
+     * @brief Release the queue, items still in it are not touched.
+     */
+    void (*invalidate)(struct squid_executor *object,
+                       struct squid_executor_lane *lane);
+    /**
+     * @brief Add items in order, either all of them or none.
+     * @throws SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL if there is no room for
+     * all items.
+     * @throws SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED if there is
+     * insufficient memory to add the items.
+     */
+    bool (*add_all)(struct squid_executor *object,
+                    struct squid_executor_lane *lane,
+                    void *const *items,
+                    uintmax_t count);
+    /**
+     * @brief Remove the next item in the backend's order, false if there
+     * was none.
+     */
+    bool (*remove)(struct squid_executor *object,
+                   struct squid_executor_lane *lane,
+                   void **out);
+    /**
+     * @brief Remove all items handing each to function, returns their count.
+     */
+    uintmax_t (*drain)(struct squid_executor *object,
+                       struct squid_executor_lane *lane,
+                       void (*function)(void *item, void *args),
+                       void *args);
+    /**
+     * @brief Check whether the queue appears to be empty.
+     */
+    bool (*is_empty)(const struct squid_executor *object,
+                     const struct squid_executor_lane *lane);
+    /**
+     * @brief Retrieve an approximate count of the items in the queue.
+     */
+    uintmax_t (*count)(const struct squid_executor *object,
+                       const struct squid_executor_lane *lane);
+};
+
+/**
+ * @brief Michael-Scott linked queue with pooled nodes and a count of the
+ * queued items, which also bounds it if the capacity is set.
+ */
+extern const struct squid_backend squid_backend_linked;
+
+/**
+ * @brief Fixed capacity ring with a sequence number per slot.
+ */
+extern const struct squid_backend squid_backend_ring;
+
+/**
+ * @brief Mutex guarded binary heap that hands out the item with the
+ * earliest deadline first and items without one in the order they came.
+ */
+extern const struct squid_backend squid_backend_deadline;
+
+#endif /* _SQUID_PRIVATE_BACKEND_H_ */
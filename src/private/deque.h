@@ -0,0 +1,99 @@
+#ifndef _SQUID_PRIVATE_DEQUE_H_
+#define _SQUID_PRIVATE_DEQUE_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define SQUID_DEQUE_ERROR_OBJECT_IS_NULL                    1
+#define SQUID_DEQUE_ERROR_OUT_IS_NULL                       2
+#define SQUID_DEQUE_ERROR_CAPACITY_IS_INVALID               3
+#define SQUID_DEQUE_ERROR_MEMORY_ALLOCATION_FAILED          4
+#define SQUID_DEQUE_ERROR_DEQUE_IS_FULL                     5
+#define SQUID_DEQUE_ERROR_DEQUE_IS_EMPTY                    6
+#define SQUID_DEQUE_ERROR_DEQUE_IS_CONTENDED                7
+
+/**
+ * @brief Fixed capacity Chase-Lev work-stealing deque.
+ * <p>Only the owning thread may push and pop at the bottom while any
+ * thread may steal from the top.</p>
+ */
+struct squid_deque {
+    atomic_intmax_t top;
+    char padding[64 - sizeof(atomic_intmax_t)];
+    atomic_intmax_t bottom;
+    uintmax_t mask;
+    _Atomic(void *) *items;
+};
+
+/**
+ * @brief Initialize deque.
+ * @param [in] object instance to be initialized.
+ * @param [in] capacity of deque which is rounded up to a power of two.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_DEQUE_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_DEQUE_ERROR_CAPACITY_IS_INVALID if capacity is zero or too
+ * large to be rounded up to a power of two.
+ * @throws SQUID_DEQUE_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to initialize instance.
+ */
+bool squid_deque_init(struct squid_deque *object, uintmax_t capacity);
+
+/**
+ * @brief Invalidate deque.
+ * <p>The actual <u>deque instance is not deallocated</u> since it may
+ * have been embedded in a larger structure.</p>
+ * @param [in] object instance to be invalidated.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_DEQUE_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ */
+bool squid_deque_invalidate(struct squid_deque *object);
+
+/**
+ * @brief Push item onto the bottom of the deque.
+ * @param [in] object deque instance.
+ * @param [in] item to be pushed.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_DEQUE_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_DEQUE_ERROR_DEQUE_IS_FULL if deque is at capacity.
+ * @note May only be called by the owning thread.
+ */
+bool squid_deque_push(struct squid_deque *object, void *item);
+
+/**
+ * @brief Pop item from the bottom of the deque.
+ * @param [in] object deque instance.
+ * @param [out] out receive item.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_DEQUE_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_DEQUE_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_DEQUE_ERROR_DEQUE_IS_EMPTY if deque is empty.
+ * @note May only be called by the owning thread.
+ */
+bool squid_deque_pop(struct squid_deque *object, void **out);
+
+/**
+ * @brief Steal item from the top of the deque.
+ * @param [in] object deque instance.
+ * @param [out] out receive item.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_DEQUE_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_DEQUE_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_DEQUE_ERROR_DEQUE_IS_EMPTY if deque is empty.
+ * @throws SQUID_DEQUE_ERROR_DEQUE_IS_CONTENDED if another thread took the
+ * item first.
+ */
+bool squid_deque_steal(struct squid_deque *object, void **out);
+
+/**
+ * @brief Retrieve approximate count of items.
+ * @param [in] object deque instance.
+ * @param [out] out receive count of items.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_DEQUE_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_DEQUE_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_deque_count(const struct squid_deque *object, uintmax_t *out);
+
+#endif /* _SQUID_PRIVATE_DEQUE_H_ */
@@ -7,19 +7,106 @@
 #include <stdatomic.h>
 #include <pthread.h>
 #include <triggerfish.h>
-#include <lionfish.h>
+#include <squid.h>
+
+#include "backend.h"
+#include "deque.h"
+#include "heap.h"
+#include "numa.h"
+#include "queue.h"
+#include "ring.h"
+#include "wheel.h"
 
 #define SQUID_EXECUTOR_ERROR_IS_RUNNING                     (-1)
+#define SQUID_EXECUTOR_ERROR_IS_NOT_WORKER                  (-2)
+#define SQUID_EXECUTOR_ERROR_IS_IDLE                        (-3)
+
+#define SQUID_EXECUTOR_LANES        (1 + SQUID_EXECUTOR_PRIORITY_LOW)
+
+/* shared task queue of a single priority */
+struct squid_executor_lane {
+    struct squid_queue linked;
+    struct squid_ring ring;
+    struct {
+        pthread_mutex_t mutex;
+        struct squid_heap heap; /* keyed by deadline */
+    } ordered;
+    atomic_uintmax_t count; /* items held by the linked or ordered queue */
+};
+
+struct squid_executor_worker {
+    struct squid_deque tasks;
+    struct squid_executor *executor;
+    atomic_bool is_claimed;
+};
+
+/* NUMA node, or the one set of CPUs, that threads are placed on */
+struct squid_executor_node {
+    struct squid_executor_lane lane; /* normal priority tasks queued here */
+    uint64_t cpus[SQUID_NUMA_WORDS]; /* empty if no thread may run here */
+    atomic_uintmax_t threads;
+};
+
+#define SQUID_EXECUTOR_CACHE_LINE                           64
+
+/* task of squid_executor_execute() as held in the records pool */
+struct squid_executor_record {
+    struct squid_executor_task task;
+    uint64_t queued_at; /* ns on CLOCK_MONOTONIC */
+};
+
+/* activity of one thread, written by no other thread, or of all threads
+ * that are not the executor's own */
+struct squid_executor_counters {
+    atomic_uintmax_t submitted;
+    atomic_uintmax_t completed;
+    atomic_uintmax_t cancelled;
+    atomic_uintmax_t wait[SQUID_EXECUTOR_STATS_BUCKETS];
+    atomic_uintmax_t run[SQUID_EXECUTOR_STATS_BUCKETS];
+    struct squid_executor_counters *next;
+    atomic_bool is_claimed;
+    void *memory; /* counters are aligned to a cache line within */
+};
 
 struct squid_executor {
     struct triggerfish_weak *self;
-    struct lionfish_concurrent_linked_queue_sr tasks;
+    struct squid_executor_options options;
     struct {
-        pthread_mutex_t mutex;
-        pthread_cond_t condition;
+        const struct squid_backend *backend;
+        uintmax_t capacity; /* effective bound per lane, zero if unbounded */
+        struct squid_executor_lane lanes[SQUID_EXECUTOR_LANES];
+        atomic_int epoch; /* event count that blocked submitters wait on */
+        atomic_uintmax_t blocked;
+    } queue;
+    struct squid_pool records; /* struct squid_executor_record */
+    struct {
+        pthread_mutex_t mutex; /* guards the wheel and the fields below */
+        struct squid_wheel wheel; /* scheduled futures, ticks in ms */
+        uint64_t deadline; /* tick the timer thread sleeps until */
+        atomic_int epoch; /* event count that the timer thread sleeps on */
+        bool is_started;
+    } timer;
+    struct {
+        atomic_int epoch; /* event count that idle threads sleep on */
+        atomic_int live; /* threads yet to finish exiting, awaited on */
+        atomic_uintmax_t sleeping;
         atomic_uintmax_t ready;
         atomic_uintmax_t count;
+        atomic_uintmax_t created;
+        atomic_uintmax_t retired;
+        atomic_uintmax_t started; /* numbers the names of threads */
+        char name[16]; /* prefix copied from the options, empty for none */
+        struct squid_executor_worker *workers;
     } threads;
+    struct {
+        struct squid_executor_node *nodes; /* NULL unless threads are pinned */
+        uintmax_t count;
+        bool is_queue_per_node; /* set once each node's lane is ready */
+    } placement;
+    struct {
+        _Atomic(struct squid_executor_counters *) counters; /* threads' */
+        struct squid_executor_counters *shared; /* of all other threads */
+    } stats;
     atomic_bool is_running;
 };
 
@@ -33,6 +120,26 @@ struct squid_executor {
  */
 bool squid_executor_init(struct squid_executor *object);
 
+/**
+ * @brief Initialize executor with options.
+ * @param [in] object instance to be initialized.
+ * @param [in] options to configure the executor with.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_OPTIONS_IS_NULL if options is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID if maximum threads is
+ * zero, if either minimum or prestart threads exceed maximum threads, if
+ * the stack size is below the system's minimum, if work stealing is
+ * enabled with a zero capacity or an unbounded maximum, if a queue per node
+ * is asked for without NUMA awareness or if none of the CPUs in the
+ * affinity are known to the system.
+ * @throws SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to initialize instance.
+ */
+bool squid_executor_init_with_options(
+        struct squid_executor *object,
+        const struct squid_executor_options *options);
+
 /**
  * @brief Invalidate executor.
  * <p>The actual <u>executor instance is not deallocated</u> since it may
@@ -45,4 +152,81 @@ bool squid_executor_init(struct squid_executor *object);
  */
 bool squid_executor_invalidate(struct squid_executor *object);
 
+/**
+ * @brief Resume continuation whose antecedent is done.
+ * <p>The continuation is either run inline or queued on its executor. It is
+ * cancelled instead if its executor is no longer accepting tasks. Tasks of
+ * a strand are handed over to their executor the same way.</p>
+ * @param [in] future continuation to be resumed.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if future is <i>NULL</i>.
+ */
+bool squid_executor_resume(struct squid_future *future);
+
+/**
+ * @brief Make progress on behalf of a thread that waits for future.
+ * <p>If future still sits in a queue the calling thread claims it and runs
+ * it right away, otherwise it runs the next of the other queued tasks. The
+ * task that is run may itself block, so the caller must not hold anything
+ * that queued tasks could need.</p>
+ * @param [in] future awaited by the calling thread.
+ * @return If a task was run or future was found to be taken care of true,
+ * otherwise false.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if future is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_IS_NOT_WORKER if the calling thread is not
+ * one of the threads of future's executor.
+ * @throws SQUID_EXECUTOR_ERROR_IS_IDLE if there is no task to be run.
+ */
+bool squid_executor_help(struct squid_future *future);
+
+/**
+ * @brief Put a thread that waits for future to sleep until there may be a
+ * task for it to help with or future's status has changed.
+ * <p>The thread sleeps along with the executor's idle threads, so it is
+ * woken up as tasks are queued, and {@link squid_executor_rouse} wakes it
+ * up as future completes.</p>
+ * @param [in] future awaited by the calling thread.
+ * @param [in] status of future as last seen by the calling thread.
+ * @param [in] deadline optional absolute time measured against
+ * <i>CLOCK_MONOTONIC</i>, if <i>NULL</i> we sleep without a time limit.
+ * @return Once woken up true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if future is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_IS_NOT_WORKER if the calling thread is not
+ * one of the threads of future's executor.
+ * @throws SQUID_EXECUTOR_ERROR_TIMED_OUT if deadline passed.
+ */
+bool squid_executor_doze(struct squid_future *future,
+                         int status,
+                         const struct timespec *deadline);
+
+/**
+ * @brief Wake up the threads that doze while waiting for future.
+ * <p>Must be called after future's status was changed.</p>
+ * @param [in] future instance.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if future is <i>NULL</i>.
+ */
+bool squid_executor_rouse(struct squid_future *future);
+
+/**
+ * @brief Retrieve the deadline of a queued item.
+ * @param [in] item as queued by the executor.
+ * @param [out] out receive nanoseconds on <i>CLOCK_MONOTONIC</i>, or
+ * <i>UINT64_MAX</i> if item has no deadline.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if item is <i>NULL</i>.
+ * @throws SQUID_EXECUTOR_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_executor_deadline(const void *item, uint64_t *out);
+
+/**
+ * @brief Take scheduled future off its executor's timer wheel.
+ * <p>Releases the reference held by the wheel if the future had yet to come
+ * due, otherwise there is nothing to do.</p>
+ * @param [in] future scheduled future.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL if future is <i>NULL</i>.
+ */
+bool squid_executor_unschedule(struct squid_future *future);
+
 #endif /* _SQUID_PRIVATE_EXECUTOR_H_ */
@@ -0,0 +1,38 @@
+#ifndef _SQUID_PRIVATE_FUTEX_H_
+#define _SQUID_PRIVATE_FUTEX_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#define SQUID_FUTEX_ERROR_OBJECT_IS_NULL                    1
+#define SQUID_FUTEX_ERROR_TIMED_OUT                         2
+
+/**
+ * @brief Wait until woken up if object still contains expected value.
+ * <p>Spurious wake-ups are possible so the caller must check the
+ * condition it is waiting for again once this returns.</p>
+ * @param [in] object address to wait on.
+ * @param [in] expected value that object must contain for us to sleep.
+ * @param [in] deadline optional absolute time measured against
+ * <i>CLOCK_MONOTONIC</i>, if <i>NULL</i> we wait without a time limit.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_FUTEX_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_FUTEX_ERROR_TIMED_OUT if deadline has passed.
+ */
+bool squid_futex_wait(atomic_int *object,
+                      int expected,
+                      const struct timespec *deadline);
+
+/**
+ * @brief Wake up threads waiting on object.
+ * @param [in] object address that is being waited on.
+ * @param [in] count maximum number of threads to wake up.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_FUTEX_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ */
+bool squid_futex_wake(atomic_int *object, uintmax_t count);
+
+#endif /* _SQUID_PRIVATE_FUTEX_H_ */
@@ -5,26 +5,54 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdatomic.h>
-#include <pthread.h>
 #include <triggerfish.h>
 #include <squid.h>
 
+#include "wheel.h"
+
 #define SQUID_FUTURE_ERROR_EXECUTOR_IS_NULL                 (-1)
-#define SQUID_FUTURE_ERROR_FUNCTION_IS_NULL                 (-2)
-#define SQUID_FUTURE_ERROR_MEMORY_ALLOCATION_FAILED         (-3)
 #define SQUID_FUTURE_ERROR_EXECUTOR_IS_INVALID              (-4)
 
 
+/* entry in the list of futures waiting on an antecedent to complete */
+struct squid_future_link {
+    struct squid_future_link *next;
+    struct squid_future *future; /* resumed once antecedent completes */
+    struct squid_future *antecedent;
+    struct triggerfish_strong *reference; /* keeps antecedent alive */
+};
+
 struct squid_future {
-    pthread_mutex_t mutex;
-    pthread_cond_t condition;
     struct triggerfish_strong *self;
     struct triggerfish_strong *executor;
+    struct triggerfish_strong *strand; /* NULL unless submitted to one */
     struct triggerfish_strong *out;
     atomic_int status; /* enum squid_future_status */
+    atomic_uint waiters; /* threads sleeping on status */
+    atomic_uint helpers; /* executor threads waiting on their executor */
+    atomic_bool is_queued; /* handed to a queue and not yet taken off */
     void *args;
     uintmax_t error;
-    squid_function function;
+    squid_function function; /* NULL for combinators, never run */
+    _Atomic(struct squid_future_link *) continuations;
+    struct squid_future_link link; /* continuation of another future */
+    bool is_inline;
+    uint64_t deadline; /* ns on CLOCK_MONOTONIC, zero if none */
+    uint64_t queued_at; /* ns on CLOCK_MONOTONIC, zero if never queued */
+    atomic_bool is_late; /* cancelled as its deadline had passed */
+    struct {
+        struct squid_future_link *links; /* one per input */
+        uintmax_t count;
+        atomic_uintmax_t remaining;
+        bool is_any;
+        bool is_cancelling;
+    } combinator;
+    struct {
+        struct squid_wheel_timer timer;
+        uint64_t period; /* ms between runs, zero if it runs once */
+        struct squid_future *expired; /* next of those taken off the wheel */
+        bool is_timed;
+    } schedule;
 };
 
 /**
@@ -70,4 +98,16 @@ bool squid_future_of(struct triggerfish_strong *executor,
                      void *args,
                      struct triggerfish_strong **out);
 
+/**
+ * @brief Wake up threads waiting for the future to complete.
+ * <p>Must be called after status was changed to either done or cancelled.
+ * Continuations registered through {@link squid_future_then} are handed
+ * over to their executor, or cancelled if future was cancelled. Calling
+ * it more than once is harmless.</p>
+ * @param [in] object future instance.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_FUTURE_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ */
+bool squid_future_notify(struct squid_future *object);
+
 #endif /* _SQUID_PRIVATE_FUTURE_H_ */
@@ -0,0 +1,106 @@
+#ifndef _SQUID_PRIVATE_HEAP_H_
+#define _SQUID_PRIVATE_HEAP_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SQUID_HEAP_ERROR_OBJECT_IS_NULL                     1
+#define SQUID_HEAP_ERROR_OUT_IS_NULL                        2
+#define SQUID_HEAP_ERROR_MEMORY_ALLOCATION_FAILED           3
+#define SQUID_HEAP_ERROR_HEAP_IS_EMPTY                      4
+
+struct squid_heap_entry {
+    uint64_t key;
+    uint64_t order; /* breaks ties between equal keys */
+    void *item;
+};
+
+/**
+ * @brief Binary min-heap of items ordered by key.
+ * <p>Items with equal keys come out in the order they went in. The array
+ * of entries grows as needed and is not shrunk. The heap is not
+ * thread-safe.</p>
+ */
+struct squid_heap {
+    struct squid_heap_entry *entries;
+    uintmax_t count;
+    uintmax_t size; /* entries allocated */
+    uint64_t order; /* of the next item added */
+};
+
+/**
+ * @brief Initialize heap.
+ * @param [in] object instance to be initialized.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_HEAP_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ */
+bool squid_heap_init(struct squid_heap *object);
+
+/**
+ * @brief Invalidate heap.
+ * <p>The actual <u>heap instance is not deallocated</u> since it may
+ * have been embedded in a larger structure. Items still in the heap are
+ * not touched.</p>
+ * @param [in] object instance to be invalidated.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_HEAP_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ */
+bool squid_heap_invalidate(struct squid_heap *object);
+
+/**
+ * @brief Make room so that count more items can be added without failing.
+ * @param [in] object heap instance.
+ * @param [in] count of items to make room for.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_HEAP_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_HEAP_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to make room.
+ */
+bool squid_heap_reserve(struct squid_heap *object, uintmax_t count);
+
+/**
+ * @brief Add item.
+ * @param [in] object heap instance.
+ * @param [in] key of item, lower keys are removed first.
+ * @param [in] item to be added.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_HEAP_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_HEAP_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to add item.
+ */
+bool squid_heap_add(struct squid_heap *object, uint64_t key, void *item);
+
+/**
+ * @brief Remove item with the lowest key.
+ * @param [in] object heap instance.
+ * @param [out] out receive item.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_HEAP_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_HEAP_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_HEAP_ERROR_HEAP_IS_EMPTY if heap is empty.
+ */
+bool squid_heap_remove(struct squid_heap *object, void **out);
+
+/**
+ * @brief Retrieve the lowest key.
+ * @param [in] object heap instance.
+ * @param [out] out receive key.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_HEAP_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_HEAP_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_HEAP_ERROR_HEAP_IS_EMPTY if heap is empty.
+ */
+bool squid_heap_first(const struct squid_heap *object, uint64_t *out);
+
+/**
+ * @brief Retrieve count of items.
+ * @param [in] object heap instance.
+ * @param [out] out receive count of items.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_HEAP_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_HEAP_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_heap_count(const struct squid_heap *object, uintmax_t *out);
+
+#endif /* _SQUID_PRIVATE_HEAP_H_ */
@@ -0,0 +1,79 @@
+#ifndef _SQUID_PRIVATE_NUMA_H_
+#define _SQUID_PRIVATE_NUMA_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SQUID_NUMA_ERROR_OUT_IS_NULL                        1
+#define SQUID_NUMA_ERROR_NODE_IS_OUT_OF_BOUNDS              2
+#define SQUID_NUMA_ERROR_LIST_IS_NULL                       3
+#define SQUID_NUMA_ERROR_LIST_IS_INVALID                    4
+#define SQUID_NUMA_ERROR_CPUS_IS_NULL                       5
+#define SQUID_NUMA_ERROR_CPUS_IS_EMPTY                      6
+#define SQUID_NUMA_ERROR_AFFINITY_FAILED                    7
+
+/* CPUs that a set can hold, kept in words of 64 bits each */
+#define SQUID_NUMA_CPUS                                     1024
+#define SQUID_NUMA_WORDS                    (SQUID_NUMA_CPUS / 64)
+/* nodes beyond this are folded into the last one */
+#define SQUID_NUMA_NODES                                    64
+
+/**
+ * @brief Retrieve the count of NUMA nodes.
+ * <p>The topology is read once from <i>/sys/devices/system/node</i>. If it
+ * cannot be read, or on systems other than Linux, the whole machine is
+ * taken to be a single node holding every CPU.</p>
+ * @param [out] out receive count of nodes, at least one.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_NUMA_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_numa_count(uintmax_t *out);
+
+/**
+ * @brief Retrieve the CPUs of a NUMA node.
+ * @param [in] node index of node, below the count of nodes.
+ * @param [out] out receive CPU set of <b>SQUID_NUMA_WORDS</b> words, CPU n
+ * being bit n % 64 of word n / 64.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_NUMA_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_NUMA_ERROR_NODE_IS_OUT_OF_BOUNDS if node is not below the
+ * count of nodes.
+ */
+bool squid_numa_cpus(uintmax_t node, uint64_t *out);
+
+/**
+ * @brief Retrieve the NUMA node the calling thread is running on.
+ * <p>The thread may be moved to another node right after unless it has
+ * been pinned.</p>
+ * @param [out] out receive index of node, zero if it cannot be told.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_NUMA_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_numa_current(uintmax_t *out);
+
+/**
+ * @brief Restrict the calling thread to a set of CPUs.
+ * @param [in] cpus set of <b>SQUID_NUMA_WORDS</b> words.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_NUMA_ERROR_CPUS_IS_NULL if cpus is <i>NULL</i>.
+ * @throws SQUID_NUMA_ERROR_CPUS_IS_EMPTY if cpus has no CPU in it.
+ * @throws SQUID_NUMA_ERROR_AFFINITY_FAILED if none of the CPUs are online
+ * and allowed for the process or pinning is not supported.
+ */
+bool squid_numa_pin(const uint64_t *cpus);
+
+/**
+ * @brief Parse a CPU list such as <i>0-3,8,10-11</i> as found in sysfs.
+ * @param [in] list text to be parsed, an empty list or one ending with a
+ * newline is accepted.
+ * @param [out] out receive CPU set of <b>SQUID_NUMA_WORDS</b> words.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_NUMA_ERROR_LIST_IS_NULL if list is <i>NULL</i>.
+ * @throws SQUID_NUMA_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_NUMA_ERROR_LIST_IS_INVALID if list is malformed or names a
+ * CPU beyond <b>SQUID_NUMA_CPUS</b>.
+ */
+bool squid_numa_parse(const char *list, uint64_t *out);
+
+#endif /* _SQUID_PRIVATE_NUMA_H_ */
@@ -0,0 +1,115 @@
+#ifndef _SQUID_PRIVATE_POOL_H_
+#define _SQUID_PRIVATE_POOL_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define SQUID_POOL_ERROR_OBJECT_IS_NULL                     1
+#define SQUID_POOL_ERROR_OUT_IS_NULL                        2
+#define SQUID_POOL_ERROR_SIZE_IS_INVALID                    3
+#define SQUID_POOL_ERROR_MEMORY_ALLOCATION_FAILED           4
+#define SQUID_POOL_ERROR_INDEX_IS_INVALID                   5
+
+#define SQUID_POOL_SLABS                                    27
+
+/**
+ * @brief Recycling pool of fixed size blocks.
+ * <p>Blocks are carved out of slabs which double in size and are only
+ * freed when the pool is invalidated. Released blocks are kept on a
+ * lock-free free list and are addressed by a 32-bit index so that the
+ * free list head can carry a tag against ABA.</p>
+ */
+struct squid_pool {
+    atomic_uint_least64_t head;
+    char padding[64 - sizeof(atomic_uint_least64_t)];
+    atomic_uint_least64_t used;
+    atomic_uintmax_t hits;
+    atomic_uintmax_t misses;
+    size_t size;
+    pthread_mutex_t mutex;
+    _Atomic(unsigned char *) slabs[SQUID_POOL_SLABS];
+};
+
+/**
+ * @brief Initialize pool.
+ * @param [in] object instance to be initialized.
+ * @param [in] size of each block.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_POOL_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_POOL_ERROR_SIZE_IS_INVALID if size is zero or too large.
+ * @throws SQUID_POOL_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to initialize instance.
+ */
+bool squid_pool_init(struct squid_pool *object, size_t size);
+
+/**
+ * @brief Invalidate pool.
+ * <p>The actual <u>pool instance is not deallocated</u> since it may
+ * have been embedded in a larger structure. All blocks, whether released
+ * or not, are deallocated.</p>
+ * @param [in] object instance to be invalidated.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_POOL_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ */
+bool squid_pool_invalidate(struct squid_pool *object);
+
+/**
+ * @brief Acquire block.
+ * @param [in] object pool instance.
+ * @param [out] out receive index of block.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_POOL_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_POOL_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_POOL_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to grow the pool.
+ */
+bool squid_pool_acquire(struct squid_pool *object, uint32_t *out);
+
+/**
+ * @brief Release block back to pool.
+ * @param [in] object pool instance.
+ * @param [in] index of block.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_POOL_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_POOL_ERROR_INDEX_IS_INVALID if index was never acquired.
+ */
+bool squid_pool_release(struct squid_pool *object, uint32_t index);
+
+/**
+ * @brief Retrieve block.
+ * @param [in] object pool instance.
+ * @param [in] index of block.
+ * @param [out] out receive block.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_POOL_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_POOL_ERROR_INDEX_IS_INVALID if index was never acquired.
+ * @throws SQUID_POOL_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_pool_at(const struct squid_pool *object,
+                   uint32_t index,
+                   void **out);
+
+/**
+ * @brief Retrieve count of acquisitions served by a recycled block.
+ * @param [in] object pool instance.
+ * @param [out] out receive count of hits.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_POOL_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_POOL_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_pool_hits(const struct squid_pool *object, uintmax_t *out);
+
+/**
+ * @brief Retrieve count of acquisitions that needed a fresh block.
+ * @param [in] object pool instance.
+ * @param [out] out receive count of misses.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_POOL_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_POOL_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_pool_misses(const struct squid_pool *object, uintmax_t *out);
+
+#endif /* _SQUID_PRIVATE_POOL_H_ */
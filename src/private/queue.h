@@ -0,0 +1,124 @@
+#ifndef _SQUID_PRIVATE_QUEUE_H_
+#define _SQUID_PRIVATE_QUEUE_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "pool.h"
+
+#define SQUID_QUEUE_ERROR_OBJECT_IS_NULL                    1
+#define SQUID_QUEUE_ERROR_OUT_IS_NULL                       2
+#define SQUID_QUEUE_ERROR_MEMORY_ALLOCATION_FAILED          3
+#define SQUID_QUEUE_ERROR_QUEUE_IS_EMPTY                    4
+#define SQUID_QUEUE_ERROR_ITEMS_IS_NULL                     5
+#define SQUID_QUEUE_ERROR_COUNT_IS_ZERO                     6
+#define SQUID_QUEUE_ERROR_FUNCTION_IS_NULL                  7
+
+/**
+ * @brief Unbounded lock-free linked queue.
+ * <p>A Michael-Scott queue whose nodes are recycled through a pool so that
+ * adding an item does not need to go through the allocator once the pool
+ * has warmed up.</p>
+ */
+struct squid_queue {
+    atomic_uint_least64_t head;
+    char padding[64 - sizeof(atomic_uint_least64_t)];
+    atomic_uint_least64_t tail;
+    char padding_[64 - sizeof(atomic_uint_least64_t)];
+    struct squid_pool nodes;
+};
+
+/**
+ * @brief Initialize queue.
+ * @param [in] object instance to be initialized.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_QUEUE_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_QUEUE_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to initialize instance.
+ */
+bool squid_queue_init(struct squid_queue *object);
+
+/**
+ * @brief Invalidate queue.
+ * <p>The actual <u>queue instance is not deallocated</u> since it may
+ * have been embedded in a larger structure. Items still in the queue are
+ * not touched.</p>
+ * @param [in] object instance to be invalidated.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_QUEUE_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ */
+bool squid_queue_invalidate(struct squid_queue *object);
+
+/**
+ * @brief Add item to the tail of the queue.
+ * @param [in] object queue instance.
+ * @param [in] item to be added.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_QUEUE_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_QUEUE_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to add item.
+ */
+bool squid_queue_add(struct squid_queue *object, void *item);
+
+/**
+ * @brief Add items to the tail of the queue in one go.
+ * <p>The items are linked together first and then spliced onto the tail
+ * with a single update, so they appear contiguously and in order. Either
+ * all items are added or none are.</p>
+ * @param [in] object queue instance.
+ * @param [in] items to be added.
+ * @param [in] count of items.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_QUEUE_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_QUEUE_ERROR_ITEMS_IS_NULL if items is <i>NULL</i>.
+ * @throws SQUID_QUEUE_ERROR_COUNT_IS_ZERO if count is zero.
+ * @throws SQUID_QUEUE_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to add items.
+ */
+bool squid_queue_add_all(struct squid_queue *object,
+                         void *const *items,
+                         uintmax_t count);
+
+/**
+ * @brief Remove item from the head of the queue.
+ * @param [in] object queue instance.
+ * @param [out] out receive item.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_QUEUE_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_QUEUE_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_QUEUE_ERROR_QUEUE_IS_EMPTY if queue is empty.
+ */
+bool squid_queue_remove(struct squid_queue *object, void **out);
+
+/**
+ * @brief Remove all items in one go.
+ * <p>Everything up to the current tail is detached with a single update of
+ * the head, after which the items are handed to function in order. Items
+ * added concurrently either end up detached or remain in the queue.</p>
+ * @param [in] object queue instance.
+ * @param [in] function to call with each of the removed items.
+ * @param [in] args to pass on to function.
+ * @param [out] out receive count of removed items.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_QUEUE_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_QUEUE_ERROR_FUNCTION_IS_NULL if function is <i>NULL</i>.
+ * @throws SQUID_QUEUE_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_queue_drain(struct squid_queue *object,
+                       void (*function)(void *item, void *args),
+                       void *args,
+                       uintmax_t *out);
+
+/**
+ * @brief Check if queue is empty.
+ * @param [in] object queue instance.
+ * @param [out] out receive true if queue is empty, otherwise false.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_QUEUE_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_QUEUE_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_queue_is_empty(const struct squid_queue *object, bool *out);
+
+#endif /* _SQUID_PRIVATE_QUEUE_H_ */
@@ -0,0 +1,112 @@
+#ifndef _SQUID_PRIVATE_RING_H_
+#define _SQUID_PRIVATE_RING_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define SQUID_RING_ERROR_OBJECT_IS_NULL                     1
+#define SQUID_RING_ERROR_OUT_IS_NULL                        2
+#define SQUID_RING_ERROR_CAPACITY_IS_INVALID                3
+#define SQUID_RING_ERROR_MEMORY_ALLOCATION_FAILED           4
+#define SQUID_RING_ERROR_RING_IS_FULL                       5
+#define SQUID_RING_ERROR_RING_IS_EMPTY                      6
+#define SQUID_RING_ERROR_ITEMS_IS_NULL                      7
+#define SQUID_RING_ERROR_COUNT_IS_ZERO                      8
+
+#define SQUID_RING_CACHE_LINE                               64
+
+struct squid_ring_slot;
+
+/**
+ * @brief Fixed capacity lock-free multi-producer multi-consumer ring.
+ * <p>Each slot carries a sequence number that tells producers and consumers
+ * whose turn it is so that neither side needs a lock. All memory is
+ * allocated up front and every slot sits on a cache line of its own so that
+ * producers and consumers working on neighbouring slots do not contend.</p>
+ */
+struct squid_ring {
+    atomic_uintmax_t head;
+    char padding[SQUID_RING_CACHE_LINE - sizeof(atomic_uintmax_t)];
+    atomic_uintmax_t tail;
+    char padding_[SQUID_RING_CACHE_LINE - sizeof(atomic_uintmax_t)];
+    uintmax_t mask;
+    struct squid_ring_slot *slots; /* aligned to a cache line */
+    void *memory;
+};
+
+/**
+ * @brief Initialize ring.
+ * @param [in] object instance to be initialized.
+ * @param [in] capacity of ring which is rounded up to a power of two.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_RING_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_RING_ERROR_CAPACITY_IS_INVALID if capacity is zero or too
+ * large to be rounded up to a power of two.
+ * @throws SQUID_RING_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to initialize instance.
+ */
+bool squid_ring_init(struct squid_ring *object, uintmax_t capacity);
+
+/**
+ * @brief Invalidate ring.
+ * <p>The actual <u>ring instance is not deallocated</u> since it may
+ * have been embedded in a larger structure. Items still in the ring are
+ * not touched.</p>
+ * @param [in] object instance to be invalidated.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_RING_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ */
+bool squid_ring_invalidate(struct squid_ring *object);
+
+/**
+ * @brief Add item to the tail of the ring.
+ * @param [in] object ring instance.
+ * @param [in] item to be added.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_RING_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_RING_ERROR_RING_IS_FULL if ring is at capacity.
+ */
+bool squid_ring_add(struct squid_ring *object, void *item);
+
+/**
+ * @brief Add items to the tail of the ring in one go.
+ * <p>The slots for all items are claimed together so the items appear
+ * contiguously and in order. Either all items are added or none are.</p>
+ * @param [in] object ring instance.
+ * @param [in] items to be added.
+ * @param [in] count of items.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_RING_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_RING_ERROR_ITEMS_IS_NULL if items is <i>NULL</i>.
+ * @throws SQUID_RING_ERROR_COUNT_IS_ZERO if count is zero.
+ * @throws SQUID_RING_ERROR_RING_IS_FULL if there is not enough room left
+ * for all items.
+ */
+bool squid_ring_add_all(struct squid_ring *object,
+                        void *const *items,
+                        uintmax_t count);
+
+/**
+ * @brief Remove item from the head of the ring.
+ * @param [in] object ring instance.
+ * @param [out] out receive item.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_RING_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_RING_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_RING_ERROR_RING_IS_EMPTY if ring is empty.
+ */
+bool squid_ring_remove(struct squid_ring *object, void **out);
+
+/**
+ * @brief Retrieve approximate count of items.
+ * @param [in] object ring instance.
+ * @param [out] out receive count of items.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_RING_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_RING_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_ring_count(const struct squid_ring *object, uintmax_t *out);
+
+#endif /* _SQUID_PRIVATE_RING_H_ */
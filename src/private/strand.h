@@ -0,0 +1,56 @@
+#ifndef _SQUID_PRIVATE_STRAND_H_
+#define _SQUID_PRIVATE_STRAND_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <triggerfish.h>
+#include <squid.h>
+
+#include "queue.h"
+
+struct squid_strand {
+    struct triggerfish_weak *self;
+    struct triggerfish_strong *executor;
+    struct squid_queue tasks; /* futures waiting for their turn */
+    atomic_uintmax_t pending; /* tasks submitted but not yet finished */
+    struct squid_strand *next; /* of those waiting to be dispatched */
+};
+
+/**
+ * @brief Initialize strand.
+ * @param [in] object instance to be initialized.
+ * @param [in] executor strong reference of the underlying executor.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_STRAND_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_STRAND_ERROR_EXECUTOR_IS_NULL if executor is <i>NULL</i>.
+ * @throws SQUID_STRAND_ERROR_IS_BUSY_SHUTTING_DOWN if strong reference of
+ * executor has been invalidated.
+ * @throws SQUID_STRAND_ERROR_MEMORY_ALLOCATION_FAILED if there is
+ * insufficient memory to initialize instance.
+ */
+bool squid_strand_init(struct squid_strand *object,
+                       struct triggerfish_strong *executor);
+
+/**
+ * @brief Invalidate strand.
+ * <p>The actual <u>strand instance is not deallocated</u> since it may
+ * have been embedded in a larger structure.</p>
+ * @param [in] object instance to be invalidated.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_STRAND_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ */
+bool squid_strand_invalidate(struct squid_strand *object);
+
+/**
+ * @brief Hand the next task of the strand over to its executor.
+ * <p>Must be called exactly once for each of the strand's tasks, after it
+ * has either run or been cancelled without running.</p>
+ * @param [in] object strand instance.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_STRAND_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ */
+bool squid_strand_advance(struct squid_strand *object);
+
+#endif /* _SQUID_PRIVATE_STRAND_H_ */
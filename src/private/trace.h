@@ -0,0 +1,43 @@
+#ifndef _SQUID_PRIVATE_TRACE_H_
+#define _SQUID_PRIVATE_TRACE_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <squid.h>
+
+enum squid_trace_kind {
+    SQUID_TRACE_KIND_ENQUEUE = 0,
+    SQUID_TRACE_KIND_START = 1,
+    SQUID_TRACE_KIND_FINISH = 2
+};
+
+#ifdef SQUID_TRACE
+/**
+ * @brief Record an event of a task into the calling thread's buffer.
+ * <p>Only the calling thread writes to its buffer so recording takes no
+ * lock. The event is dropped if the buffer is full or could not be
+ * allocated.</p>
+ * @param [in] kind of event.
+ * @param [in] task future or record that the event is about.
+ * @param [in] function of the task.
+ * @param [in] queued_at ns on <i>CLOCK_MONOTONIC</i> at which task was
+ * queued, together with task it ties the start of a task to its enqueue.
+ * Zero if task was never queued.
+ * @param [in] time ns on <i>CLOCK_MONOTONIC</i> at which the event took
+ * place.
+ */
+void squid_trace_record(enum squid_trace_kind kind,
+                        const void *task,
+                        squid_function function,
+                        uint64_t queued_at,
+                        uint64_t time);
+
+#define SQUID_TRACE_RECORD(kind, task, function, queued_at, time) \
+    squid_trace_record((kind), (task), (function), (queued_at), (time))
+#else
+#define SQUID_TRACE_RECORD(kind, task, function, queued_at, time) \
+    ((void) 0)
+#endif
+
+#endif /* _SQUID_PRIVATE_TRACE_H_ */
@@ -0,0 +1,166 @@
+#ifndef _SQUID_PRIVATE_WHEEL_H_
+#define _SQUID_PRIVATE_WHEEL_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SQUID_WHEEL_ERROR_OBJECT_IS_NULL                    1
+#define SQUID_WHEEL_ERROR_OUT_IS_NULL                       2
+#define SQUID_WHEEL_ERROR_TIMER_IS_NULL                     3
+#define SQUID_WHEEL_ERROR_TIMER_IS_ARMED                    4
+#define SQUID_WHEEL_ERROR_TIMER_IS_NOT_ARMED                5
+#define SQUID_WHEEL_ERROR_FUNCTION_IS_NULL                  6
+#define SQUID_WHEEL_ERROR_WHEEL_IS_EMPTY                    7
+
+#define SQUID_WHEEL_LEVELS                                  5
+#define SQUID_WHEEL_BITS                                    6
+#define SQUID_WHEEL_SLOTS                   (1 << SQUID_WHEEL_BITS)
+
+/**
+ * @brief Timer to be embedded in the structure that is to expire.
+ * <p>A timer is armed while it is linked into a wheel.</p>
+ */
+struct squid_wheel_timer {
+    struct squid_wheel_timer *next;
+    struct squid_wheel_timer *prev;
+    uint64_t expiry;
+    uint8_t level;
+    uint8_t slot;
+};
+
+/**
+ * @brief Hierarchical timer wheel.
+ * <p>Each level has 64 slots and each slot of a level spans all 64 slots of
+ * the level below it. Timers are added to the level that covers their
+ * expiry and move down a level whenever the wheel passes their slot, so
+ * adding and removing a timer takes constant time. Ticks are in whatever
+ * unit the caller chooses. The wheel is not thread-safe.</p>
+ */
+struct squid_wheel {
+    uint64_t now; /* next tick to be processed */
+    uintmax_t count;
+    uint64_t occupied[SQUID_WHEEL_LEVELS]; /* bit per non-empty slot */
+    struct squid_wheel_timer slots[SQUID_WHEEL_LEVELS][SQUID_WHEEL_SLOTS];
+};
+
+/**
+ * @brief Initialize wheel.
+ * @param [in] object instance to be initialized.
+ * @param [in] now tick the wheel starts at.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_WHEEL_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ */
+bool squid_wheel_init(struct squid_wheel *object, uint64_t now);
+
+/**
+ * @brief Invalidate wheel.
+ * <p>The actual <u>wheel instance is not deallocated</u> since it may
+ * have been embedded in a larger structure. Timers still in the wheel are
+ * not touched.</p>
+ * @param [in] object instance to be invalidated.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_WHEEL_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ */
+bool squid_wheel_invalidate(struct squid_wheel *object);
+
+/**
+ * @brief Arm timer to expire once the wheel reaches tick expiry.
+ * <p>An expiry that has already passed expires on the next advance.</p>
+ * @param [in] object wheel instance.
+ * @param [in] timer to be armed.
+ * @param [in] expiry tick of timer.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_WHEEL_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_WHEEL_ERROR_TIMER_IS_NULL if timer is <i>NULL</i>.
+ * @throws SQUID_WHEEL_ERROR_TIMER_IS_ARMED if timer is already armed.
+ */
+bool squid_wheel_add(struct squid_wheel *object,
+                     struct squid_wheel_timer *timer,
+                     uint64_t expiry);
+
+/**
+ * @brief Disarm timer.
+ * @param [in] object wheel instance.
+ * @param [in] timer to be disarmed.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_WHEEL_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_WHEEL_ERROR_TIMER_IS_NULL if timer is <i>NULL</i>.
+ * @throws SQUID_WHEEL_ERROR_TIMER_IS_NOT_ARMED if timer is not armed.
+ */
+bool squid_wheel_remove(struct squid_wheel *object,
+                        struct squid_wheel_timer *timer);
+
+/**
+ * @brief Check if timer is armed.
+ * @param [in] timer instance.
+ * @param [out] out receive true if timer is armed, otherwise false.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_WHEEL_ERROR_TIMER_IS_NULL if timer is <i>NULL</i>.
+ * @throws SQUID_WHEEL_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_wheel_is_armed(const struct squid_wheel_timer *timer, bool *out);
+
+/**
+ * @brief Advance wheel up to and including tick now.
+ * <p>Each timer whose expiry is at or before now is disarmed and handed to
+ * function, which may arm timers again. Stretches of ticks without
+ * anything to do are skipped over in one go.</p>
+ * @param [in] object wheel instance.
+ * @param [in] now tick to advance to.
+ * @param [in] function to call with each expired timer.
+ * @param [in] args to pass on to function.
+ * @param [out] out receive count of expired timers.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_WHEEL_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_WHEEL_ERROR_FUNCTION_IS_NULL if function is <i>NULL</i>.
+ * @throws SQUID_WHEEL_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_wheel_advance(struct squid_wheel *object,
+                         uint64_t now,
+                         void (*function)(struct squid_wheel_timer *timer,
+                                          void *args),
+                         void *args,
+                         uintmax_t *out);
+
+/**
+ * @brief Disarm all timers in one go.
+ * @param [in] object wheel instance.
+ * @param [in] function to call with each disarmed timer.
+ * @param [in] args to pass on to function.
+ * @param [out] out receive count of disarmed timers.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_WHEEL_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_WHEEL_ERROR_FUNCTION_IS_NULL if function is <i>NULL</i>.
+ * @throws SQUID_WHEEL_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_wheel_drain(struct squid_wheel *object,
+                       void (*function)(struct squid_wheel_timer *timer,
+                                        void *args),
+                       void *args,
+                       uintmax_t *out);
+
+/**
+ * @brief Retrieve the earliest tick at which advancing has work to do.
+ * <p>That is either the expiry of a timer or the tick at which timers are
+ * to be moved down a level, so it may be earlier than any expiry.</p>
+ * @param [in] object wheel instance.
+ * @param [out] out receive tick.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_WHEEL_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_WHEEL_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ * @throws SQUID_WHEEL_ERROR_WHEEL_IS_EMPTY if there are no armed timers.
+ */
+bool squid_wheel_next(const struct squid_wheel *object, uint64_t *out);
+
+/**
+ * @brief Retrieve count of armed timers.
+ * @param [in] object wheel instance.
+ * @param [out] out receive count of armed timers.
+ * @return On success true, otherwise false if an error has occurred.
+ * @throws SQUID_WHEEL_ERROR_OBJECT_IS_NULL if object is <i>NULL</i>.
+ * @throws SQUID_WHEEL_ERROR_OUT_IS_NULL if out is <i>NULL</i>.
+ */
+bool squid_wheel_count(const struct squid_wheel *object, uintmax_t *out);
+
+#endif /* _SQUID_PRIVATE_WHEEL_H_ */
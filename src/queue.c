@@ -0,0 +1,289 @@
+#include <stdlib.h>
+#include <assert.h>
+#include <seagrass.h>
+#include <squid.h>
+
+#include "private/queue.h"
+
+#ifdef TEST
+#include <test/cmocka.h>
+#endif
+
+/* references pack a pool index with a tag that is bumped on every update */
+#define INDEX(x)                    ((uint32_t) (x))
+#define TAG(x)                      ((uint64_t) (x) >> 32)
+#define REFERENCE(index, tag)       (((uint64_t) (tag) << 32) | (index))
+
+struct node {
+    atomic_uint_least64_t next;
+    _Atomic(void *) item;
+};
+
+static struct node *node(const struct squid_queue *const object,
+                         const uint32_t index) {
+    assert(object);
+    void *out;
+    seagrass_required_true(squid_pool_at(&object->nodes, index, &out));
+    return out;
+}
+
+bool squid_queue_init(struct squid_queue *const object) {
+    if (!object) {
+        squid_error = SQUID_QUEUE_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    *object = (struct squid_queue) {0};
+    if (!squid_pool_init(&object->nodes, sizeof(struct node))) {
+        seagrass_required_true(SQUID_POOL_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        squid_error = SQUID_QUEUE_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    uint32_t index;
+    if (!squid_pool_acquire(&object->nodes, &index)) {
+        seagrass_required_true(SQUID_POOL_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        seagrass_required_true(squid_pool_invalidate(&object->nodes));
+        squid_error = SQUID_QUEUE_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    struct node *const sentinel = node(object, index);
+    atomic_init(&sentinel->next, 0);
+    atomic_init(&sentinel->item, NULL);
+    atomic_init(&object->head, REFERENCE(index, 0));
+    atomic_init(&object->tail, REFERENCE(index, 0));
+    return true;
+}
+
+bool squid_queue_invalidate(struct squid_queue *const object) {
+    if (!object) {
+        squid_error = SQUID_QUEUE_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    seagrass_required_true(squid_pool_invalidate(&object->nodes));
+    *object = (struct squid_queue) {0};
+    return true;
+}
+
+static void prepare(struct node *const node, void *const item,
+                    const uint32_t next) {
+    assert(node);
+    atomic_store(&node->item, item);
+    /* a recycled node keeps bumping its tag so stale links cannot match */
+    const uint64_t previous = atomic_load(&node->next);
+    atomic_store(&node->next, REFERENCE(next, 1 + TAG(previous)));
+}
+
+static void splice(struct squid_queue *const object,
+                   const uint32_t first,
+                   const uint32_t last) {
+    assert(object);
+    while (true) {
+        uint64_t tail = atomic_load(&object->tail);
+        uint64_t next = atomic_load(&node(object, INDEX(tail))->next);
+        if (tail != atomic_load(&object->tail)) {
+            continue;
+        }
+        if (INDEX(next)) {
+            /* tail is lagging behind, help move it along */
+            atomic_compare_exchange_strong(
+                    &object->tail, &tail,
+                    REFERENCE(INDEX(next), 1 + TAG(tail)));
+            continue;
+        }
+        if (atomic_compare_exchange_strong(
+                &node(object, INDEX(tail))->next, &next,
+                REFERENCE(first, 1 + TAG(next)))) {
+            atomic_compare_exchange_strong(&object->tail, &tail,
+                                           REFERENCE(last, 1 + TAG(tail)));
+            return;
+        }
+    }
+}
+
+bool squid_queue_add(struct squid_queue *const object, void *const item) {
+    if (!object) {
+        squid_error = SQUID_QUEUE_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    uint32_t index;
+    if (!squid_pool_acquire(&object->nodes, &index)) {
+        seagrass_required_true(SQUID_POOL_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        squid_error = SQUID_QUEUE_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    prepare(node(object, index), item, 0);
+    splice(object, index, index);
+    return true;
+}
+
+bool squid_queue_add_all(struct squid_queue *const object,
+                         void *const *const items,
+                         const uintmax_t count) {
+    if (!object) {
+        squid_error = SQUID_QUEUE_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!items) {
+        squid_error = SQUID_QUEUE_ERROR_ITEMS_IS_NULL;
+        return false;
+    }
+    if (!count) {
+        squid_error = SQUID_QUEUE_ERROR_COUNT_IS_ZERO;
+        return false;
+    }
+    /* build the chain back to front so that each node knows its next */
+    uint32_t first = 0;
+    uint32_t last = 0;
+    for (uintmax_t i = count; i; i--) {
+        uint32_t index;
+        if (!squid_pool_acquire(&object->nodes, &index)) {
+            seagrass_required_true(SQUID_POOL_ERROR_MEMORY_ALLOCATION_FAILED
+                                   == squid_error);
+            while (first) {
+                const uint32_t next = INDEX(atomic_load(
+                        &node(object, first)->next));
+                seagrass_required_true(squid_pool_release(&object->nodes,
+                                                          first));
+                first = next;
+            }
+            squid_error = SQUID_QUEUE_ERROR_MEMORY_ALLOCATION_FAILED;
+            return false;
+        }
+        prepare(node(object, index), items[i - 1], first);
+        if (!last) {
+            last = index;
+        }
+        first = index;
+    }
+    splice(object, first, last);
+    return true;
+}
+
+bool squid_queue_remove(struct squid_queue *const object, void **const out) {
+    if (!object) {
+        squid_error = SQUID_QUEUE_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_QUEUE_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    while (true) {
+        uint64_t head = atomic_load(&object->head);
+        if (!INDEX(head)) {
+            /* queue has been invalidated */
+            squid_error = SQUID_QUEUE_ERROR_QUEUE_IS_EMPTY;
+            return false;
+        }
+        uint64_t tail = atomic_load(&object->tail);
+        const uint64_t next = atomic_load(&node(object, INDEX(head))->next);
+        if (head != atomic_load(&object->head)) {
+            continue;
+        }
+        if (INDEX(head) == INDEX(tail)) {
+            if (!INDEX(next)) {
+                squid_error = SQUID_QUEUE_ERROR_QUEUE_IS_EMPTY;
+                return false;
+            }
+            atomic_compare_exchange_strong(
+                    &object->tail, &tail,
+                    REFERENCE(INDEX(next), 1 + TAG(tail)));
+            continue;
+        }
+        if (!INDEX(next)) {
+            continue;
+        }
+        void *const item = atomic_load(&node(object, INDEX(next))->item);
+        if (atomic_compare_exchange_strong(
+                &object->head, &head,
+                REFERENCE(INDEX(next), 1 + TAG(head)))) {
+            /* next becomes the new sentinel, recycle the old one */
+            seagrass_required_true(squid_pool_release(&object->nodes,
+                                                      INDEX(head)));
+            *out = item;
+            return true;
+        }
+    }
+}
+
+bool squid_queue_drain(struct squid_queue *const object,
+                       void (*const function)(void *item, void *args),
+                       void *const args,
+                       uintmax_t *const out) {
+    if (!object) {
+        squid_error = SQUID_QUEUE_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!function) {
+        squid_error = SQUID_QUEUE_ERROR_FUNCTION_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_QUEUE_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    uint64_t head;
+    uint64_t tail;
+    void *last;
+    while (true) {
+        head = atomic_load(&object->head);
+        if (!INDEX(head)) {
+            /* queue has been invalidated */
+            *out = 0;
+            return true;
+        }
+        tail = atomic_load(&object->tail);
+        const uint64_t next = atomic_load(&node(object, INDEX(tail))->next);
+        if (tail != atomic_load(&object->tail)) {
+            continue;
+        }
+        if (INDEX(next)) {
+            /* tail is lagging behind, help move it along */
+            atomic_compare_exchange_strong(
+                    &object->tail, &tail,
+                    REFERENCE(INDEX(next), 1 + TAG(tail)));
+            continue;
+        }
+        if (INDEX(head) == INDEX(tail)) {
+            *out = 0;
+            return true;
+        }
+        /* tail becomes the new sentinel that others may recycle, everything
+         * before it is ours */
+        last = atomic_load(&node(object, INDEX(tail))->item);
+        if (atomic_compare_exchange_strong(
+                &object->head, &head,
+                REFERENCE(INDEX(tail), 1 + TAG(head)))) {
+            break;
+        }
+    }
+    uintmax_t count = 0;
+    for (uint32_t index = INDEX(head); index != INDEX(tail); count++) {
+        const uint32_t next = INDEX(atomic_load(&node(object, index)->next));
+        seagrass_required_true(squid_pool_release(&object->nodes, index));
+        function(INDEX(tail) == next
+                 ? last
+                 : atomic_load(&node(object, next)->item), args);
+        index = next;
+    }
+    *out = count;
+    return true;
+}
+
+bool squid_queue_is_empty(const struct squid_queue *const object,
+                          bool *const out) {
+    if (!object) {
+        squid_error = SQUID_QUEUE_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_QUEUE_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    const uint64_t head = atomic_load(&object->head);
+    *out = !INDEX(head)
+           || !INDEX(atomic_load(&node(object, INDEX(head))->next));
+    return true;
+}
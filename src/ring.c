@@ -0,0 +1,216 @@
+#include <stdlib.h>
+#include <squid.h>
+
+#include "private/ring.h"
+
+#ifdef TEST
+#include <test/cmocka.h>
+#endif
+
+/* a slot is free for position p once its sequence is p and holds the item
+ * of position p once its sequence is p + 1 */
+struct squid_ring_slot {
+    atomic_uintmax_t sequence;
+    _Atomic(void *) item;
+    /* keep neighbouring slots off each other's cache line */
+    char padding[SQUID_RING_CACHE_LINE - sizeof(atomic_uintmax_t)
+                 - sizeof(void *)];
+};
+
+bool squid_ring_init(struct squid_ring *const object,
+                     const uintmax_t capacity) {
+    if (!object) {
+        squid_error = SQUID_RING_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!capacity || capacity > (SIZE_MAX / 2)
+                                / sizeof(struct squid_ring_slot) - 1) {
+        squid_error = SQUID_RING_ERROR_CAPACITY_IS_INVALID;
+        return false;
+    }
+    uintmax_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    *object = (struct squid_ring) {0};
+    /* over-allocate by a cache line to align the slots ourselves */
+    object->memory = malloc((1 + size) * sizeof(*object->slots));
+    if (!object->memory) {
+        squid_error = SQUID_RING_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    const uintptr_t address = (uintptr_t) object->memory;
+    object->slots = (struct squid_ring_slot *) (
+            (address + SQUID_RING_CACHE_LINE - 1)
+            & ~(uintptr_t) (SQUID_RING_CACHE_LINE - 1));
+    for (uintmax_t i = 0; i < size; i++) {
+        atomic_init(&object->slots[i].sequence, i);
+        atomic_init(&object->slots[i].item, NULL);
+    }
+    object->mask = size - 1;
+    return true;
+}
+
+bool squid_ring_invalidate(struct squid_ring *const object) {
+    if (!object) {
+        squid_error = SQUID_RING_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    free(object->memory);
+    *object = (struct squid_ring) {0};
+    return true;
+}
+
+static void publish(struct squid_ring *const object,
+                    const uintmax_t position,
+                    void *const item) {
+    struct squid_ring_slot *const slot = &object->slots[position
+                                                        & object->mask];
+    atomic_store_explicit(&slot->item, item, memory_order_relaxed);
+    atomic_store_explicit(&slot->sequence, 1 + position,
+                          memory_order_release);
+}
+
+bool squid_ring_add(struct squid_ring *const object, void *const item) {
+    if (!object) {
+        squid_error = SQUID_RING_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    uintmax_t position = atomic_load_explicit(&object->tail,
+                                              memory_order_relaxed);
+    while (true) {
+        const uintmax_t sequence = atomic_load_explicit(
+                &object->slots[position & object->mask].sequence,
+                memory_order_acquire);
+        const intmax_t difference = (intmax_t) (sequence - position);
+        if (difference < 0) {
+            /* slot still holds the item of the previous lap */
+            squid_error = SQUID_RING_ERROR_RING_IS_FULL;
+            return false;
+        }
+        if (!difference) {
+            if (atomic_compare_exchange_weak_explicit(
+                    &object->tail, &position, 1 + position,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+            continue;
+        }
+        position = atomic_load_explicit(&object->tail,
+                                        memory_order_relaxed);
+    }
+    publish(object, position, item);
+    return true;
+}
+
+bool squid_ring_add_all(struct squid_ring *const object,
+                        void *const *const items,
+                        const uintmax_t count) {
+    if (!object) {
+        squid_error = SQUID_RING_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!items) {
+        squid_error = SQUID_RING_ERROR_ITEMS_IS_NULL;
+        return false;
+    }
+    if (!count) {
+        squid_error = SQUID_RING_ERROR_COUNT_IS_ZERO;
+        return false;
+    }
+    if (count > 1 + object->mask) {
+        squid_error = SQUID_RING_ERROR_RING_IS_FULL;
+        return false;
+    }
+    uintmax_t position = atomic_load_explicit(&object->tail,
+                                              memory_order_relaxed);
+    while (true) {
+        /* every slot we are about to claim has to be free for this lap */
+        intmax_t difference = 0;
+        for (uintmax_t i = 0; i < count && !difference; i++) {
+            const uintmax_t sequence = atomic_load_explicit(
+                    &object->slots[(position + i) & object->mask].sequence,
+                    memory_order_acquire);
+            difference = (intmax_t) (sequence - (position + i));
+        }
+        if (difference < 0) {
+            squid_error = SQUID_RING_ERROR_RING_IS_FULL;
+            return false;
+        }
+        if (!difference) {
+            if (atomic_compare_exchange_weak_explicit(
+                    &object->tail, &position, count + position,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+            continue;
+        }
+        position = atomic_load_explicit(&object->tail,
+                                        memory_order_relaxed);
+    }
+    for (uintmax_t i = 0; i < count; i++) {
+        publish(object, position + i, items[i]);
+    }
+    return true;
+}
+
+bool squid_ring_remove(struct squid_ring *const object, void **const out) {
+    if (!object) {
+        squid_error = SQUID_RING_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_RING_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    if (!object->slots) {
+        /* ring has been invalidated */
+        squid_error = SQUID_RING_ERROR_RING_IS_EMPTY;
+        return false;
+    }
+    uintmax_t position = atomic_load_explicit(&object->head,
+                                              memory_order_relaxed);
+    struct squid_ring_slot *slot;
+    while (true) {
+        slot = &object->slots[position & object->mask];
+        const uintmax_t sequence = atomic_load_explicit(
+                &slot->sequence, memory_order_acquire);
+        const intmax_t difference = (intmax_t) (sequence - (1 + position));
+        if (difference < 0) {
+            /* slot has not been filled for this lap yet */
+            squid_error = SQUID_RING_ERROR_RING_IS_EMPTY;
+            return false;
+        }
+        if (!difference) {
+            if (atomic_compare_exchange_weak_explicit(
+                    &object->head, &position, 1 + position,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+            continue;
+        }
+        position = atomic_load_explicit(&object->head,
+                                        memory_order_relaxed);
+    }
+    *out = atomic_load_explicit(&slot->item, memory_order_relaxed);
+    /* hand the slot over to the producer of the next lap */
+    atomic_store_explicit(&slot->sequence, 1 + object->mask + position,
+                          memory_order_release);
+    return true;
+}
+
+bool squid_ring_count(const struct squid_ring *const object,
+                      uintmax_t *const out) {
+    if (!object) {
+        squid_error = SQUID_RING_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_RING_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    const uintmax_t head = atomic_load(&object->head);
+    const uintmax_t tail = atomic_load(&object->tail);
+    *out = tail > head ? tail - head : 0;
+    return true;
+}
@@ -0,0 +1,246 @@
+#include <stdlib.h>
+#include <assert.h>
+#include <seagrass.h>
+#include <squid.h>
+
+#include "private/strand.h"
+#include "private/executer.h"
+#include "private/future.h"
+
+#ifdef TEST
+#include <test/cmocka.h>
+#endif
+
+static void invalidate(struct squid_strand *const object) {
+    assert(object);
+    if (!triggerfish_weak_destroy(object->self)) {
+        seagrass_required_true(TRIGGERFISH_WEAK_ERROR_OBJECT_IS_NULL
+                               == triggerfish_error);
+    }
+    /* every queued task holds the strand alive so none can be left over */
+    if (!squid_queue_invalidate(&object->tasks)) {
+        seagrass_required_true(SQUID_QUEUE_ERROR_OBJECT_IS_NULL
+                               == squid_error);
+    }
+    triggerfish_strong_release(object->executor);
+    *object = (struct squid_strand) {0};
+}
+
+bool squid_strand_init(struct squid_strand *const object,
+                       struct triggerfish_strong *const executor) {
+    if (!object) {
+        squid_error = SQUID_STRAND_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!executor) {
+        squid_error = SQUID_STRAND_ERROR_EXECUTOR_IS_NULL;
+        return false;
+    }
+    *object = (struct squid_strand) {0};
+    if (!triggerfish_strong_retain(executor)) {
+        seagrass_required_true(TRIGGERFISH_STRONG_ERROR_OBJECT_IS_INVALID
+                               == triggerfish_error);
+        squid_error = SQUID_STRAND_ERROR_IS_BUSY_SHUTTING_DOWN;
+        return false;
+    }
+    object->executor = executor;
+    if (!squid_queue_init(&object->tasks)) {
+        seagrass_required_true(SQUID_QUEUE_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        seagrass_required_true(triggerfish_strong_release(executor));
+        *object = (struct squid_strand) {0};
+        squid_error = SQUID_STRAND_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    return true;
+}
+
+bool squid_strand_invalidate(struct squid_strand *const object) {
+    if (!object) {
+        squid_error = SQUID_STRAND_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    invalidate(object);
+    return true;
+}
+
+static void on_destroy(void *const object) {
+    seagrass_required_true(squid_strand_invalidate(object));
+}
+
+bool squid_strand_of(struct squid_executor *const executor,
+                     struct triggerfish_strong **const out) {
+    if (!executor) {
+        squid_error = SQUID_STRAND_ERROR_EXECUTOR_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_STRAND_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    bool result;
+    seagrass_required_true(squid_executor_is_running(executor, &result));
+    if (!result) {
+        squid_error = SQUID_STRAND_ERROR_IS_BUSY_SHUTTING_DOWN;
+        return false;
+    }
+    struct triggerfish_strong *reference;
+    if (!triggerfish_weak_strong(executor->self, &reference)) {
+        seagrass_required_true(TRIGGERFISH_WEAK_ERROR_STRONG_IS_INVALID
+                               == triggerfish_error);
+        squid_error = SQUID_STRAND_ERROR_IS_BUSY_SHUTTING_DOWN;
+        return false;
+    }
+    struct squid_strand *object = malloc(sizeof(*object));
+    if (!object) {
+        seagrass_required_true(triggerfish_strong_release(reference));
+        squid_error = SQUID_STRAND_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    result = squid_strand_init(object, reference);
+    seagrass_required_true(triggerfish_strong_release(reference));
+    if (!result) {
+        seagrass_required_true(SQUID_STRAND_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        free(object);
+        return false;
+    }
+    struct triggerfish_strong *strong;
+    if (!triggerfish_strong_of(object, on_destroy, &strong)) {
+        seagrass_required_true(
+                TRIGGERFISH_STRONG_ERROR_MEMORY_ALLOCATION_FAILED
+                == triggerfish_error);
+        invalidate(object);
+        free(object);
+        squid_error = SQUID_STRAND_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    if (!triggerfish_weak_of(strong, &object->self)) {
+        seagrass_required_true(
+                TRIGGERFISH_WEAK_ERROR_MEMORY_ALLOCATION_FAILED
+                == triggerfish_error);
+        seagrass_required_true(triggerfish_strong_release(strong));
+        squid_error = SQUID_STRAND_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    *out = strong;
+    return true;
+}
+
+/* strands whose next task has yet to be handed over by this thread */
+static _Thread_local struct squid_strand *deferred;
+static _Thread_local bool is_dispatching;
+
+/* a task may finish while it is being handed over, for instance when it is
+ * run on the submitting thread or cancelled right away, so handing over the
+ * next one is deferred to the outermost call rather than nested */
+static void dispatch(struct squid_strand *const object) {
+    assert(object);
+    object->next = deferred;
+    deferred = object;
+    if (is_dispatching) {
+        return;
+    }
+    is_dispatching = true;
+    while (deferred) {
+        struct squid_strand *const strand = deferred;
+        deferred = strand->next;
+        /* the task was added ahead of bumping the count that we were let
+         * through by */
+        struct triggerfish_strong *item;
+        seagrass_required_true(squid_queue_remove(&strand->tasks,
+                                                  (void **) &item));
+        struct squid_future *future;
+        seagrass_required_true(triggerfish_strong_instance(
+                item, (void **) &future));
+        seagrass_required_true(squid_executor_resume(future));
+        seagrass_required_true(triggerfish_strong_release(item));
+    }
+    is_dispatching = false;
+}
+
+bool squid_strand_advance(struct squid_strand *const object) {
+    if (!object) {
+        squid_error = SQUID_STRAND_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (1 < atomic_fetch_sub(&object->pending, 1)) {
+        dispatch(object);
+    }
+    return true;
+}
+
+bool squid_strand_submit(struct squid_strand *const object,
+                         squid_function const function,
+                         void *const args,
+                         struct triggerfish_strong **const out) {
+    if (!object) {
+        squid_error = SQUID_STRAND_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!function) {
+        squid_error = SQUID_STRAND_ERROR_FUNCTION_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_STRAND_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    struct squid_executor *executor;
+    seagrass_required_true(triggerfish_strong_instance(
+            object->executor, (void **) &executor));
+    bool result;
+    seagrass_required_true(squid_executor_is_running(executor, &result));
+    if (!result) {
+        squid_error = SQUID_STRAND_ERROR_IS_BUSY_SHUTTING_DOWN;
+        return false;
+    }
+    struct triggerfish_strong *self;
+    if (!triggerfish_weak_strong(object->self, &self)) {
+        seagrass_required_true(TRIGGERFISH_WEAK_ERROR_STRONG_IS_INVALID
+                               == triggerfish_error);
+        squid_error = SQUID_STRAND_ERROR_IS_BUSY_SHUTTING_DOWN;
+        return false;
+    }
+    struct triggerfish_strong *future;
+    if (!squid_future_of(object->executor, function, args, &future)) {
+        seagrass_required_true(SQUID_FUTURE_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        seagrass_required_true(triggerfish_strong_release(self));
+        squid_error = SQUID_STRAND_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    struct squid_future *instance;
+    seagrass_required_true(triggerfish_strong_instance(
+            future, (void **) &instance));
+    /* future keeps the strand alive until it has handed over the next task */
+    instance->strand = self;
+    seagrass_required_true(triggerfish_strong_retain(future));
+    if (!squid_queue_add(&object->tasks, future)) {
+        seagrass_required_true(SQUID_QUEUE_ERROR_MEMORY_ALLOCATION_FAILED
+                               == squid_error);
+        seagrass_required_true(triggerfish_strong_release(future));
+        seagrass_required_true(triggerfish_strong_release(future));
+        squid_error = SQUID_STRAND_ERROR_MEMORY_ALLOCATION_FAILED;
+        return false;
+    }
+    if (!atomic_fetch_add(&object->pending, 1)) {
+        dispatch(object);
+    }
+    *out = future;
+    return true;
+}
+
+bool squid_strand_pending(const struct squid_strand *const object,
+                          uintmax_t *const out) {
+    if (!object) {
+        squid_error = SQUID_STRAND_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_STRAND_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    *out = atomic_load(&object->pending);
+    return true;
+}
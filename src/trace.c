@@ -0,0 +1,255 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <pthread.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#include <seagrass.h>
+#include <squid.h>
+
+#include "private/trace.h"
+
+#ifdef TEST
+#include <test/cmocka.h>
+#endif
+
+#ifdef SQUID_TRACE
+
+/* events per thread, a power of two */
+#define CAPACITY                                            4096
+#define CACHE_LINE                                          64
+
+struct event {
+    uint64_t time;
+    uint64_t queued_at;
+    const void *task;
+    squid_function function;
+    int32_t thread;
+    uint8_t kind;
+};
+
+/* written to by its thread only and emptied by dumps */
+struct buffer {
+    atomic_uint_least64_t head;
+    char padding[CACHE_LINE - sizeof(atomic_uint_least64_t)];
+    atomic_uint_least64_t tail;
+    atomic_uintmax_t dropped;
+    atomic_bool is_claimed;
+    int32_t thread;
+    struct buffer *next;
+    struct event events[CAPACITY];
+};
+
+static _Atomic(struct buffer *) buffers;
+static _Thread_local struct buffer *buffer;
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+static pthread_key_t key;
+#if !defined(__linux__)
+/* stands in for thread ids where the OS has none to give */
+static atomic_int_least32_t sequence;
+#endif
+/* one dump at a time */
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* lets a later thread take over the buffer of one that has exited */
+static void release(void *const object) {
+    struct buffer *const buffer = object;
+    atomic_store(&buffer->is_claimed, false);
+}
+
+static void create(void) {
+    seagrass_required_true(!pthread_key_create(&key, release));
+}
+
+static struct buffer *claim(void) {
+    seagrass_required_true(!pthread_once(&once, create));
+    struct buffer *object = atomic_load(&buffers);
+    for (; object; object = object->next) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&object->is_claimed, &expected,
+                                           true)) {
+            break;
+        }
+    }
+    if (!object) {
+        void *memory;
+        if (posix_memalign(&memory, CACHE_LINE, sizeof(*object))) {
+            return NULL;
+        }
+        object = memset(memory, 0, sizeof(*object));
+        atomic_init(&object->is_claimed, true);
+        object->next = atomic_load(&buffers);
+        while (!atomic_compare_exchange_weak(&buffers, &object->next,
+                                             object)) {
+            /* retry with the new head */
+        }
+    }
+    if (pthread_setspecific(key, object)) {
+        release(object);
+        return NULL;
+    }
+#if defined(__linux__)
+    object->thread = (int32_t) syscall(SYS_gettid);
+#else
+    object->thread = atomic_fetch_add(&sequence, 1) + 1;
+#endif
+    return object;
+}
+
+void squid_trace_record(const enum squid_trace_kind kind,
+                        const void *const task,
+                        squid_function const function,
+                        const uint64_t queued_at,
+                        const uint64_t time) {
+    if (!buffer && !(buffer = claim())) {
+        return;
+    }
+    const uint64_t head = atomic_load_explicit(&buffer->head,
+                                               memory_order_relaxed);
+    /* a dump must be done reading an event before we overwrite it */
+    if (head - atomic_load_explicit(&buffer->tail, memory_order_acquire)
+        >= CAPACITY) {
+        atomic_fetch_add_explicit(&buffer->dropped, 1, memory_order_relaxed);
+        return;
+    }
+    buffer->events[head & (CAPACITY - 1)] = (struct event) {
+            .time = time,
+            .queued_at = queued_at,
+            .task = task,
+            .function = function,
+            .thread = buffer->thread,
+            .kind = (uint8_t) kind
+    };
+    atomic_store_explicit(&buffer->head, head + 1, memory_order_release);
+}
+
+static bool emit(FILE *const file, bool *const is_first,
+                 const char *const format, ...) {
+    if (!*is_first && EOF == fputc(',', file)) {
+        return false;
+    }
+    *is_first = false;
+    va_list args;
+    va_start(args, format);
+    const int result = vfprintf(file, format, args);
+    va_end(args);
+    return result >= 0;
+}
+
+/* timestamps are in µs with ns as the fraction */
+#define TS                  "%" PRIu64 ".%03" PRIu64
+#define TS_ARGS(ns)         (ns) / 1000, (ns) % 1000
+
+static bool write_event(FILE *const file, bool *const is_first,
+                        const long pid, const struct event *const event) {
+    switch (event->kind) {
+        case SQUID_TRACE_KIND_ENQUEUE:
+            /* the arrow needs a slice on the queuing thread to start from */
+            return emit(file, is_first,
+                        "{\"name\":\"enqueue\",\"cat\":\"squid\",\"ph\":\"X\","
+                        "\"pid\":%ld,\"tid\":%" PRId32 ",\"ts\":" TS ","
+                        "\"dur\":0,\"args\":{\"task\":\"%p\"}}",
+                        pid, event->thread, TS_ARGS(event->time), event->task)
+                   && emit(file, is_first,
+                           "{\"name\":\"queued\",\"cat\":\"squid\",\"ph\":\"s\","
+                           "\"id\":\"%p:%" PRIu64 "\",\"pid\":%ld,"
+                           "\"tid\":%" PRId32 ",\"ts\":" TS "}",
+                           event->task, event->queued_at, pid, event->thread,
+                           TS_ARGS(event->time));
+        case SQUID_TRACE_KIND_START: {
+            if (event->queued_at
+                && !emit(file, is_first,
+                         "{\"name\":\"queued\",\"cat\":\"squid\",\"ph\":\"f\","
+                         "\"bp\":\"e\",\"id\":\"%p:%" PRIu64 "\","
+                         "\"pid\":%ld,\"tid\":%" PRId32 ",\"ts\":" TS "}",
+                         event->task, event->queued_at, pid, event->thread,
+                         TS_ARGS(event->time))) {
+                return false;
+            }
+            const uint64_t waited = event->queued_at
+                                    ? event->time - event->queued_at : 0;
+            return emit(file, is_first,
+                        "{\"name\":\"%p\",\"cat\":\"squid\",\"ph\":\"B\","
+                        "\"pid\":%ld,\"tid\":%" PRId32 ",\"ts\":" TS ","
+                        "\"args\":{\"task\":\"%p\",\"waited_us\":" TS "}}",
+                        (void *) (uintptr_t) event->function, pid,
+                        event->thread, TS_ARGS(event->time), event->task,
+                        TS_ARGS(waited));
+        }
+        case SQUID_TRACE_KIND_FINISH:
+            return emit(file, is_first,
+                        "{\"ph\":\"E\",\"pid\":%ld,\"tid\":%" PRId32 ","
+                        "\"ts\":" TS "}",
+                        pid, event->thread, TS_ARGS(event->time));
+        default:
+            return true;
+    }
+}
+
+/* takes the events out of each buffer whether or not they could be written */
+static bool write_events(FILE *const file) {
+    const long pid = (long) getpid();
+    bool is_first = true;
+    bool result = true;
+    for (struct buffer *object = atomic_load(&buffers); object;
+         object = object->next) {
+        const uint64_t tail = atomic_load_explicit(&object->tail,
+                                                   memory_order_relaxed);
+        const uint64_t head = atomic_load_explicit(&object->head,
+                                                   memory_order_acquire);
+        for (uint64_t i = tail; result && i < head; i++) {
+            result = write_event(file, &is_first, pid,
+                                 &object->events[i & (CAPACITY - 1)]);
+        }
+        atomic_store_explicit(&object->tail, head, memory_order_release);
+        const uintmax_t dropped = atomic_exchange_explicit(
+                &object->dropped, 0, memory_order_relaxed);
+        if (result && dropped && head > tail) {
+            const struct event *const last
+                    = &object->events[(head - 1) & (CAPACITY - 1)];
+            result = emit(file, &is_first,
+                          "{\"name\":\"dropped\",\"cat\":\"squid\","
+                          "\"ph\":\"i\",\"s\":\"t\",\"pid\":%ld,"
+                          "\"tid\":%" PRId32 ",\"ts\":" TS ","
+                          "\"args\":{\"count\":%" PRIuMAX "}}",
+                          pid, last->thread, TS_ARGS(last->time), dropped);
+        }
+    }
+    return result;
+}
+
+#endif /* SQUID_TRACE */
+
+bool squid_trace_dump(const char *const path) {
+    if (!path) {
+        squid_error = SQUID_TRACE_ERROR_PATH_IS_NULL;
+        return false;
+    }
+#ifdef SQUID_TRACE
+    FILE *const file = fopen(path, "w");
+    if (!file) {
+        squid_error = SQUID_TRACE_ERROR_FILE_OPEN_FAILED;
+        return false;
+    }
+    bool result = fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[",
+                        file) >= 0;
+    seagrass_required_true(!pthread_mutex_lock(&mutex));
+    result = write_events(file) && result;
+    seagrass_required_true(!pthread_mutex_unlock(&mutex));
+    result = result && fputs("]}\n", file) >= 0;
+    result = !fclose(file) && result;
+    if (!result) {
+        squid_error = SQUID_TRACE_ERROR_FILE_WRITE_FAILED;
+        return false;
+    }
+    return true;
+#else
+    squid_error = SQUID_TRACE_ERROR_IS_DISABLED;
+    return false;
+#endif
+}
@@ -0,0 +1,298 @@
+#include <squid.h>
+
+#include "private/wheel.h"
+
+#ifdef TEST
+#include <test/cmocka.h>
+#endif
+
+static inline uint64_t span(const uintmax_t level) {
+    return (uint64_t) 1 << (SQUID_WHEEL_BITS * level);
+}
+
+static inline uint64_t rotate(const uint64_t value, const uintmax_t count) {
+    const uintmax_t shift = count % SQUID_WHEEL_SLOTS;
+    return shift ? value >> shift | value << (SQUID_WHEEL_SLOTS - shift)
+                 : value;
+}
+
+bool squid_wheel_init(struct squid_wheel *const object, const uint64_t now) {
+    if (!object) {
+        squid_error = SQUID_WHEEL_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    *object = (struct squid_wheel) {
+            .now = now
+    };
+    for (uintmax_t i = 0; i < SQUID_WHEEL_LEVELS; i++) {
+        for (uintmax_t j = 0; j < SQUID_WHEEL_SLOTS; j++) {
+            struct squid_wheel_timer *const sentinel = &object->slots[i][j];
+            sentinel->next = sentinel;
+            sentinel->prev = sentinel;
+        }
+    }
+    return true;
+}
+
+bool squid_wheel_invalidate(struct squid_wheel *const object) {
+    if (!object) {
+        squid_error = SQUID_WHEEL_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    *object = (struct squid_wheel) {0};
+    return true;
+}
+
+static void attach(struct squid_wheel_timer *const list,
+                   struct squid_wheel_timer *const timer) {
+    timer->next = list;
+    timer->prev = list->prev;
+    list->prev->next = timer;
+    list->prev = timer;
+}
+
+static void detach(struct squid_wheel_timer *const timer) {
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+/* move the timers of a slot onto list and leave the slot empty */
+static void splice(struct squid_wheel *const object,
+                   const uintmax_t level,
+                   const uintmax_t slot,
+                   struct squid_wheel_timer *const list) {
+    struct squid_wheel_timer *const sentinel = &object->slots[level][slot];
+    list->next = list;
+    list->prev = list;
+    if (sentinel->next == sentinel) {
+        return;
+    }
+    list->next = sentinel->next;
+    list->prev = sentinel->prev;
+    list->next->prev = list;
+    list->prev->next = list;
+    sentinel->next = sentinel;
+    sentinel->prev = sentinel;
+    object->occupied[level] &= ~((uint64_t) 1 << slot);
+}
+
+static void place(struct squid_wheel *const object,
+                  struct squid_wheel_timer *const timer) {
+    uint64_t expiry = timer->expiry < object->now
+                      ? object->now
+                      : timer->expiry;
+    const uint64_t delta = expiry - object->now;
+    uintmax_t level = 0;
+    while (level < SQUID_WHEEL_LEVELS - 1 && delta >= span(1 + level)) {
+        level++;
+    }
+    if (delta >= span(SQUID_WHEEL_LEVELS)) {
+        /* beyond the reach of the wheel, revisited once the top level
+         * comes around to it */
+        expiry = object->now + span(SQUID_WHEEL_LEVELS) - 1;
+    }
+    const uintmax_t slot = (expiry >> (SQUID_WHEEL_BITS * level))
+                           & (SQUID_WHEEL_SLOTS - 1);
+    timer->level = (uint8_t) level;
+    timer->slot = (uint8_t) slot;
+    attach(&object->slots[level][slot], timer);
+    object->occupied[level] |= (uint64_t) 1 << slot;
+}
+
+bool squid_wheel_add(struct squid_wheel *const object,
+                     struct squid_wheel_timer *const timer,
+                     const uint64_t expiry) {
+    if (!object) {
+        squid_error = SQUID_WHEEL_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!timer) {
+        squid_error = SQUID_WHEEL_ERROR_TIMER_IS_NULL;
+        return false;
+    }
+    if (timer->next) {
+        squid_error = SQUID_WHEEL_ERROR_TIMER_IS_ARMED;
+        return false;
+    }
+    timer->expiry = expiry;
+    place(object, timer);
+    object->count++;
+    return true;
+}
+
+bool squid_wheel_remove(struct squid_wheel *const object,
+                        struct squid_wheel_timer *const timer) {
+    if (!object) {
+        squid_error = SQUID_WHEEL_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!timer) {
+        squid_error = SQUID_WHEEL_ERROR_TIMER_IS_NULL;
+        return false;
+    }
+    if (!timer->next) {
+        squid_error = SQUID_WHEEL_ERROR_TIMER_IS_NOT_ARMED;
+        return false;
+    }
+    detach(timer);
+    const struct squid_wheel_timer *const sentinel
+            = &object->slots[timer->level][timer->slot];
+    if (sentinel->next == sentinel) {
+        object->occupied[timer->level] &= ~((uint64_t) 1 << timer->slot);
+    }
+    object->count--;
+    return true;
+}
+
+bool squid_wheel_is_armed(const struct squid_wheel_timer *const timer,
+                          bool *const out) {
+    if (!timer) {
+        squid_error = SQUID_WHEEL_ERROR_TIMER_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_WHEEL_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    *out = timer->next;
+    return true;
+}
+
+static uint64_t next(const struct squid_wheel *const object) {
+    uint64_t result = UINT64_MAX;
+    for (uintmax_t i = 0; i < SQUID_WHEEL_LEVELS; i++) {
+        if (!object->occupied[i]) {
+            continue;
+        }
+        /* slots of the upper levels are processed on their first tick */
+        const uint64_t first = (object->now + span(i) - 1)
+                               >> (SQUID_WHEEL_BITS * i);
+        const uint64_t tick = (first + __builtin_ctzll(rotate(
+                object->occupied[i], first))) << (SQUID_WHEEL_BITS * i);
+        if (tick < result) {
+            result = tick;
+        }
+    }
+    return result;
+}
+
+bool squid_wheel_advance(struct squid_wheel *const object,
+                         const uint64_t now,
+                         void (*const function)(struct squid_wheel_timer *,
+                                                void *),
+                         void *const args,
+                         uintmax_t *const out) {
+    if (!object) {
+        squid_error = SQUID_WHEEL_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!function) {
+        squid_error = SQUID_WHEEL_ERROR_FUNCTION_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_WHEEL_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    *out = 0;
+    struct squid_wheel_timer list;
+    uint64_t tick;
+    while (object->count && (tick = next(object)) <= now) {
+        object->now = tick;
+        /* move the timers of upper level slots that start here down */
+        for (uintmax_t i = 1; i < SQUID_WHEEL_LEVELS; i++) {
+            if (tick & (span(i) - 1)) {
+                break;
+            }
+            splice(object, i, (tick >> (SQUID_WHEEL_BITS * i))
+                              & (SQUID_WHEEL_SLOTS - 1), &list);
+            while (list.next != &list) {
+                struct squid_wheel_timer *const timer = list.next;
+                detach(timer);
+                place(object, timer);
+            }
+        }
+        splice(object, 0, tick & (SQUID_WHEEL_SLOTS - 1), &list);
+        /* timers armed by function must not land in this tick */
+        object->now = 1 + tick;
+        while (list.next != &list) {
+            struct squid_wheel_timer *const timer = list.next;
+            detach(timer);
+            object->count--;
+            (*out)++;
+            function(timer, args);
+        }
+    }
+    if (now >= object->now && now < UINT64_MAX) {
+        object->now = 1 + now;
+    }
+    return true;
+}
+
+bool squid_wheel_drain(struct squid_wheel *const object,
+                       void (*const function)(struct squid_wheel_timer *,
+                                              void *),
+                       void *const args,
+                       uintmax_t *const out) {
+    if (!object) {
+        squid_error = SQUID_WHEEL_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!function) {
+        squid_error = SQUID_WHEEL_ERROR_FUNCTION_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_WHEEL_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    *out = 0;
+    struct squid_wheel_timer list;
+    for (uintmax_t i = 0; i < SQUID_WHEEL_LEVELS; i++) {
+        while (object->occupied[i]) {
+            splice(object, i, __builtin_ctzll(object->occupied[i]), &list);
+            while (list.next != &list) {
+                struct squid_wheel_timer *const timer = list.next;
+                detach(timer);
+                object->count--;
+                (*out)++;
+                function(timer, args);
+            }
+        }
+    }
+    return true;
+}
+
+bool squid_wheel_next(const struct squid_wheel *const object,
+                      uint64_t *const out) {
+    if (!object) {
+        squid_error = SQUID_WHEEL_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_WHEEL_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    if (!object->count) {
+        squid_error = SQUID_WHEEL_ERROR_WHEEL_IS_EMPTY;
+        return false;
+    }
+    *out = next(object);
+    return true;
+}
+
+bool squid_wheel_count(const struct squid_wheel *const object,
+                       uintmax_t *const out) {
+    if (!object) {
+        squid_error = SQUID_WHEEL_ERROR_OBJECT_IS_NULL;
+        return false;
+    }
+    if (!out) {
+        squid_error = SQUID_WHEEL_ERROR_OUT_IS_NULL;
+        return false;
+    }
+    *out = object->count;
+    return true;
+}
@@ -0,0 +1,241 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <pthread.h>
+#include <squid.h>
+
+#include "private/deque.h"
+
+#include <test/cmocka.h>
+
+static void check_invalidate_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_deque_invalidate(NULL));
+    assert_int_equal(SQUID_DEQUE_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_invalidate(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_deque object = {};
+    assert_true(squid_deque_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_deque_init(NULL, 1));
+    assert_int_equal(SQUID_DEQUE_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init_error_on_capacity_is_invalid(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_deque object;
+    assert_false(squid_deque_init(&object, 0));
+    assert_int_equal(SQUID_DEQUE_ERROR_CAPACITY_IS_INVALID, squid_error);
+    assert_false(squid_deque_init(&object, UINTMAX_MAX));
+    assert_int_equal(SQUID_DEQUE_ERROR_CAPACITY_IS_INVALID, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init_error_on_memory_allocation_failed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_deque object;
+    calloc_is_overridden = true;
+    assert_false(squid_deque_init(&object, 8));
+    calloc_is_overridden = false;
+    assert_int_equal(SQUID_DEQUE_ERROR_MEMORY_ALLOCATION_FAILED, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_deque object;
+    assert_true(squid_deque_init(&object, 5));
+    assert_int_equal(object.mask, 7);
+    assert_true(squid_deque_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_push_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_deque_push(NULL, (void *) 1));
+    assert_int_equal(SQUID_DEQUE_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_push_error_on_deque_is_full(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_deque object;
+    assert_true(squid_deque_init(&object, 2));
+    assert_true(squid_deque_push(&object, (void *) 1));
+    assert_true(squid_deque_push(&object, (void *) 2));
+    assert_false(squid_deque_push(&object, (void *) 3));
+    assert_int_equal(SQUID_DEQUE_ERROR_DEQUE_IS_FULL, squid_error);
+    assert_true(squid_deque_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_pop_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_deque_pop(NULL, (void *) 1));
+    assert_int_equal(SQUID_DEQUE_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_pop_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_deque_pop((void *) 1, NULL));
+    assert_int_equal(SQUID_DEQUE_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_pop_error_on_deque_is_empty(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_deque object;
+    assert_true(squid_deque_init(&object, 2));
+    void *out;
+    assert_false(squid_deque_pop(&object, &out));
+    assert_int_equal(SQUID_DEQUE_ERROR_DEQUE_IS_EMPTY, squid_error);
+    assert_true(squid_deque_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_pop(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_deque object;
+    assert_true(squid_deque_init(&object, 4));
+    assert_true(squid_deque_push(&object, (void *) 1));
+    assert_true(squid_deque_push(&object, (void *) 2));
+    uintmax_t count;
+    assert_true(squid_deque_count(&object, &count));
+    assert_int_equal(count, 2);
+    void *out;
+    assert_true(squid_deque_pop(&object, &out));
+    assert_ptr_equal(out, (void *) 2);
+    assert_true(squid_deque_pop(&object, &out));
+    assert_ptr_equal(out, (void *) 1);
+    assert_true(squid_deque_count(&object, &count));
+    assert_int_equal(count, 0);
+    assert_true(squid_deque_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_steal_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_deque_steal(NULL, (void *) 1));
+    assert_int_equal(SQUID_DEQUE_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_steal_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_deque_steal((void *) 1, NULL));
+    assert_int_equal(SQUID_DEQUE_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_steal_error_on_deque_is_empty(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_deque object;
+    assert_true(squid_deque_init(&object, 2));
+    void *out;
+    assert_false(squid_deque_steal(&object, &out));
+    assert_int_equal(SQUID_DEQUE_ERROR_DEQUE_IS_EMPTY, squid_error);
+    assert_true(squid_deque_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_steal(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_deque object;
+    assert_true(squid_deque_init(&object, 4));
+    assert_true(squid_deque_push(&object, (void *) 1));
+    assert_true(squid_deque_push(&object, (void *) 2));
+    void *out;
+    assert_true(squid_deque_steal(&object, &out));
+    assert_ptr_equal(out, (void *) 1);
+    assert_true(squid_deque_steal(&object, &out));
+    assert_ptr_equal(out, (void *) 2);
+    assert_true(squid_deque_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+#define ITEMS   100000
+#define THIEVES 4
+
+static atomic_uintmax_t seen[1 + ITEMS];
+
+static void *thief(void *object) {
+    struct squid_deque *const deque = object;
+    uintmax_t missed = 0;
+    while (missed < 1000000) {
+        void *out;
+        if (squid_deque_steal(deque, &out)) {
+            atomic_fetch_add(&seen[(uintptr_t) out], 1);
+            missed = 0;
+        } else {
+            missed++;
+        }
+    }
+    return NULL;
+}
+
+static void check_steal_while_owner_pops(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_deque object;
+    assert_true(squid_deque_init(&object, 64));
+    pthread_t threads[THIEVES];
+    for (uintmax_t i = 0; i < THIEVES; i++) {
+        assert_int_equal(0, pthread_create(&threads[i], NULL, thief,
+                                           &object));
+    }
+    void *out;
+    for (uintptr_t i = 1; i <= ITEMS; i++) {
+        while (!squid_deque_push(&object, (void *) i)) {
+            if (squid_deque_pop(&object, &out)) {
+                atomic_fetch_add(&seen[(uintptr_t) out], 1);
+            }
+        }
+        if (!(i % 3) && squid_deque_pop(&object, &out)) {
+            atomic_fetch_add(&seen[(uintptr_t) out], 1);
+        }
+    }
+    while (squid_deque_pop(&object, &out)) {
+        atomic_fetch_add(&seen[(uintptr_t) out], 1);
+    }
+    for (uintmax_t i = 0; i < THIEVES; i++) {
+        assert_int_equal(0, pthread_join(threads[i], NULL));
+    }
+    for (uintmax_t i = 1; i <= ITEMS; i++) {
+        assert_int_equal(atomic_load(&seen[i]), 1);
+    }
+    assert_true(squid_deque_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+int main(int argc, char *argv[]) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(check_invalidate_error_on_object_is_null),
+            cmocka_unit_test(check_invalidate),
+            cmocka_unit_test(check_init_error_on_object_is_null),
+            cmocka_unit_test(check_init_error_on_capacity_is_invalid),
+            cmocka_unit_test(check_init_error_on_memory_allocation_failed),
+            cmocka_unit_test(check_init),
+            cmocka_unit_test(check_push_error_on_object_is_null),
+            cmocka_unit_test(check_push_error_on_deque_is_full),
+            cmocka_unit_test(check_pop_error_on_object_is_null),
+            cmocka_unit_test(check_pop_error_on_out_is_null),
+            cmocka_unit_test(check_pop_error_on_deque_is_empty),
+            cmocka_unit_test(check_pop),
+            cmocka_unit_test(check_steal_error_on_object_is_null),
+            cmocka_unit_test(check_steal_error_on_out_is_null),
+            cmocka_unit_test(check_steal_error_on_deque_is_empty),
+            cmocka_unit_test(check_steal),
+            cmocka_unit_test(check_steal_while_owner_pops),
+    };
+    //cmocka_set_message_output(CM_OUTPUT_XML);
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -3,9 +3,15 @@
 #include <setjmp.h>
 #include <cmocka.h>
 #include <errno.h>
+#include <limits.h>
+#include <string.h>
 #include <triggerfish.h>
 #include <time.h>
+#if defined(__linux__)
 #include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/prctl.h>
+#endif
 #include <squid.h>
 
 #include "private/executer.h"
@@ -73,12 +79,15 @@ static void check_init(void **state) {
 static void check_init_error_on_memory_allocation_failed(void **state) {
     squid_error = SQUID_ERROR_NONE;
     struct squid_executor object;
-    pthread_mutex_init_is_overridden = true;
-    will_return(cmocka_test_pthread_mutex_init, ENOMEM);
-    assert_false(squid_executor_init(&object));
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 4;
+    options.work_stealing.is_enabled = true;
+    calloc_is_overridden = true;
+    assert_false(squid_executor_init_with_options(&object, &options));
+    calloc_is_overridden = false;
     assert_int_equal(SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED,
                      squid_error);
-    pthread_mutex_init_is_overridden = false;
     squid_error = SQUID_ERROR_NONE;
 }
 
@@ -110,6 +119,122 @@ static void check_of_error_on_memory_allocation_failed(void **state) {
     squid_error = SQUID_ERROR_NONE;
 }
 
+static void check_options_init_error_on_options_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_options_init(NULL));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OPTIONS_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_options_init(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    assert_int_equal(options.threads.minimum, 0);
+    assert_int_equal(options.threads.maximum, UINTMAX_MAX);
+    assert_int_equal(options.threads.prestart, 0);
+    assert_int_equal(options.priority.aging, 32);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_of_with_options_error_on_options_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_of_with_options(NULL, (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OPTIONS_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_of_with_options_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_of_with_options((void *) 1, NULL));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_of_with_options_error_on_options_is_invalid(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 0;
+    struct triggerfish_strong *out;
+    assert_false(squid_executor_of_with_options(&options, &out));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID, squid_error);
+    options.threads.maximum = 2;
+    options.threads.minimum = 3;
+    assert_false(squid_executor_of_with_options(&options, &out));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID, squid_error);
+    options.threads.minimum = 0;
+    options.threads.prestart = 3;
+    assert_false(squid_executor_of_with_options(&options, &out));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_of_with_options_error_on_queue_is_invalid(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.queue.capacity = UINTMAX_MAX;
+    struct triggerfish_strong *out;
+    assert_false(squid_executor_of_with_options(&options, &out));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID, squid_error);
+    options.queue.capacity = 8;
+    options.queue.rejection = SQUID_EXECUTOR_REJECTION_DISCARD_OLDEST + 1;
+    assert_false(squid_executor_of_with_options(&options, &out));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID, squid_error);
+    options.queue.rejection = SQUID_EXECUTOR_REJECTION_BLOCK;
+    options.queue.timeout = UINTMAX_MAX;
+    assert_false(squid_executor_of_with_options(&options, &out));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID, squid_error);
+    options.queue.timeout = 0;
+    options.queue.backend = SQUID_EXECUTOR_BACKEND_DEADLINE + 1;
+    assert_false(squid_executor_of_with_options(&options, &out));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID, squid_error);
+    options.queue.capacity = 0;
+    options.queue.backend = SQUID_EXECUTOR_BACKEND_RING;
+    assert_false(squid_executor_of_with_options(&options, &out));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID, squid_error);
+    options.queue.backend = SQUID_EXECUTOR_BACKEND_DEADLINE;
+    options.threads.maximum = 4;
+    options.work_stealing.is_enabled = true;
+    assert_false(squid_executor_of_with_options(&options, &out));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_of_with_options(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.minimum = 1;
+    options.threads.maximum = 4;
+    options.threads.prestart = 2;
+    struct triggerfish_strong *out;
+    assert_true(squid_executor_of_with_options(&options, &out));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(out, (void **) &executor));
+    uintmax_t count;
+    assert_true(squid_executor_count(executor, &count));
+    assert_int_equal(count, 2);
+    assert_true(triggerfish_strong_release(out));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_of_with_options_error_on_thread_creation_failed(
+        void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.prestart = 1;
+    struct triggerfish_strong *out;
+    pthread_create_is_overridden = true;
+    will_return(cmocka_test_pthread_create, EAGAIN);
+    assert_false(squid_executor_of_with_options(&options, &out));
+    pthread_create_is_overridden = false;
+    assert_int_equal(SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
 static void check_count_error_on_object_is_null(void **state) {
     squid_error = SQUID_ERROR_NONE;
     assert_false(squid_executor_count(NULL, (void *) 1));
@@ -252,6 +377,341 @@ static void check_submit_error_on_thread_creation_failed(void **state) {
     squid_error = SQUID_ERROR_NONE;
 }
 
+static void sleepy(void *const args,
+                   bool (*const is_cancelled)(void),
+                   struct triggerfish_strong **const out,
+                   uintmax_t *const error) {
+    const struct timespec delay = {
+            .tv_nsec = 1000000 /* 1 millisecond */
+    };
+    nanosleep(&delay, NULL);
+    atomic_fetch_add((atomic_uintmax_t *) args, 1);
+}
+
+static void check_submit_with_maximum_threads(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 2;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    atomic_uintmax_t done = 0;
+    struct triggerfish_strong *out[32];
+    for (uintmax_t i = 0; i < sizeof(out) / sizeof(out[0]); i++) {
+        assert_true(squid_executor_submit(executor, sleepy, &done, &out[i]));
+        uintmax_t count;
+        assert_true(squid_executor_count(executor, &count));
+        assert_in_range(count, 0, 2);
+    }
+    for (uintmax_t i = 0; i < sizeof(out) / sizeof(out[0]); i++) {
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out[i], (void **) &future));
+        struct triggerfish_strong *result;
+        assert_true(squid_future_get(future, &result, NULL));
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    assert_int_equal(atomic_load(&done), sizeof(out) / sizeof(out[0]));
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_of_with_options_error_on_work_stealing_is_invalid(
+        void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.work_stealing.is_enabled = true;
+    struct triggerfish_strong *out;
+    assert_false(squid_executor_of_with_options(&options, &out));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID, squid_error);
+    options.threads.maximum = 4;
+    options.work_stealing.capacity = 0;
+    assert_false(squid_executor_of_with_options(&options, &out));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+#define FAN_OUT_DEPTH   10
+#define FAN_OUT_NODES   ((2 << FAN_OUT_DEPTH) - 1)
+
+struct fan_out {
+    struct squid_executor *executor;
+    atomic_uintmax_t leaves;
+    struct fan_out_node {
+        struct fan_out *tree;
+        uintmax_t index;
+    } nodes[FAN_OUT_NODES];
+};
+
+static void fan_out(void *const args,
+                    bool (*const is_cancelled)(void),
+                    struct triggerfish_strong **const out,
+                    uintmax_t *const error) {
+    struct fan_out_node *const node = args;
+    struct fan_out *const tree = node->tree;
+    const uintmax_t left = 1 + 2 * node->index;
+    if (left >= FAN_OUT_NODES) {
+        atomic_fetch_add(&tree->leaves, 1);
+        return;
+    }
+    for (uintmax_t i = left; i <= 1 + left; i++) {
+        struct triggerfish_strong *future;
+        assert_true(squid_executor_submit(tree->executor, fan_out,
+                                          &tree->nodes[i], &future));
+        assert_true(triggerfish_strong_release(future));
+    }
+}
+
+static void check_submit_with_work_stealing(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 4;
+    options.work_stealing.is_enabled = true;
+    options.work_stealing.capacity = 16;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    static struct fan_out tree;
+    assert_true(triggerfish_strong_instance(instance,
+                                            (void **) &tree.executor));
+    for (uintmax_t i = 0; i < FAN_OUT_NODES; i++) {
+        tree.nodes[i].tree = &tree;
+        tree.nodes[i].index = i;
+    }
+    struct triggerfish_strong *out;
+    assert_true(squid_executor_submit(tree.executor, fan_out, &tree.nodes[0],
+                                      &out));
+    struct squid_future *future;
+    assert_true(triggerfish_strong_instance(out, (void **) &future));
+    struct triggerfish_strong *result;
+    assert_true(squid_future_get(future, &result, NULL));
+    assert_true(triggerfish_strong_release(out));
+    const struct timespec delay = {
+            .tv_nsec = 1000000 /* 1 millisecond */
+    };
+    while (atomic_load(&tree.leaves) < (1 << FAN_OUT_DEPTH)) {
+        nanosleep(&delay, NULL);
+    }
+    assert_int_equal(atomic_load(&tree.leaves), 1 << FAN_OUT_DEPTH);
+    uintmax_t count;
+    assert_true(squid_executor_count(tree.executor, &count));
+    assert_in_range(count, 1, 4);
+    assert_true(squid_executor_shutdown(tree.executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_of_with_options_error_on_affinity_is_invalid(
+        void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.affinity.is_queue_per_node = true;
+    struct triggerfish_strong *out;
+    assert_false(squid_executor_of_with_options(&options, &out));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID, squid_error);
+    options.affinity.is_queue_per_node = false;
+    /* a CPU that no node has, unless the topology could not be read */
+    options.affinity.cpus[SQUID_EXECUTOR_CPUS / 64 - 1] = UINT64_C(1) << 63;
+    uint64_t cpus[SQUID_NUMA_WORDS];
+    assert_true(squid_numa_cpus(0, cpus));
+    if (!(cpus[SQUID_NUMA_WORDS - 1] & UINT64_C(1) << 63)) {
+        assert_false(squid_executor_of_with_options(&options, &out));
+        assert_int_equal(SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID,
+                         squid_error);
+    }
+    squid_error = SQUID_ERROR_NONE;
+}
+
+#if defined(__linux__)
+
+/* the first CPU the test process may run on */
+static unsigned first(void) {
+    const size_t bits = CHAR_BIT * sizeof(unsigned long);
+    unsigned long mask[SQUID_EXECUTOR_CPUS
+                       / (CHAR_BIT * sizeof(unsigned long))] = {0};
+    assert_true(syscall(SYS_sched_getaffinity, 0, sizeof(mask), mask) > 0);
+    unsigned i = 0;
+    while (i < SQUID_EXECUTOR_CPUS && !(mask[i / bits] & 1UL << (i % bits))) {
+        i++;
+    }
+    assert_true(i < SQUID_EXECUTOR_CPUS);
+    return i;
+}
+
+static void where(void *const args,
+                  bool (*const is_cancelled)(void),
+                  struct triggerfish_strong **const out,
+                  uintmax_t *const error) {
+    unsigned cpu;
+    assert_int_equal(syscall(SYS_getcpu, &cpu, NULL, NULL), 0);
+    *(unsigned *) args = cpu;
+}
+
+static void check_submit_with_affinity(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 2;
+    const unsigned expected = first();
+    options.affinity.cpus[expected / 64] = UINT64_C(1) << (expected % 64);
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    for (uintmax_t i = 0; i < 8; i++) {
+        unsigned cpu = UINT_MAX;
+        struct triggerfish_strong *out;
+        assert_true(squid_executor_submit(executor, where, &cpu, &out));
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out, (void **) &future));
+        struct triggerfish_strong *result;
+        assert_true(squid_future_get(future, &result, NULL));
+        assert_int_equal(cpu, expected);
+        assert_true(triggerfish_strong_release(out));
+    }
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+#endif
+
+static void check_submit_with_queue_per_node(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 4;
+    options.work_stealing.is_enabled = true;
+    options.work_stealing.capacity = 16;
+    options.affinity.is_numa_aware = true;
+    options.affinity.is_queue_per_node = true;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    static struct fan_out tree;
+    tree = (struct fan_out) {0};
+    assert_true(triggerfish_strong_instance(instance,
+                                            (void **) &tree.executor));
+    uintmax_t nodes;
+    assert_true(squid_numa_count(&nodes));
+    assert_int_equal(tree.executor->placement.count, nodes);
+    for (uintmax_t i = 0; i < FAN_OUT_NODES; i++) {
+        tree.nodes[i].tree = &tree;
+        tree.nodes[i].index = i;
+    }
+    struct triggerfish_strong *out;
+    assert_true(squid_executor_submit(tree.executor, fan_out, &tree.nodes[0],
+                                      &out));
+    struct squid_future *future;
+    assert_true(triggerfish_strong_instance(out, (void **) &future));
+    struct triggerfish_strong *result;
+    assert_true(squid_future_get(future, &result, NULL));
+    assert_true(triggerfish_strong_release(out));
+    const struct timespec delay = {
+            .tv_nsec = 1000000 /* 1 millisecond */
+    };
+    while (atomic_load(&tree.leaves) < (1 << FAN_OUT_DEPTH)) {
+        nanosleep(&delay, NULL);
+    }
+    assert_int_equal(atomic_load(&tree.leaves), 1 << FAN_OUT_DEPTH);
+    uintmax_t pending;
+    assert_true(squid_executor_pending(tree.executor,
+                                       SQUID_EXECUTOR_PRIORITY_NORMAL,
+                                       &pending));
+    assert_int_equal(pending, 0);
+    uintmax_t threads = 0;
+    for (uintmax_t i = 0; i < nodes; i++) {
+        threads += atomic_load(&tree.executor->placement.nodes[i].threads);
+    }
+    assert_in_range(threads, 1, 4);
+    assert_true(squid_executor_shutdown(tree.executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_of_with_options_error_on_stack_size_is_invalid(
+        void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.stack_size = 1;
+    struct triggerfish_strong *out;
+    assert_false(squid_executor_of_with_options(&options, &out));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OPTIONS_IS_INVALID, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+#if defined(__linux__)
+
+struct hooks {
+    atomic_uintmax_t starts;
+    atomic_uintmax_t exits;
+};
+
+static void started(void *const context) {
+    atomic_fetch_add(&((struct hooks *) context)->starts, 1);
+}
+
+static void exited(void *const context) {
+    struct hooks *const hooks = context;
+    assert_true(atomic_load(&hooks->exits) < atomic_load(&hooks->starts));
+    /* a slow hook must still be done by the time shutdown returns */
+    const struct timespec delay = {
+            .tv_nsec = 20000000 /* 20 milliseconds */
+    };
+    nanosleep(&delay, NULL);
+    atomic_fetch_add(&hooks->exits, 1);
+}
+
+static void named(void *const args,
+                  bool (*const is_cancelled)(void),
+                  struct triggerfish_strong **const out,
+                  uintmax_t *const error) {
+    assert_int_equal(prctl(PR_GET_NAME, (char *) args, 0, 0, 0), 0);
+}
+
+static void check_submit_with_thread_attributes(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    static struct hooks hooks;
+    hooks = (struct hooks) {0};
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 2;
+    options.threads.prestart = 2;
+    options.threads.stack_size = 256 * 1024 + 1;
+    char prefix[] = "squid-w";
+    options.threads.name = prefix;
+    options.threads.on_start = started;
+    options.threads.on_exit = exited;
+    options.threads.context = &hooks;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    /* the prefix is copied */
+    prefix[0] = '\0';
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    for (uintmax_t i = 0; i < 8; i++) {
+        char name[16] = {0};
+        struct triggerfish_strong *out;
+        assert_true(squid_executor_submit(executor, named, name, &out));
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out, (void **) &future));
+        struct triggerfish_strong *result;
+        assert_true(squid_future_get(future, &result, NULL));
+        assert_true(!strcmp(name, "squid-w0") || !strcmp(name, "squid-w1"));
+        assert_true(triggerfish_strong_release(out));
+    }
+    assert_true(squid_executor_shutdown(executor));
+    assert_int_equal(atomic_load(&hooks.starts), 2);
+    assert_int_equal(atomic_load(&hooks.exits), 2);
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+#endif
+
 static void check_reference_error_on_out_is_null(void **state) {
     squid_error = SQUID_ERROR_NONE;
     assert_false(squid_executor_reference(NULL));
@@ -280,6 +740,1530 @@ static void check_reference_error_on_memory_allocation_failed(void **state) {
     squid_error = SQUID_ERROR_NONE;
 }
 
+static void check_pool_hits_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_pool_hits(NULL, (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_pool_hits_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_pool_hits((void *) 1, NULL));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_pool_misses_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_pool_misses(NULL, (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_pool_misses_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_pool_misses((void *) 1, NULL));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_pool_hits_and_misses(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    for (uintmax_t i = 0; i < 10; i++) {
+        struct triggerfish_strong *out;
+        assert_true(squid_executor_submit(executor, function,
+                                          &random_value, &out));
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out, (void **) &future));
+        struct triggerfish_strong *result;
+        uintmax_t error;
+        assert_true(squid_future_get(future, &result, &error));
+        assert_true(triggerfish_strong_release(out));
+    }
+    uintmax_t hits;
+    uintmax_t misses;
+    assert_true(squid_executor_pool_hits(executor, &hits));
+    assert_true(squid_executor_pool_misses(executor, &misses));
+    /* the queue sentinel of each priority lane accounts for an extra miss */
+    assert_int_equal(hits + misses, 13);
+    assert_true(hits > 0);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_stats_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_stats(NULL, (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_stats_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_stats((void *) 1, NULL));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void linger(void *const args,
+                   bool (*const is_cancelled)(void),
+                   struct triggerfish_strong **const out,
+                   uintmax_t *const error) {
+    const struct timespec delay = {
+            .tv_nsec = 2000000 /* 2 milliseconds */
+    };
+    nanosleep(&delay, NULL);
+}
+
+static uintmax_t sum(const uintmax_t *const buckets,
+                     const uintmax_t from) {
+    uintmax_t count = 0;
+    for (uintmax_t i = from; i < SQUID_EXECUTOR_STATS_BUCKETS; i++) {
+        count += buckets[i];
+    }
+    return count;
+}
+
+static void check_stats(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    struct squid_executor_stats stats;
+    assert_true(squid_executor_stats(executor, &stats));
+    assert_int_equal(stats.submitted, 0);
+    assert_int_equal(stats.threads.created, 0);
+    for (uintmax_t i = 0; i < 10; i++) {
+        struct triggerfish_strong *out;
+        assert_true(squid_executor_submit(executor, i ? function : linger,
+                                          &random_value, &out));
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out, (void **) &future));
+        struct triggerfish_strong *result;
+        assert_true(squid_future_get(future, &result, NULL));
+        assert_true(triggerfish_strong_release(out));
+    }
+    assert_true(squid_executor_stats(executor, &stats));
+    assert_int_equal(stats.submitted, 10);
+    assert_int_equal(stats.completed, 10);
+    assert_int_equal(stats.cancelled, 0);
+    assert_int_equal(stats.pending, 0);
+    assert_true(stats.threads.created > 0);
+    assert_int_equal(sum(stats.histogram.wait, 0), 10);
+    assert_int_equal(sum(stats.histogram.run, 0), 10);
+    /* 2 ms are in the bucket of 2^20 ns or a later one */
+    assert_true(sum(stats.histogram.run, 20) > 0);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(squid_executor_stats(executor, &stats));
+    assert_int_equal(stats.threads.retired, stats.threads.created);
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_execute_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_execute(NULL, (void *) 1, (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_execute_error_on_function_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_execute((void *) 1, NULL, (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_execute_error_on_is_busy_shutting_down(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor object = {
+            .is_running = false
+    };
+    assert_false(squid_executor_execute(&object, (void *) 1, (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_execute_error_on_thread_creation_failed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    pthread_create_is_overridden = true;
+    will_return(cmocka_test_pthread_create, EAGAIN);
+    assert_false(squid_executor_execute(executor, sleepy, NULL));
+    pthread_create_is_overridden = false;
+    assert_int_equal(SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED, squid_error);
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void await_count(atomic_uintmax_t *const count, const uintmax_t value) {
+    const struct timespec delay = {
+            .tv_nsec = 1000000 /* 1 millisecond */
+    };
+    while (atomic_load(count) < value) {
+        nanosleep(&delay, NULL);
+    }
+}
+
+static void check_execute(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    atomic_uintmax_t count = 0;
+    for (uintmax_t i = 0; i < 100; i++) {
+        assert_true(squid_executor_execute(executor, sleepy, &count));
+    }
+    await_count(&count, 100);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static struct squid_executor *spreading;
+
+static void spread(void *const args,
+                   bool (*const is_cancelled)(void),
+                   struct triggerfish_strong **const out,
+                   uintmax_t *const error) {
+    atomic_uintmax_t *const count = args;
+    if (atomic_fetch_add(count, 1) < 1000) {
+        assert_true(squid_executor_execute(spreading, spread, count));
+    }
+}
+
+static void check_execute_with_work_stealing(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 4;
+    options.work_stealing.is_enabled = true;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    assert_true(triggerfish_strong_instance(instance, (void **) &spreading));
+    atomic_uintmax_t count = 0;
+    assert_true(squid_executor_execute(spreading, spread, &count));
+    await_count(&count, 1001);
+    uintmax_t hits;
+    assert_true(squid_executor_pool_hits(spreading, &hits));
+    assert_true(hits > 0);
+    assert_true(squid_executor_shutdown(spreading));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_all_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_submit_all(NULL, (void *) 1, 1, (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_all_error_on_tasks_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_submit_all((void *) 1, NULL, 1, (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_TASKS_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_all_error_on_count_is_zero(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_submit_all((void *) 1, (void *) 1, 0,
+                                           (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_COUNT_IS_ZERO, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_all_error_on_function_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    const struct squid_executor_task tasks[] = {
+            {.function = sleepy},
+            {.function = NULL}
+    };
+    assert_false(squid_executor_submit_all((void *) 1, tasks, 2, (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_all_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    const struct squid_executor_task tasks[] = {
+            {.function = sleepy}
+    };
+    assert_false(squid_executor_submit_all((void *) 1, tasks, 1, NULL));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_all_error_on_is_busy_shutting_down(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor object = {
+            .is_running = false
+    };
+    const struct squid_executor_task tasks[] = {
+            {.function = sleepy}
+    };
+    assert_false(squid_executor_submit_all(&object, tasks, 1, (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_all_error_on_thread_creation_failed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    const struct squid_executor_task tasks[] = {
+            {.function = sleepy}
+    };
+    struct triggerfish_strong *out[1];
+    pthread_create_is_overridden = true;
+    will_return(cmocka_test_pthread_create, EAGAIN);
+    assert_false(squid_executor_submit_all(executor, tasks, 1, out));
+    pthread_create_is_overridden = false;
+    assert_int_equal(SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED, squid_error);
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+#define BATCH                                               100
+
+static void check_submit_all(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 4;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    atomic_uintmax_t count = 0;
+    struct squid_executor_task tasks[BATCH];
+    for (uintmax_t i = 0; i < BATCH; i++) {
+        tasks[i] = (struct squid_executor_task) {
+                .function = sleepy,
+                .args = &count
+        };
+    }
+    struct triggerfish_strong *out[BATCH];
+    assert_true(squid_executor_submit_all(executor, tasks, BATCH, out));
+    uintmax_t threads;
+    assert_true(squid_executor_count(executor, &threads));
+    assert_true(threads <= 4);
+    for (uintmax_t i = 0; i < BATCH; i++) {
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out[i], (void **) &future));
+        struct triggerfish_strong *result;
+        assert_true(squid_future_get(future, &result, NULL));
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    assert_int_equal(atomic_load(&count), BATCH);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_execute_all_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_execute_all(NULL, (void *) 1, 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_execute_all_error_on_tasks_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_execute_all((void *) 1, NULL, 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_TASKS_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_execute_all_error_on_count_is_zero(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_execute_all((void *) 1, (void *) 1, 0));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_COUNT_IS_ZERO, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_execute_all_error_on_function_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    const struct squid_executor_task tasks[] = {
+            {.function = NULL}
+    };
+    assert_false(squid_executor_execute_all((void *) 1, tasks, 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_execute_all_error_on_is_busy_shutting_down(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor object = {
+            .is_running = false
+    };
+    const struct squid_executor_task tasks[] = {
+            {.function = sleepy}
+    };
+    assert_false(squid_executor_execute_all(&object, tasks, 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_execute_all_error_on_memory_allocation_failed(
+        void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    const struct squid_executor_task tasks[] = {
+            {.function = sleepy}
+    };
+    malloc_is_overridden = true;
+    assert_false(squid_executor_execute_all(executor, tasks, 1));
+    malloc_is_overridden = false;
+    assert_int_equal(SQUID_EXECUTOR_ERROR_MEMORY_ALLOCATION_FAILED,
+                     squid_error);
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_execute_all(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    atomic_uintmax_t count = 0;
+    struct squid_executor_task tasks[BATCH];
+    for (uintmax_t i = 0; i < BATCH; i++) {
+        tasks[i] = (struct squid_executor_task) {
+                .function = sleepy,
+                .args = &count
+        };
+    }
+    assert_true(squid_executor_execute_all(executor, tasks, BATCH));
+    await_count(&count, BATCH);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void scatter(void *const args,
+                    bool (*const is_cancelled)(void),
+                    struct triggerfish_strong **const out,
+                    uintmax_t *const error) {
+    struct squid_executor_task tasks[BATCH];
+    for (uintmax_t i = 0; i < BATCH; i++) {
+        tasks[i] = (struct squid_executor_task) {
+                .function = sleepy,
+                .args = args
+        };
+    }
+    assert_true(squid_executor_execute_all(spreading, tasks, BATCH));
+}
+
+static void check_execute_all_with_work_stealing(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 4;
+    options.work_stealing.is_enabled = true;
+    /* less room on the deque than there are tasks in the batch */
+    options.work_stealing.capacity = 8;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    assert_true(triggerfish_strong_instance(instance, (void **) &spreading));
+    atomic_uintmax_t count = 0;
+    assert_true(squid_executor_execute(spreading, scatter, &count));
+    await_count(&count, BATCH);
+    assert_true(squid_executor_shutdown(spreading));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_await_termination_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_await_termination(NULL, NULL));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void deadline_in(struct timespec *const deadline,
+                        const long milliseconds) {
+    assert_int_equal(0, clock_gettime(CLOCK_MONOTONIC, deadline));
+    deadline->tv_nsec += milliseconds * 1000000;
+    deadline->tv_sec += deadline->tv_nsec / 1000000000;
+    deadline->tv_nsec %= 1000000000;
+}
+
+static void check_await_termination_error_on_deadline_is_invalid(
+        void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    const struct timespec deadlines[] = {
+            {.tv_sec = 1, .tv_nsec = -1},
+            {.tv_sec = 1, .tv_nsec = 1000000000},
+            {.tv_sec = -1, .tv_nsec = 0}
+    };
+    for (uintmax_t i = 0; i < sizeof(deadlines) / sizeof(*deadlines); i++) {
+        assert_false(squid_executor_await_termination((void *) 1,
+                                                      &deadlines[i]));
+        assert_int_equal(SQUID_EXECUTOR_ERROR_DEADLINE_IS_INVALID,
+                         squid_error);
+    }
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_await_termination_error_on_timed_out(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.minimum = 1;
+    options.threads.prestart = 1;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    struct timespec deadline;
+    deadline_in(&deadline, 10);
+    assert_false(squid_executor_await_termination(executor, &deadline));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_TIMED_OUT, squid_error);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_await_termination(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.prestart = 4;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    struct timespec start;
+    assert_int_equal(0, clock_gettime(CLOCK_MONOTONIC, &start));
+    assert_true(squid_executor_shutdown(executor));
+    struct timespec deadline;
+    deadline_in(&deadline, 0);
+    assert_true(squid_executor_await_termination(executor, &deadline));
+    uintmax_t count;
+    assert_true(squid_executor_count(executor, &count));
+    assert_int_equal(count, 0);
+    assert_int_equal(atomic_load(&executor->threads.live), 0);
+    /* shutdown no longer polls so it is well below its old 100ms period */
+    const long elapsed = (deadline.tv_sec - start.tv_sec) * 1000000000
+                         + deadline.tv_nsec - start.tv_nsec;
+    assert_true(elapsed < 50000000);
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_shutdown_now_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_shutdown_now(NULL, (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_shutdown_now_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_shutdown_now((void *) 1, NULL));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_shutdown_now_error_on_is_busy_shutting_down(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor object = {};
+    uintmax_t out;
+    assert_false(squid_executor_shutdown_now(&object, &out));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN,
+                     squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void hold(void *const args,
+                 bool (*const is_cancelled)(void),
+                 struct triggerfish_strong **const out,
+                 uintmax_t *const error) {
+    atomic_fetch_add((atomic_uintmax_t *) args, 1);
+    const struct timespec delay = {
+            .tv_nsec = 1000000 /* 1 millisecond */
+    };
+    while (!is_cancelled()) {
+        nanosleep(&delay, NULL);
+    }
+    atomic_fetch_add((atomic_uintmax_t *) args, 1);
+}
+
+static void check_shutdown_now(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 1;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    atomic_uintmax_t held = 0;
+    assert_true(squid_executor_execute(executor, hold, &held));
+    await_count(&held, 1);
+    /* the only thread is busy so everything from here on stays queued */
+    atomic_uintmax_t count = 0;
+    struct triggerfish_strong *futures[3];
+    for (uintmax_t i = 0; i < 3; i++) {
+        assert_true(squid_executor_submit(executor, sleepy, &count,
+                                          &futures[i]));
+        assert_true(squid_executor_execute(executor, sleepy, &count));
+    }
+    uintmax_t out;
+    assert_true(squid_executor_shutdown_now(executor, &out));
+    assert_int_equal(out, 6);
+    assert_int_equal(atomic_load(&held), 2);
+    assert_int_equal(atomic_load(&count), 0);
+    assert_true(squid_executor_count(executor, &out));
+    assert_int_equal(out, 0);
+    for (uintmax_t i = 0; i < 3; i++) {
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(futures[i],
+                                                (void **) &future));
+        enum squid_future_status status;
+        assert_true(squid_future_status(future, &status));
+        assert_int_equal(status, SQUID_FUTURE_STATUS_CANCELLED);
+        assert_true(triggerfish_strong_release(futures[i]));
+    }
+    assert_false(squid_executor_shutdown_now(executor, &out));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN,
+                     squid_error);
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static atomic_uintmax_t filled;
+
+static void fill(void *const args,
+                 bool (*const is_cancelled)(void),
+                 struct triggerfish_strong **const out,
+                 uintmax_t *const error) {
+    /* the only worker keeps these in its own deque as there is no thief */
+    for (uintmax_t i = 0; i < 4; i++) {
+        assert_true(squid_executor_execute(spreading, sleepy, &filled));
+    }
+    hold(args, is_cancelled, out, error);
+}
+
+static void check_shutdown_now_with_work_stealing(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 1;
+    options.work_stealing.is_enabled = true;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    assert_true(triggerfish_strong_instance(instance, (void **) &spreading));
+    atomic_uintmax_t held = 0;
+    assert_true(squid_executor_execute(spreading, fill, &held));
+    await_count(&held, 1);
+    uintmax_t out;
+    assert_true(squid_executor_shutdown_now(spreading, &out));
+    assert_int_equal(out, 4);
+    assert_int_equal(atomic_load(&filled), 0);
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static struct squid_executor *bounded_of_backend(
+        const enum squid_executor_backend backend,
+        const uintmax_t capacity,
+        const enum squid_executor_rejection rejection,
+        const uintmax_t timeout,
+        struct triggerfish_strong **const out) {
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 1;
+    options.queue.capacity = capacity;
+    options.queue.rejection = rejection;
+    options.queue.timeout = timeout;
+    options.queue.backend = backend;
+    assert_true(squid_executor_of_with_options(&options, out));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(*out, (void **) &executor));
+    return executor;
+}
+
+static struct squid_executor *bounded_of(
+        const enum squid_executor_rejection rejection,
+        const uintmax_t timeout,
+        struct triggerfish_strong **const out) {
+    return bounded_of_backend(SQUID_EXECUTOR_BACKEND_DEFAULT, 2, rejection,
+                              timeout, out);
+}
+
+/* keeps the only thread busy and fills the queue up behind it */
+static void fill_up(struct squid_executor *const executor,
+                    atomic_uintmax_t *const held,
+                    atomic_uintmax_t *const count) {
+    assert_true(squid_executor_execute(executor, hold, held));
+    await_count(held, 1);
+    assert_true(squid_executor_execute(executor, sleepy, count));
+    assert_true(squid_executor_execute(executor, sleepy, count));
+}
+
+static void check_execute_error_on_queue_is_full(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    struct squid_executor *executor = bounded_of(
+            SQUID_EXECUTOR_REJECTION_FAIL, 0, &instance);
+    atomic_uintmax_t held = 0;
+    atomic_uintmax_t count = 0;
+    fill_up(executor, &held, &count);
+    assert_false(squid_executor_execute(executor, sleepy, &count));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL, squid_error);
+    struct triggerfish_strong *out;
+    assert_false(squid_executor_submit(executor, sleepy, &count, &out));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL, squid_error);
+    uintmax_t drained;
+    assert_true(squid_executor_shutdown_now(executor, &drained));
+    assert_int_equal(drained, 2);
+    assert_int_equal(atomic_load(&count), 0);
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_all_error_on_queue_is_full(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    struct squid_executor *executor = bounded_of(
+            SQUID_EXECUTOR_REJECTION_BLOCK, 0, &instance);
+    atomic_uintmax_t count = 0;
+    const struct squid_executor_task tasks[] = {
+            {.function = sleepy, .args = &count},
+            {.function = sleepy, .args = &count},
+            {.function = sleepy, .args = &count}
+    };
+    /* no amount of waiting makes room for more than the capacity */
+    struct triggerfish_strong *out[3];
+    assert_false(squid_executor_submit_all(executor, tasks, 3, out));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL, squid_error);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_execute_error_on_timed_out(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    struct squid_executor *executor = bounded_of(
+            SQUID_EXECUTOR_REJECTION_BLOCK, 10, &instance);
+    atomic_uintmax_t held = 0;
+    atomic_uintmax_t count = 0;
+    fill_up(executor, &held, &count);
+    assert_false(squid_executor_execute(executor, sleepy, &count));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_TIMED_OUT, squid_error);
+    uintmax_t drained;
+    assert_true(squid_executor_shutdown_now(executor, &drained));
+    assert_int_equal(drained, 2);
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+/* a timer must neither wait for room nor run its task on the timer thread */
+static void check_schedule_with_queue_is_full(
+        const enum squid_executor_rejection rejection) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    struct squid_executor *executor = bounded_of(rejection, 0, &instance);
+    atomic_uintmax_t held = 0;
+    atomic_uintmax_t count = 0;
+    fill_up(executor, &held, &count);
+    const uint64_t delays[] = {0, 5};
+    struct triggerfish_strong *out[2];
+    for (uintmax_t i = 0; i < 2; i++) {
+        assert_true(squid_executor_schedule(executor, delays[i], sleepy,
+                                            &count, &out[i]));
+    }
+    for (uintmax_t i = 0; i < 2; i++) {
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out[i], (void **) &future));
+        struct triggerfish_strong *result;
+        assert_false(squid_future_get(future, &result, NULL));
+        assert_int_equal(SQUID_FUTURE_ERROR_FUTURE_IS_CANCELLED, squid_error);
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    assert_int_equal(atomic_load(&count), 0);
+    uintmax_t drained;
+    assert_true(squid_executor_shutdown_now(executor, &drained));
+    assert_int_equal(drained, 2);
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_schedule_with_queue_is_full_and_block(void **state) {
+    check_schedule_with_queue_is_full(SQUID_EXECUTOR_REJECTION_BLOCK);
+}
+
+static void check_schedule_with_queue_is_full_and_caller_runs(
+        void **state) {
+    check_schedule_with_queue_is_full(SQUID_EXECUTOR_REJECTION_CALLER_RUNS);
+}
+
+static void check_execute_with_block(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    struct squid_executor *executor = bounded_of(
+            SQUID_EXECUTOR_REJECTION_BLOCK, 0, &instance);
+    atomic_uintmax_t count = 0;
+    for (uintmax_t i = 0; i < 100; i++) {
+        assert_true(squid_executor_execute(executor, sleepy, &count));
+    }
+    await_count(&count, 100);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_execute_with_linked_backend(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    struct squid_executor *executor = bounded_of_backend(
+            SQUID_EXECUTOR_BACKEND_LINKED, 2, SQUID_EXECUTOR_REJECTION_FAIL,
+            0, &instance);
+    atomic_uintmax_t held = 0;
+    atomic_uintmax_t count = 0;
+    fill_up(executor, &held, &count);
+    assert_false(squid_executor_execute(executor, sleepy, &count));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL, squid_error);
+    uintmax_t drained;
+    assert_true(squid_executor_shutdown_now(executor, &drained));
+    assert_int_equal(drained, 2);
+    assert_true(triggerfish_strong_release(instance));
+    /* the same queue without a bound */
+    executor = bounded_of_backend(SQUID_EXECUTOR_BACKEND_LINKED, 0,
+                                  SQUID_EXECUTOR_REJECTION_FAIL, 0,
+                                  &instance);
+    for (uintmax_t i = 0; i < 100; i++) {
+        assert_true(squid_executor_execute(executor, sleepy, &count));
+    }
+    await_count(&count, 100);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_execute_with_ring_backend(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    /* capacity is rounded up to four slots */
+    struct squid_executor *executor = bounded_of_backend(
+            SQUID_EXECUTOR_BACKEND_RING, 3, SQUID_EXECUTOR_REJECTION_FAIL,
+            0, &instance);
+    atomic_uintmax_t held = 0;
+    atomic_uintmax_t count = 0;
+    fill_up(executor, &held, &count);
+    assert_true(squid_executor_execute(executor, sleepy, &count));
+    assert_true(squid_executor_execute(executor, sleepy, &count));
+    assert_false(squid_executor_execute(executor, sleepy, &count));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_QUEUE_IS_FULL, squid_error);
+    uintmax_t drained;
+    assert_true(squid_executor_shutdown_now(executor, &drained));
+    assert_int_equal(drained, 4);
+    assert_int_equal(atomic_load(&count), 0);
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static struct squid_executor *flooding;
+
+static void flood(void *const args,
+                  bool (*const is_cancelled)(void),
+                  struct triggerfish_strong **const out,
+                  uintmax_t *const error) {
+    for (uintmax_t i = 0; i < 10; i++) {
+        assert_true(squid_executor_execute(flooding, sleepy, args));
+    }
+}
+
+static void check_execute_with_block_from_within(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    flooding = bounded_of(SQUID_EXECUTOR_REJECTION_BLOCK, 0, &instance);
+    atomic_uintmax_t count = 0;
+    /* the only thread would otherwise wait for itself to make room */
+    assert_true(squid_executor_execute(flooding, flood, &count));
+    await_count(&count, 10);
+    assert_true(squid_executor_shutdown(flooding));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_execute_with_caller_runs(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    struct squid_executor *executor = bounded_of(
+            SQUID_EXECUTOR_REJECTION_CALLER_RUNS, 0, &instance);
+    atomic_uintmax_t held = 0;
+    atomic_uintmax_t count = 0;
+    fill_up(executor, &held, &count);
+    atomic_uintmax_t ran = 0;
+    assert_true(squid_executor_execute(executor, sleepy, &ran));
+    assert_int_equal(atomic_load(&ran), 1);
+    struct triggerfish_strong *out;
+    assert_true(squid_executor_submit(executor, sleepy, &ran, &out));
+    assert_int_equal(atomic_load(&ran), 2);
+    struct squid_future *future;
+    assert_true(triggerfish_strong_instance(out, (void **) &future));
+    enum squid_future_status status;
+    assert_true(squid_future_status(future, &status));
+    assert_int_equal(status, SQUID_FUTURE_STATUS_DONE);
+    assert_true(triggerfish_strong_release(out));
+    uintmax_t drained;
+    assert_true(squid_executor_shutdown_now(executor, &drained));
+    assert_int_equal(drained, 2);
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_with_discard_oldest(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    struct squid_executor *executor = bounded_of(
+            SQUID_EXECUTOR_REJECTION_DISCARD_OLDEST, 0, &instance);
+    atomic_uintmax_t held = 0;
+    assert_true(squid_executor_execute(executor, hold, &held));
+    await_count(&held, 1);
+    atomic_uintmax_t count = 0;
+    struct triggerfish_strong *out[3];
+    for (uintmax_t i = 0; i < 3; i++) {
+        assert_true(squid_executor_submit(executor, sleepy, &count, &out[i]));
+    }
+    enum squid_future_status status[3];
+    for (uintmax_t i = 0; i < 3; i++) {
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out[i], (void **) &future));
+        assert_true(squid_future_status(future, &status[i]));
+    }
+    assert_int_equal(status[0], SQUID_FUTURE_STATUS_CANCELLED);
+    assert_int_equal(status[1], SQUID_FUTURE_STATUS_PENDING);
+    assert_int_equal(status[2], SQUID_FUTURE_STATUS_PENDING);
+    uintmax_t drained;
+    assert_true(squid_executor_shutdown_now(executor, &drained));
+    assert_int_equal(drained, 2);
+    for (uintmax_t i = 0; i < 3; i++) {
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_with_priority_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_submit_with_priority(
+            NULL, SQUID_EXECUTOR_PRIORITY_HIGH, (void *) 1, NULL,
+            (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_with_priority_error_on_priority_is_invalid(
+        void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_submit_with_priority(
+            (void *) 1, SQUID_EXECUTOR_PRIORITY_LOW + 1, (void *) 1, NULL,
+            (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_PRIORITY_IS_INVALID, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_pending_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_pending(NULL, SQUID_EXECUTOR_PRIORITY_HIGH,
+                                        (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_pending_error_on_priority_is_invalid(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_pending((void *) 1,
+                                        SQUID_EXECUTOR_PRIORITY_LOW + 1,
+                                        (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_PRIORITY_IS_INVALID, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_pending_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_pending((void *) 1,
+                                        SQUID_EXECUTOR_PRIORITY_HIGH, NULL));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static atomic_bool is_open;
+
+static void gate(void *const args,
+                 bool (*const is_cancelled)(void),
+                 struct triggerfish_strong **const out,
+                 uintmax_t *const error) {
+    atomic_fetch_add((atomic_uintmax_t *) args, 1);
+    const struct timespec delay = {
+            .tv_nsec = 1000000 /* 1 millisecond */
+    };
+    while (!atomic_load(&is_open)) {
+        nanosleep(&delay, NULL);
+    }
+}
+
+static atomic_uintmax_t position;
+
+static void place(void *const args,
+                  bool (*const is_cancelled)(void),
+                  struct triggerfish_strong **const out,
+                  uintmax_t *const error) {
+    *(uintmax_t *) args = atomic_fetch_add(&position, 1);
+}
+
+/* single thread executor held up by a gate until the tasks are queued */
+static struct squid_executor *gated_of_options(
+        struct squid_executor_options *const options,
+        struct triggerfish_strong **const out) {
+    options->threads.maximum = 1;
+    assert_true(squid_executor_of_with_options(options, out));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(*out, (void **) &executor));
+    atomic_store(&is_open, false);
+    atomic_store(&position, 0);
+    atomic_uintmax_t held = 0;
+    assert_true(squid_executor_execute(executor, gate, &held));
+    await_count(&held, 1);
+    return executor;
+}
+
+static struct squid_executor *gated_of(const uintmax_t aging,
+                                       struct triggerfish_strong **const out) {
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.priority.aging = aging;
+    return gated_of_options(&options, out);
+}
+
+static void check_submit_with_priority(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    struct squid_executor *executor = gated_of(0, &instance);
+    const enum squid_executor_priority priorities[] = {
+            SQUID_EXECUTOR_PRIORITY_LOW,
+            SQUID_EXECUTOR_PRIORITY_NORMAL,
+            SQUID_EXECUTOR_PRIORITY_HIGH,
+            SQUID_EXECUTOR_PRIORITY_NORMAL
+    };
+    uintmax_t places[4];
+    struct triggerfish_strong *out[4];
+    for (uintmax_t i = 0; i < 4; i++) {
+        assert_true(squid_executor_submit_with_priority(
+                executor, priorities[i], place, &places[i], &out[i]));
+    }
+    uintmax_t pending;
+    assert_true(squid_executor_pending(executor, SQUID_EXECUTOR_PRIORITY_HIGH,
+                                       &pending));
+    assert_int_equal(pending, 1);
+    assert_true(squid_executor_pending(
+            executor, SQUID_EXECUTOR_PRIORITY_NORMAL, &pending));
+    assert_int_equal(pending, 2);
+    assert_true(squid_executor_pending(executor, SQUID_EXECUTOR_PRIORITY_LOW,
+                                       &pending));
+    assert_int_equal(pending, 1);
+    atomic_store(&is_open, true);
+    for (uintmax_t i = 0; i < 4; i++) {
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out[i], (void **) &future));
+        struct triggerfish_strong *result;
+        assert_true(squid_future_get(future, &result, NULL));
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    assert_int_equal(places[2], 0);
+    assert_int_equal(places[1], 1);
+    assert_int_equal(places[3], 2);
+    assert_int_equal(places[0], 3);
+    assert_true(squid_executor_pending(executor, SQUID_EXECUTOR_PRIORITY_LOW,
+                                       &pending));
+    assert_int_equal(pending, 0);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_with_priority_and_aging(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    struct squid_executor *executor = gated_of(2, &instance);
+    uintmax_t places[5];
+    struct triggerfish_strong *out[5];
+    assert_true(squid_executor_submit_with_priority(
+            executor, SQUID_EXECUTOR_PRIORITY_LOW, place, &places[0],
+            &out[0]));
+    for (uintmax_t i = 1; i < 5; i++) {
+        assert_true(squid_executor_submit_with_priority(
+                executor, SQUID_EXECUTOR_PRIORITY_HIGH, place, &places[i],
+                &out[i]));
+    }
+    atomic_store(&is_open, true);
+    for (uintmax_t i = 0; i < 5; i++) {
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out[i], (void **) &future));
+        struct triggerfish_strong *result;
+        assert_true(squid_future_get(future, &result, NULL));
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    /* one of every two turns starts with the lower lanes */
+    assert_in_range(places[0], 0, 1);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_stats_with_cancelled(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    struct squid_executor *executor = gated_of(0, &instance);
+    uintmax_t places[3];
+    struct triggerfish_strong *out[3];
+    for (uintmax_t i = 0; i < 3; i++) {
+        assert_true(squid_executor_submit(executor, place, &places[i],
+                                          &out[i]));
+    }
+    struct squid_executor_stats stats;
+    assert_true(squid_executor_stats(executor, &stats));
+    assert_int_equal(stats.submitted, 4);
+    assert_int_equal(stats.pending, 3);
+    struct squid_future *future;
+    assert_true(triggerfish_strong_instance(out[1], (void **) &future));
+    assert_true(squid_future_cancel(future, NULL));
+    atomic_store(&is_open, true);
+    for (uintmax_t i = 0; i < 3; i++) {
+        assert_true(triggerfish_strong_instance(out[i], (void **) &future));
+        struct triggerfish_strong *result;
+        assert_true(1 == i || squid_future_get(future, &result, NULL));
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    assert_true(squid_executor_stats(executor, &stats));
+    /* the gate and the two tasks that were left */
+    assert_int_equal(stats.completed, 3);
+    assert_int_equal(stats.cancelled, 1);
+    assert_int_equal(stats.pending, 0);
+    assert_int_equal(sum(stats.histogram.wait, 0), 3);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_schedule_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_schedule(NULL, 0, (void *) 1, NULL,
+                                         (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_schedule_error_on_function_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_schedule((void *) 1, 0, NULL, NULL,
+                                         (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_schedule_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_schedule((void *) 1, 0, (void *) 1, NULL,
+                                         NULL));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_schedule_error_on_is_busy_shutting_down(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    assert_true(squid_executor_shutdown(executor));
+    struct triggerfish_strong *out;
+    assert_false(squid_executor_schedule(executor, 0, sleepy, NULL, &out));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_IS_BUSY_SHUTTING_DOWN,
+                     squid_error);
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_schedule_error_on_thread_creation_failed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    struct triggerfish_strong *out;
+    pthread_create_is_overridden = true;
+    will_return(cmocka_test_pthread_create, EAGAIN);
+    assert_false(squid_executor_schedule(executor, 0, sleepy, NULL, &out));
+    pthread_create_is_overridden = false;
+    assert_int_equal(SQUID_EXECUTOR_ERROR_THREAD_CREATION_FAILED, squid_error);
+    assert_int_equal(executor->timer.wheel.count, 0);
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_schedule_at_fixed_rate_error_on_object_is_null(
+        void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_schedule_at_fixed_rate(
+            NULL, 0, 1, (void *) 1, NULL, (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_schedule_at_fixed_rate_error_on_period_is_zero(
+        void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_schedule_at_fixed_rate(
+            (void *) 1, 0, 0, (void *) 1, NULL, (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_PERIOD_IS_ZERO, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_schedule_at_fixed_rate_error_on_function_is_null(
+        void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_schedule_at_fixed_rate(
+            (void *) 1, 0, 1, NULL, NULL, (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_schedule_at_fixed_rate_error_on_out_is_null(
+        void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_schedule_at_fixed_rate(
+            (void *) 1, 0, 1, (void *) 1, NULL, NULL));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static uint64_t milliseconds(void) {
+    struct timespec now;
+    assert_int_equal(clock_gettime(CLOCK_MONOTONIC, &now), 0);
+    return (uint64_t) now.tv_sec * 1000 + (uint64_t) now.tv_nsec / 1000000;
+}
+
+static void check_schedule(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    atomic_uintmax_t count = 0;
+    const uint64_t delays[] = {50, 0, 20};
+    struct triggerfish_strong *out[3];
+    const uint64_t start = milliseconds();
+    for (uintmax_t i = 0; i < 3; i++) {
+        assert_true(squid_executor_schedule(executor, delays[i], sleepy,
+                                            &count, &out[i]));
+    }
+    for (uintmax_t i = 0; i < 3; i++) {
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out[i], (void **) &future));
+        struct triggerfish_strong *result;
+        assert_true(squid_future_get(future, &result, NULL));
+        assert_true(milliseconds() - start >= delays[i]);
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    assert_int_equal(atomic_load(&count), 3);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_schedule_and_cancel(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    atomic_uintmax_t count = 0;
+    struct triggerfish_strong *out[1000];
+    for (uintmax_t i = 0; i < 1000; i++) {
+        /* an hour and more, none of these come due during the test */
+        assert_true(squid_executor_schedule(executor, 3600000 + i, sleepy,
+                                            &count, &out[i]));
+    }
+    assert_int_equal(executor->timer.wheel.count, 1000);
+    for (uintmax_t i = 0; i < 1000; i++) {
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out[i], (void **) &future));
+        assert_true(squid_future_cancel(future, NULL));
+        /* taken off the wheel right away */
+        assert_int_equal(executor->timer.wheel.count, 999 - i);
+        enum squid_future_status status;
+        assert_true(squid_future_status(future, &status));
+        assert_int_equal(status, SQUID_FUTURE_STATUS_CANCELLED);
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    assert_int_equal(atomic_load(&count), 0);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void tick(void *const args,
+                 bool (*const is_cancelled)(void),
+                 struct triggerfish_strong **const out,
+                 uintmax_t *const error) {
+    const uintmax_t ticks = 1 + atomic_fetch_add((atomic_uintmax_t *) args, 1);
+    if (5 == ticks) {
+        *error = ticks;
+    }
+}
+
+static void check_schedule_at_fixed_rate(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    atomic_uintmax_t count = 0;
+    struct triggerfish_strong *out;
+    const uint64_t start = milliseconds();
+    assert_true(squid_executor_schedule_at_fixed_rate(executor, 10, 10, tick,
+                                                      &count, &out));
+    struct squid_future *future;
+    assert_true(triggerfish_strong_instance(out, (void **) &future));
+    struct triggerfish_strong *result;
+    uintmax_t error;
+    /* repeats until the function reports an error */
+    assert_true(squid_future_get(future, &result, &error));
+    assert_int_equal(error, 5);
+    assert_true(milliseconds() - start >= 50);
+    assert_int_equal(atomic_load(&count), 5);
+    assert_int_equal(executor->timer.wheel.count, 0);
+    assert_true(triggerfish_strong_release(out));
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_schedule_at_fixed_rate_and_cancel(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    atomic_uintmax_t count = 0;
+    struct triggerfish_strong *out;
+    assert_true(squid_executor_schedule_at_fixed_rate(executor, 0, 1, sleepy,
+                                                      &count, &out));
+    await_count(&count, 3);
+    struct squid_future *future;
+    assert_true(triggerfish_strong_instance(out, (void **) &future));
+    assert_true(squid_future_cancel(future, NULL));
+    struct triggerfish_strong *result;
+    assert_false(squid_future_get(future, &result, NULL));
+    assert_int_equal(SQUID_FUTURE_ERROR_FUTURE_IS_CANCELLED, squid_error);
+    /* a run that was already underway does not arm the timer again */
+    const struct timespec delay = {
+            .tv_nsec = 10000000 /* 10 milliseconds */
+    };
+    nanosleep(&delay, NULL);
+    const uintmax_t runs = atomic_load(&count);
+    nanosleep(&delay, NULL);
+    assert_int_equal(atomic_load(&count), runs);
+    assert_int_equal(executor->timer.wheel.count, 0);
+    assert_true(triggerfish_strong_release(out));
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_shutdown_now_with_schedule(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    atomic_uintmax_t count = 0;
+    struct triggerfish_strong *out[2];
+    assert_true(squid_executor_schedule(executor, 3600000, sleepy, &count,
+                                        &out[0]));
+    assert_true(squid_executor_schedule_at_fixed_rate(
+            executor, 3600000, 1, sleepy, &count, &out[1]));
+    uintmax_t drained;
+    assert_true(squid_executor_shutdown_now(executor, &drained));
+    assert_int_equal(drained, 2);
+    assert_int_equal(executor->timer.wheel.count, 0);
+    for (uintmax_t i = 0; i < 2; i++) {
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out[i], (void **) &future));
+        enum squid_future_status status;
+        assert_true(squid_future_status(future, &status));
+        assert_int_equal(status, SQUID_FUTURE_STATUS_CANCELLED);
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    assert_int_equal(atomic_load(&count), 0);
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_with_deadline_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_submit_with_deadline(
+            NULL, (void *) 1, (void *) 1, NULL, (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_with_deadline_error_on_deadline_is_null(
+        void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_submit_with_deadline(
+            (void *) 1, NULL, (void *) 1, NULL, (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_DEADLINE_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_with_deadline_error_on_function_is_null(
+        void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_submit_with_deadline(
+            (void *) 1, (void *) 1, NULL, NULL, (void *) 1));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_FUNCTION_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_with_deadline_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_executor_submit_with_deadline(
+            (void *) 1, (void *) 1, (void *) 1, NULL, NULL));
+    assert_int_equal(SQUID_EXECUTOR_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_with_deadline_error_on_deadline_is_invalid(
+        void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    const struct timespec deadlines[] = {
+            {.tv_sec = 1, .tv_nsec = -1},
+            {.tv_sec = 1, .tv_nsec = 1000000000},
+            {.tv_sec = -1, .tv_nsec = 0}
+    };
+    struct triggerfish_strong *out;
+    for (uintmax_t i = 0; i < sizeof(deadlines) / sizeof(*deadlines); i++) {
+        assert_false(squid_executor_submit_with_deadline(
+                (void *) 1, &deadlines[i], (void *) 1, NULL, &out));
+        assert_int_equal(SQUID_EXECUTOR_ERROR_DEADLINE_IS_INVALID,
+                         squid_error);
+    }
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_with_deadline(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.queue.backend = SQUID_EXECUTOR_BACKEND_DEADLINE;
+    struct triggerfish_strong *instance;
+    struct squid_executor *executor = gated_of_options(&options, &instance);
+    struct timespec deadline;
+    deadline_in(&deadline, 60);
+    const time_t offsets[] = {30, 10, 20, 10};
+    uintmax_t places[6];
+    struct triggerfish_strong *out[6];
+    for (uintmax_t i = 0; i < 4; i++) {
+        const struct timespec at = {
+                .tv_sec = deadline.tv_sec + offsets[i],
+                .tv_nsec = deadline.tv_nsec
+        };
+        assert_true(squid_executor_submit_with_deadline(
+                executor, &at, place, &places[i], &out[i]));
+    }
+    /* tasks without a deadline come last in the order they were submitted */
+    assert_true(squid_executor_submit(executor, place, &places[4], &out[4]));
+    assert_true(squid_executor_submit(executor, place, &places[5], &out[5]));
+    uintmax_t pending;
+    assert_true(squid_executor_pending(
+            executor, SQUID_EXECUTOR_PRIORITY_NORMAL, &pending));
+    assert_int_equal(pending, 6);
+    atomic_store(&is_open, true);
+    for (uintmax_t i = 0; i < 6; i++) {
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out[i], (void **) &future));
+        struct triggerfish_strong *result;
+        assert_true(squid_future_get(future, &result, NULL));
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    assert_int_equal(places[1], 0);
+    assert_int_equal(places[3], 1);
+    assert_int_equal(places[2], 2);
+    assert_int_equal(places[0], 3);
+    assert_int_equal(places[4], 4);
+    assert_int_equal(places[5], 5);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_with_deadline_and_enforced(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.queue.backend = SQUID_EXECUTOR_BACKEND_DEADLINE;
+    options.deadline.is_enforced = true;
+    struct triggerfish_strong *instance;
+    struct squid_executor *executor = gated_of_options(&options, &instance);
+    struct timespec past;
+    assert_int_equal(clock_gettime(CLOCK_MONOTONIC, &past), 0);
+    struct timespec future;
+    deadline_in(&future, 60);
+    uintmax_t places[2] = {UINTMAX_MAX, UINTMAX_MAX};
+    struct triggerfish_strong *out[2];
+    assert_true(squid_executor_submit_with_deadline(
+            executor, &past, place, &places[0], &out[0]));
+    assert_true(squid_executor_submit_with_deadline(
+            executor, &future, place, &places[1], &out[1]));
+    atomic_store(&is_open, true);
+    struct squid_future *instances[2];
+    struct triggerfish_strong *result;
+    for (uintmax_t i = 0; i < 2; i++) {
+        assert_true(triggerfish_strong_instance(out[i],
+                                                (void **) &instances[i]));
+    }
+    assert_true(squid_future_get(instances[1], &result, NULL));
+    assert_int_equal(places[1], 0);
+    /* late task was cancelled without being run */
+    assert_false(squid_future_get(instances[0], &result, NULL));
+    assert_int_equal(SQUID_FUTURE_ERROR_DEADLINE_HAS_PASSED, squid_error);
+    enum squid_future_status status;
+    assert_true(squid_future_status(instances[0], &status));
+    assert_int_equal(status, SQUID_FUTURE_STATUS_CANCELLED);
+    assert_int_equal(places[0], UINTMAX_MAX);
+    for (uintmax_t i = 0; i < 2; i++) {
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
 int main(int argc, char *argv[]) {
     const struct CMUnitTest tests[] = {
             cmocka_unit_test(check_invalidate_error_on_object_is_null),
@@ -287,12 +2271,82 @@ int main(int argc, char *argv[]) {
             cmocka_unit_test(check_shutdown_error_on_object_is_null),
             cmocka_unit_test(check_shutdown_error_on_is_busy_shutting_down),
             cmocka_unit_test(check_shutdown),
+            cmocka_unit_test(check_await_termination_error_on_object_is_null),
+            cmocka_unit_test(
+                    check_await_termination_error_on_deadline_is_invalid),
+            cmocka_unit_test(check_await_termination_error_on_timed_out),
+            cmocka_unit_test(check_await_termination),
+            cmocka_unit_test(check_shutdown_now_error_on_object_is_null),
+            cmocka_unit_test(check_shutdown_now_error_on_out_is_null),
+            cmocka_unit_test(
+                    check_shutdown_now_error_on_is_busy_shutting_down),
+            cmocka_unit_test(check_shutdown_now),
+            cmocka_unit_test(check_shutdown_now_with_work_stealing),
+            cmocka_unit_test(check_execute_error_on_queue_is_full),
+            cmocka_unit_test(check_submit_all_error_on_queue_is_full),
+            cmocka_unit_test(check_execute_error_on_timed_out),
+            cmocka_unit_test(check_schedule_with_queue_is_full_and_block),
+            cmocka_unit_test(
+                    check_schedule_with_queue_is_full_and_caller_runs),
+            cmocka_unit_test(check_execute_with_block),
+            cmocka_unit_test(check_execute_with_linked_backend),
+            cmocka_unit_test(check_execute_with_ring_backend),
+            cmocka_unit_test(check_execute_with_block_from_within),
+            cmocka_unit_test(check_execute_with_caller_runs),
+            cmocka_unit_test(check_submit_with_discard_oldest),
+            cmocka_unit_test(
+                    check_submit_with_priority_error_on_object_is_null),
+            cmocka_unit_test(
+                    check_submit_with_priority_error_on_priority_is_invalid),
+            cmocka_unit_test(check_pending_error_on_object_is_null),
+            cmocka_unit_test(check_pending_error_on_priority_is_invalid),
+            cmocka_unit_test(check_pending_error_on_out_is_null),
+            cmocka_unit_test(check_submit_with_priority),
+            cmocka_unit_test(check_submit_with_priority_and_aging),
+            cmocka_unit_test(check_stats_with_cancelled),
+            cmocka_unit_test(check_schedule_error_on_object_is_null),
+            cmocka_unit_test(check_schedule_error_on_function_is_null),
+            cmocka_unit_test(check_schedule_error_on_out_is_null),
+            cmocka_unit_test(check_schedule_error_on_is_busy_shutting_down),
+            cmocka_unit_test(check_schedule_error_on_thread_creation_failed),
+            cmocka_unit_test(
+                    check_schedule_at_fixed_rate_error_on_object_is_null),
+            cmocka_unit_test(
+                    check_schedule_at_fixed_rate_error_on_period_is_zero),
+            cmocka_unit_test(
+                    check_schedule_at_fixed_rate_error_on_function_is_null),
+            cmocka_unit_test(check_schedule_at_fixed_rate_error_on_out_is_null),
+            cmocka_unit_test(check_schedule),
+            cmocka_unit_test(check_schedule_and_cancel),
+            cmocka_unit_test(check_schedule_at_fixed_rate),
+            cmocka_unit_test(check_schedule_at_fixed_rate_and_cancel),
+            cmocka_unit_test(check_shutdown_now_with_schedule),
+            cmocka_unit_test(
+                    check_submit_with_deadline_error_on_object_is_null),
+            cmocka_unit_test(
+                    check_submit_with_deadline_error_on_deadline_is_null),
+            cmocka_unit_test(
+                    check_submit_with_deadline_error_on_function_is_null),
+            cmocka_unit_test(check_submit_with_deadline_error_on_out_is_null),
+            cmocka_unit_test(
+                    check_submit_with_deadline_error_on_deadline_is_invalid),
+            cmocka_unit_test(check_submit_with_deadline),
+            cmocka_unit_test(check_submit_with_deadline_and_enforced),
             cmocka_unit_test(check_init_error_on_object_is_null),
             cmocka_unit_test(check_init),
             cmocka_unit_test(check_init_error_on_memory_allocation_failed),
             cmocka_unit_test(check_of_error_on_out_is_null),
             cmocka_unit_test(check_of),
             cmocka_unit_test(check_of_error_on_memory_allocation_failed),
+            cmocka_unit_test(check_options_init_error_on_options_is_null),
+            cmocka_unit_test(check_options_init),
+            cmocka_unit_test(check_of_with_options_error_on_options_is_null),
+            cmocka_unit_test(check_of_with_options_error_on_out_is_null),
+            cmocka_unit_test(check_of_with_options_error_on_options_is_invalid),
+            cmocka_unit_test(check_of_with_options_error_on_queue_is_invalid),
+            cmocka_unit_test(check_of_with_options),
+            cmocka_unit_test(
+                    check_of_with_options_error_on_thread_creation_failed),
             cmocka_unit_test(check_count_error_on_object_is_null),
             cmocka_unit_test(check_count_error_on_out_is_null),
             cmocka_unit_test(check_count),
@@ -305,6 +2359,52 @@ int main(int argc, char *argv[]) {
             cmocka_unit_test(check_submit_error_on_is_busy_shutting_down),
             cmocka_unit_test(check_submit),
             cmocka_unit_test(check_submit_error_on_thread_creation_failed),
+            cmocka_unit_test(check_submit_with_maximum_threads),
+            cmocka_unit_test(
+                    check_of_with_options_error_on_work_stealing_is_invalid),
+            cmocka_unit_test(check_submit_with_work_stealing),
+            cmocka_unit_test(
+                    check_of_with_options_error_on_affinity_is_invalid),
+#if defined(__linux__)
+            cmocka_unit_test(check_submit_with_affinity),
+#endif
+            cmocka_unit_test(check_submit_with_queue_per_node),
+            cmocka_unit_test(
+                    check_of_with_options_error_on_stack_size_is_invalid),
+#if defined(__linux__)
+            cmocka_unit_test(check_submit_with_thread_attributes),
+#endif
+            cmocka_unit_test(check_pool_hits_error_on_object_is_null),
+            cmocka_unit_test(check_pool_hits_error_on_out_is_null),
+            cmocka_unit_test(check_pool_misses_error_on_object_is_null),
+            cmocka_unit_test(check_pool_misses_error_on_out_is_null),
+            cmocka_unit_test(check_pool_hits_and_misses),
+            cmocka_unit_test(check_stats_error_on_object_is_null),
+            cmocka_unit_test(check_stats_error_on_out_is_null),
+            cmocka_unit_test(check_stats),
+            cmocka_unit_test(check_execute_error_on_object_is_null),
+            cmocka_unit_test(check_execute_error_on_function_is_null),
+            cmocka_unit_test(check_execute_error_on_is_busy_shutting_down),
+            cmocka_unit_test(check_execute_error_on_thread_creation_failed),
+            cmocka_unit_test(check_execute),
+            cmocka_unit_test(check_execute_with_work_stealing),
+            cmocka_unit_test(check_submit_all_error_on_object_is_null),
+            cmocka_unit_test(check_submit_all_error_on_tasks_is_null),
+            cmocka_unit_test(check_submit_all_error_on_count_is_zero),
+            cmocka_unit_test(check_submit_all_error_on_function_is_null),
+            cmocka_unit_test(check_submit_all_error_on_out_is_null),
+            cmocka_unit_test(check_submit_all_error_on_is_busy_shutting_down),
+            cmocka_unit_test(check_submit_all_error_on_thread_creation_failed),
+            cmocka_unit_test(check_submit_all),
+            cmocka_unit_test(check_execute_all_error_on_object_is_null),
+            cmocka_unit_test(check_execute_all_error_on_tasks_is_null),
+            cmocka_unit_test(check_execute_all_error_on_count_is_zero),
+            cmocka_unit_test(check_execute_all_error_on_function_is_null),
+            cmocka_unit_test(check_execute_all_error_on_is_busy_shutting_down),
+            cmocka_unit_test(
+                    check_execute_all_error_on_memory_allocation_failed),
+            cmocka_unit_test(check_execute_all),
+            cmocka_unit_test(check_execute_all_with_work_stealing),
             cmocka_unit_test(check_reference_error_on_out_is_null),
             cmocka_unit_test(check_reference),
             cmocka_unit_test(check_reference_error_on_memory_allocation_failed),
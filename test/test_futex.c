@@ -0,0 +1,81 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <pthread.h>
+#include <time.h>
+#include <squid.h>
+
+#include "private/futex.h"
+
+#include <test/cmocka.h>
+
+static void check_wait_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_futex_wait(NULL, 0, NULL));
+    assert_int_equal(SQUID_FUTEX_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_wait_error_on_timed_out(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    atomic_int object = 0;
+    struct timespec deadline;
+    assert_int_equal(0, clock_gettime(CLOCK_MONOTONIC, &deadline));
+    deadline.tv_nsec += 10000000; /* 10 milliseconds */
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_nsec -= 1000000000;
+        deadline.tv_sec += 1;
+    }
+    assert_false(squid_futex_wait(&object, 0, &deadline));
+    assert_int_equal(SQUID_FUTEX_ERROR_TIMED_OUT, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_wait_on_value_has_changed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    atomic_int object = 1;
+    assert_true(squid_futex_wait(&object, 0, NULL));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_wake_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_futex_wake(NULL, 1));
+    assert_int_equal(SQUID_FUTEX_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void *waker(void *object) {
+    const struct timespec delay = {
+            .tv_nsec = 10000000 /* 10 milliseconds */
+    };
+    nanosleep(&delay, NULL);
+    atomic_store((atomic_int *) object, 1);
+    squid_futex_wake(object, 1);
+    return NULL;
+}
+
+static void check_wake(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    atomic_int object = 0;
+    pthread_t thread;
+    assert_int_equal(0, pthread_create(&thread, NULL, waker, &object));
+    while (!atomic_load(&object)) {
+        assert_true(squid_futex_wait(&object, 0, NULL));
+    }
+    assert_int_equal(0, pthread_join(thread, NULL));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+int main(int argc, char *argv[]) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(check_wait_error_on_object_is_null),
+            cmocka_unit_test(check_wait_error_on_timed_out),
+            cmocka_unit_test(check_wait_on_value_has_changed),
+            cmocka_unit_test(check_wake_error_on_object_is_null),
+            cmocka_unit_test(check_wake),
+    };
+    //cmocka_set_message_output(CM_OUTPUT_XML);
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -2,9 +2,12 @@
 #include <stddef.h>
 #include <setjmp.h>
 #include <cmocka.h>
+#include <pthread.h>
+#include <time.h>
 #include <squid.h>
 
 #include "private/future.h"
+#include "private/executer.h"
 
 #include <test/cmocka.h>
 
@@ -238,6 +241,661 @@ static void check_get_error_on_future_is_cancelled(void **state) {
     squid_error = SQUID_ERROR_NONE;
 }
 
+static void check_notify_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_future_notify(NULL));
+    assert_int_equal(SQUID_FUTURE_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void *complete(void *object) {
+    struct squid_future *const future = object;
+    const struct timespec delay = {
+            .tv_nsec = 10000000 /* 10 milliseconds */
+    };
+    nanosleep(&delay, NULL);
+    future->error = 42;
+    atomic_store(&future->status, SQUID_FUTURE_STATUS_DONE);
+    assert_true(squid_future_notify(future));
+    return NULL;
+}
+
+static void check_get_waits_until_done(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_future object = {};
+    pthread_t thread;
+    assert_int_equal(0, pthread_create(&thread, NULL, complete, &object));
+    struct {
+        struct triggerfish_strong *out;
+        uintmax_t error;
+    } result;
+    assert_true(squid_future_get(&object, &result.out, &result.error));
+    assert_null(result.out);
+    assert_int_equal(result.error, 42);
+    assert_int_equal(atomic_load(&object.waiters), 0);
+    assert_int_equal(0, pthread_join(thread, NULL));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+struct nested {
+    struct squid_executor *executor;
+    pthread_t thread;
+    atomic_bool is_set;
+};
+
+static void mark(void *const args,
+                 bool (*const is_cancelled)(void),
+                 struct triggerfish_strong **const out,
+                 uintmax_t *const error) {
+    struct nested *const nested = args;
+    nested->thread = pthread_self();
+    atomic_store(&nested->is_set, true);
+    *error = 7;
+}
+
+static void await_mark(void *const args,
+                       bool (*const is_cancelled)(void),
+                       struct triggerfish_strong **const out,
+                       uintmax_t *const error) {
+    struct nested *const nested = args;
+    struct triggerfish_strong *future;
+    assert_true(squid_executor_submit(nested->executor, mark, nested,
+                                      &future));
+    struct squid_future *instance;
+    assert_true(triggerfish_strong_instance(future, (void **) &instance));
+    struct triggerfish_strong *result;
+    assert_true(squid_future_get(instance, &result, error));
+    assert_true(triggerfish_strong_release(future));
+    /* it was run by us rather than left for a thread that is not there */
+    assert_true(pthread_equal(pthread_self(), nested->thread));
+}
+
+static void check_get_runs_awaited_task_on_executor_thread(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 1;
+    struct triggerfish_strong *executor;
+    assert_true(squid_executor_of_with_options(&options, &executor));
+    struct nested nested = {0};
+    assert_true(triggerfish_strong_instance(executor,
+                                            (void **) &nested.executor));
+    struct triggerfish_strong *future;
+    assert_true(squid_executor_submit(nested.executor, await_mark, &nested,
+                                      &future));
+    struct squid_future *instance;
+    assert_true(triggerfish_strong_instance(future, (void **) &instance));
+    struct triggerfish_strong *out;
+    uintmax_t error;
+    assert_true(squid_future_get(instance, &out, &error));
+    assert_int_equal(error, 7);
+    assert_true(atomic_load(&nested.is_set));
+    assert_true(triggerfish_strong_release(future));
+    assert_true(squid_executor_shutdown(nested.executor));
+    assert_true(triggerfish_strong_release(executor));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void hold(void *const args,
+                 bool (*const is_cancelled)(void),
+                 struct triggerfish_strong **const out,
+                 uintmax_t *const error) {
+    struct nested *const nested = args;
+    while (!atomic_load(&nested->is_set) && !is_cancelled());
+}
+
+struct waiting {
+    struct nested *nested;
+    struct squid_future *held;
+};
+
+static void await_held(void *const args,
+                       bool (*const is_cancelled)(void),
+                       struct triggerfish_strong **const out,
+                       uintmax_t *const error) {
+    struct waiting *const waiting = args;
+    struct triggerfish_strong *future;
+    assert_true(squid_executor_submit(waiting->nested->executor, mark,
+                                      waiting->nested, &future));
+    struct triggerfish_strong *result;
+    assert_true(squid_future_get(waiting->held, &result, NULL));
+    assert_true(triggerfish_strong_release(future));
+    assert_true(pthread_equal(pthread_self(), waiting->nested->thread));
+}
+
+static void check_get_runs_other_tasks_while_waiting(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 2;
+    struct triggerfish_strong *executor;
+    assert_true(squid_executor_of_with_options(&options, &executor));
+    struct nested nested = {0};
+    assert_true(triggerfish_strong_instance(executor,
+                                            (void **) &nested.executor));
+    struct triggerfish_strong *held;
+    assert_true(squid_executor_submit(nested.executor, hold, &nested,
+                                      &held));
+    struct waiting waiting = {
+            .nested = &nested
+    };
+    assert_true(triggerfish_strong_instance(held, (void **) &waiting.held));
+    while (SQUID_FUTURE_STATUS_RUNNING != atomic_load(&waiting.held->status));
+    /* one thread holds on until the task submitted by the other has run,
+     * which only the waiting thread is left to do */
+    struct triggerfish_strong *future;
+    assert_true(squid_executor_submit(nested.executor, await_held, &waiting,
+                                      &future));
+    struct squid_future *instance;
+    assert_true(triggerfish_strong_instance(future, (void **) &instance));
+    struct triggerfish_strong *out;
+    assert_true(squid_future_get(instance, &out, NULL));
+    assert_true(triggerfish_strong_release(future));
+    assert_true(triggerfish_strong_release(held));
+    assert_true(squid_executor_shutdown(nested.executor));
+    assert_true(triggerfish_strong_release(executor));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_then_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_future_then(NULL, (void *) 1, (void *) 1, (void *) 1));
+    assert_int_equal(SQUID_FUTURE_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_then_error_on_function_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_future_then((void *) 1, (void *) 1, NULL, (void *) 1));
+    assert_int_equal(SQUID_FUTURE_ERROR_FUNCTION_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_then_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_future_then((void *) 1, (void *) 1, (void *) 1, NULL));
+    assert_int_equal(SQUID_FUTURE_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_then_error_on_executor_is_busy_shutting_down(
+        void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_future object = {};
+    struct squid_executor executor = {
+            .is_running = false
+    };
+    assert_false(squid_future_then(&object, &executor, (void *) 1,
+                                   (void *) 1));
+    assert_int_equal(SQUID_FUTURE_ERROR_EXECUTOR_IS_BUSY_SHUTTING_DOWN,
+                     squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void produce(void *const args,
+                    bool (*const is_cancelled)(void),
+                    struct triggerfish_strong **const out,
+                    uintmax_t *const error) {
+    const struct timespec delay = {
+            .tv_nsec = 10000000 /* 10 milliseconds */
+    };
+    nanosleep(&delay, NULL);
+    *error = 21;
+}
+
+static void twice(void *const args,
+                  bool (*const is_cancelled)(void),
+                  struct triggerfish_strong **const out,
+                  uintmax_t *const error) {
+    struct triggerfish_strong *result;
+    uintmax_t value;
+    assert_true(squid_future_get(args, &result, &value));
+    assert_null(result);
+    *error = 2 * value;
+}
+
+static void check_then_result(struct triggerfish_strong *const future,
+                              const uintmax_t expected) {
+    struct squid_future *object;
+    assert_true(triggerfish_strong_instance(future, (void **) &object));
+    struct triggerfish_strong *result;
+    uintmax_t error;
+    assert_true(squid_future_get(object, &result, &error));
+    assert_null(result);
+    assert_int_equal(error, expected);
+}
+
+static void check_then(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    struct triggerfish_strong *first;
+    assert_true(squid_executor_submit(executor, produce, NULL, &first));
+    struct squid_future *future;
+    assert_true(triggerfish_strong_instance(first, (void **) &future));
+    struct triggerfish_strong *second;
+    assert_true(squid_future_then(future, executor, twice, &second));
+    assert_true(triggerfish_strong_instance(second, (void **) &future));
+    struct triggerfish_strong *third;
+    assert_true(squid_future_then(future, executor, twice, &third));
+    check_then_result(third, 84);
+    check_then_result(second, 42);
+    assert_true(triggerfish_strong_release(first));
+    assert_true(triggerfish_strong_release(second));
+    assert_true(triggerfish_strong_release(third));
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_then_inline(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    struct triggerfish_strong *first;
+    assert_true(squid_executor_submit(executor, produce, NULL, &first));
+    struct squid_future *future;
+    assert_true(triggerfish_strong_instance(first, (void **) &future));
+    struct triggerfish_strong *second;
+    assert_true(squid_future_then(future, NULL, twice, &second));
+    check_then_result(second, 42);
+    assert_true(triggerfish_strong_release(first));
+    assert_true(triggerfish_strong_release(second));
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_then_when_done(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    struct triggerfish_strong *first;
+    assert_true(squid_executor_submit(executor, produce, NULL, &first));
+    check_then_result(first, 21);
+    struct squid_future *future;
+    assert_true(triggerfish_strong_instance(first, (void **) &future));
+    struct triggerfish_strong *second;
+    assert_true(squid_future_then(future, NULL, twice, &second));
+    assert_true(triggerfish_strong_instance(second, (void **) &future));
+    enum squid_future_status status;
+    assert_true(squid_future_status(future, &status));
+    assert_int_equal(status, SQUID_FUTURE_STATUS_DONE);
+    check_then_result(second, 42);
+    assert_true(triggerfish_strong_release(first));
+    assert_true(triggerfish_strong_release(second));
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_then_when_cancelled(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    struct squid_future object;
+    assert_true(squid_future_init(&object, instance, produce, NULL));
+    struct triggerfish_strong *second;
+    assert_true(squid_future_then(&object, executor, twice, &second));
+    struct squid_future *future;
+    assert_true(triggerfish_strong_instance(second, (void **) &future));
+    struct triggerfish_strong *third;
+    assert_true(squid_future_then(future, NULL, twice, &third));
+    assert_true(squid_future_cancel(&object, NULL));
+    struct triggerfish_strong *result;
+    assert_false(squid_future_get(future, &result, NULL));
+    assert_int_equal(SQUID_FUTURE_ERROR_FUTURE_IS_CANCELLED, squid_error);
+    assert_true(triggerfish_strong_instance(third, (void **) &future));
+    assert_false(squid_future_get(future, &result, NULL));
+    assert_int_equal(SQUID_FUTURE_ERROR_FUTURE_IS_CANCELLED, squid_error);
+    assert_true(triggerfish_strong_release(second));
+    assert_true(triggerfish_strong_release(third));
+    assert_true(squid_future_invalidate(&object));
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_when_all_error_on_futures_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_future_when_all(NULL, 1, (void *) 1));
+    assert_int_equal(SQUID_FUTURE_ERROR_FUTURES_IS_NULL, squid_error);
+    struct squid_future *futures[] = {(void *) 1, NULL};
+    assert_false(squid_future_when_all(futures, 2, (void *) 1));
+    assert_int_equal(SQUID_FUTURE_ERROR_FUTURES_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_when_all_error_on_count_is_zero(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_future_when_all((void *) 1, 0, (void *) 1));
+    assert_int_equal(SQUID_FUTURE_ERROR_COUNT_IS_ZERO, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_when_all_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_future *futures[] = {(void *) 1};
+    assert_false(squid_future_when_all(futures, 1, NULL));
+    assert_int_equal(SQUID_FUTURE_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_when_all_error_on_memory_allocation_failed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_future *futures[] = {(void *) 1};
+    calloc_is_overridden = true;
+    assert_false(squid_future_when_all(futures, 1, (void *) 1));
+    calloc_is_overridden = false;
+    assert_int_equal(SQUID_FUTURE_ERROR_MEMORY_ALLOCATION_FAILED,
+                     squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+#define INPUTS                                              5
+
+static void stall(void *const args,
+                  bool (*const is_cancelled)(void),
+                  struct triggerfish_strong **const out,
+                  uintmax_t *const error) {
+    const struct timespec delay = {
+            .tv_nsec = 1000000 /* 1 millisecond */
+    };
+    for (uintmax_t i = 0; i < (uintptr_t) args && !is_cancelled(); i++) {
+        nanosleep(&delay, NULL);
+    }
+    *error = (uintptr_t) args;
+}
+
+static void submit_inputs(struct squid_executor *const executor,
+                          const uintptr_t *const delays,
+                          struct triggerfish_strong **const strong,
+                          struct squid_future **const futures) {
+    for (uintmax_t i = 0; i < INPUTS; i++) {
+        assert_true(squid_executor_submit(executor, stall,
+                                          (void *) delays[i], &strong[i]));
+        assert_true(triggerfish_strong_instance(strong[i],
+                                                (void **) &futures[i]));
+    }
+}
+
+static void check_when_all(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    const uintptr_t delays[INPUTS] = {40, 10, 30, 0, 20};
+    struct triggerfish_strong *strong[INPUTS];
+    struct squid_future *futures[INPUTS];
+    submit_inputs(executor, delays, strong, futures);
+    struct triggerfish_strong *all;
+    assert_true(squid_future_when_all(futures, INPUTS, &all));
+    check_then_result(all, 0);
+    for (uintmax_t i = 0; i < INPUTS; i++) {
+        enum squid_future_status status;
+        assert_true(squid_future_status(futures[i], &status));
+        assert_int_equal(status, SQUID_FUTURE_STATUS_DONE);
+        assert_true(triggerfish_strong_release(strong[i]));
+    }
+    /* every input is complete by now */
+    assert_true(squid_future_when_all(futures, INPUTS, &strong[0]));
+    check_then_result(strong[0], 0);
+    assert_true(triggerfish_strong_release(strong[0]));
+    assert_true(triggerfish_strong_release(all));
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_when_any_error_on_futures_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_future_when_any(NULL, 1, false, (void *) 1));
+    assert_int_equal(SQUID_FUTURE_ERROR_FUTURES_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_when_any_error_on_count_is_zero(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_future_when_any((void *) 1, 0, false, (void *) 1));
+    assert_int_equal(SQUID_FUTURE_ERROR_COUNT_IS_ZERO, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_when_any_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_future *futures[] = {(void *) 1};
+    assert_false(squid_future_when_any(futures, 1, false, NULL));
+    assert_int_equal(SQUID_FUTURE_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_when_any(const bool is_cancelling) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    const uintptr_t delays[INPUTS] = {500, 500, 0, 500, 500};
+    struct triggerfish_strong *strong[INPUTS];
+    struct squid_future *futures[INPUTS];
+    submit_inputs(executor, delays, strong, futures);
+    struct triggerfish_strong *any;
+    assert_true(squid_future_when_any(futures, INPUTS, is_cancelling, &any));
+    check_then_result(any, 2);
+    for (uintmax_t i = 0; i < INPUTS; i++) {
+        struct triggerfish_strong *result;
+        uintmax_t error;
+        if (is_cancelling && 2 != i) {
+            assert_false(squid_future_get(futures[i], &result, &error));
+            assert_int_equal(SQUID_FUTURE_ERROR_FUTURE_IS_CANCELLED,
+                             squid_error);
+        } else {
+            assert_true(squid_future_get(futures[i], &result, &error));
+            assert_int_equal(error, delays[i]);
+        }
+        assert_true(triggerfish_strong_release(strong[i]));
+    }
+    assert_true(triggerfish_strong_release(any));
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_when_any_without_cancelling(void **state) {
+    check_when_any(false);
+}
+
+static void check_when_any_with_cancelling(void **state) {
+    check_when_any(true);
+}
+
+static void check_get_until_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_future_get_until(NULL, (void *) 1, (void *) 1,
+                                        (void *) 1));
+    assert_int_equal(SQUID_FUTURE_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_get_until_error_on_deadline_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_future_get_until((void *) 1, NULL, (void *) 1,
+                                        (void *) 1));
+    assert_int_equal(SQUID_FUTURE_ERROR_DEADLINE_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_get_until_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_future_get_until((void *) 1, (void *) 1, NULL,
+                                        (void *) 1));
+    assert_int_equal(SQUID_FUTURE_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_get_until_error_on_deadline_is_invalid(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_future object = {};
+    struct triggerfish_strong *out;
+    const struct timespec deadlines[] = {
+            {.tv_sec = 1, .tv_nsec = -1},
+            {.tv_sec = 1, .tv_nsec = 1000000000},
+            {.tv_sec = -1, .tv_nsec = 0}
+    };
+    for (uintmax_t i = 0; i < sizeof(deadlines) / sizeof(*deadlines); i++) {
+        assert_false(squid_future_get_until(&object, &deadlines[i], &out,
+                                            NULL));
+        assert_int_equal(SQUID_FUTURE_ERROR_DEADLINE_IS_INVALID, squid_error);
+    }
+    assert_int_equal(atomic_load(&object.waiters), 0);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void deadline_in(struct timespec *const deadline,
+                        const long milliseconds) {
+    assert_int_equal(0, clock_gettime(CLOCK_MONOTONIC, deadline));
+    deadline->tv_nsec += milliseconds * 1000000;
+    deadline->tv_sec += deadline->tv_nsec / 1000000000;
+    deadline->tv_nsec %= 1000000000;
+}
+
+static void check_get_until_error_on_timed_out(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_future object = {};
+    struct timespec deadline;
+    deadline_in(&deadline, 10);
+    struct triggerfish_strong *out;
+    assert_false(squid_future_get_until(&object, &deadline, &out, NULL));
+    assert_int_equal(SQUID_FUTURE_ERROR_TIMED_OUT, squid_error);
+    assert_int_equal(atomic_load(&object.waiters), 0);
+    struct timespec now;
+    assert_int_equal(0, clock_gettime(CLOCK_MONOTONIC, &now));
+    assert_true(now.tv_sec > deadline.tv_sec
+                || (now.tv_sec == deadline.tv_sec
+                    && now.tv_nsec >= deadline.tv_nsec));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void await_unqueued(void *const args,
+                           bool (*const is_cancelled)(void),
+                           struct triggerfish_strong **const out,
+                           uintmax_t *const error) {
+    struct squid_future *const future = args;
+    struct timespec deadline;
+    deadline_in(&deadline, 30);
+    struct triggerfish_strong *result;
+    assert_false(squid_future_get_until(future, &deadline, &result, NULL));
+    *error = squid_error;
+}
+
+static void check_get_until_error_on_timed_out_on_executor_thread(
+        void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 1;
+    struct triggerfish_strong *executor;
+    assert_true(squid_executor_of_with_options(&options, &executor));
+    struct squid_executor *instance;
+    assert_true(triggerfish_strong_instance(executor, (void **) &instance));
+    /* never handed to the executor so there is nothing to help with */
+    struct triggerfish_strong *unqueued;
+    assert_true(squid_future_of(executor, mark, NULL, &unqueued));
+    struct squid_future *awaited;
+    assert_true(triggerfish_strong_instance(unqueued, (void **) &awaited));
+    struct triggerfish_strong *future;
+    assert_true(squid_executor_submit(instance, await_unqueued, awaited,
+                                      &future));
+    struct squid_future *waiting;
+    assert_true(triggerfish_strong_instance(future, (void **) &waiting));
+    struct triggerfish_strong *out;
+    uintmax_t error;
+    assert_true(squid_future_get(waiting, &out, &error));
+    assert_int_equal(SQUID_FUTURE_ERROR_TIMED_OUT, error);
+    assert_int_equal(SQUID_FUTURE_STATUS_PENDING,
+                     atomic_load(&awaited->status));
+    assert_true(triggerfish_strong_release(future));
+    assert_true(triggerfish_strong_release(unqueued));
+    assert_true(squid_executor_shutdown(instance));
+    assert_true(triggerfish_strong_release(executor));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_get_until(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_future object = {};
+    pthread_t thread;
+    assert_int_equal(0, pthread_create(&thread, NULL, complete, &object));
+    struct timespec deadline;
+    deadline_in(&deadline, 10000);
+    struct triggerfish_strong *out;
+    uintmax_t error;
+    assert_true(squid_future_get_until(&object, &deadline, &out, &error));
+    assert_null(out);
+    assert_int_equal(error, 42);
+    assert_int_equal(0, pthread_join(thread, NULL));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_try_get_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_future_try_get(NULL, (void *) 1, (void *) 1));
+    assert_int_equal(SQUID_FUTURE_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_try_get_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_future_try_get((void *) 1, NULL, (void *) 1));
+    assert_int_equal(SQUID_FUTURE_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_try_get_error_on_future_is_not_ready(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_future object = {
+            .status = SQUID_FUTURE_STATUS_RUNNING
+    };
+    struct triggerfish_strong *out;
+    assert_false(squid_future_try_get(&object, &out, NULL));
+    assert_int_equal(SQUID_FUTURE_ERROR_FUTURE_IS_NOT_READY, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_try_get_error_on_future_is_cancelled(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_future object = {
+            .status = SQUID_FUTURE_STATUS_CANCELLED
+    };
+    struct triggerfish_strong *out;
+    assert_false(squid_future_try_get(&object, &out, NULL));
+    assert_int_equal(SQUID_FUTURE_ERROR_FUTURE_IS_CANCELLED, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_try_get(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_future object = {
+            .status = SQUID_FUTURE_STATUS_DONE,
+            .error = 42
+    };
+    struct triggerfish_strong *out;
+    uintmax_t error;
+    assert_true(squid_future_try_get(&object, &out, &error));
+    assert_null(out);
+    assert_int_equal(error, 42);
+    squid_error = SQUID_ERROR_NONE;
+}
+
 int main(int argc, char *argv[]) {
     const struct CMUnitTest tests[] = {
             cmocka_unit_test(check_invalidate_error_on_object_is_null),
@@ -262,6 +920,42 @@ int main(int argc, char *argv[]) {
             cmocka_unit_test(check_get_error_on_out_is_null),
             cmocka_unit_test(check_get),
             cmocka_unit_test(check_get_error_on_future_is_cancelled),
+            cmocka_unit_test(check_notify_error_on_object_is_null),
+            cmocka_unit_test(check_get_waits_until_done),
+            cmocka_unit_test(check_get_runs_awaited_task_on_executor_thread),
+            cmocka_unit_test(check_get_runs_other_tasks_while_waiting),
+            cmocka_unit_test(check_then_error_on_object_is_null),
+            cmocka_unit_test(check_then_error_on_function_is_null),
+            cmocka_unit_test(check_then_error_on_out_is_null),
+            cmocka_unit_test(
+                    check_then_error_on_executor_is_busy_shutting_down),
+            cmocka_unit_test(check_then),
+            cmocka_unit_test(check_then_inline),
+            cmocka_unit_test(check_then_when_done),
+            cmocka_unit_test(check_then_when_cancelled),
+            cmocka_unit_test(check_when_all_error_on_futures_is_null),
+            cmocka_unit_test(check_when_all_error_on_count_is_zero),
+            cmocka_unit_test(check_when_all_error_on_out_is_null),
+            cmocka_unit_test(check_when_all_error_on_memory_allocation_failed),
+            cmocka_unit_test(check_when_all),
+            cmocka_unit_test(check_when_any_error_on_futures_is_null),
+            cmocka_unit_test(check_when_any_error_on_count_is_zero),
+            cmocka_unit_test(check_when_any_error_on_out_is_null),
+            cmocka_unit_test(check_when_any_without_cancelling),
+            cmocka_unit_test(check_when_any_with_cancelling),
+            cmocka_unit_test(check_get_until_error_on_object_is_null),
+            cmocka_unit_test(check_get_until_error_on_deadline_is_null),
+            cmocka_unit_test(check_get_until_error_on_out_is_null),
+            cmocka_unit_test(check_get_until_error_on_deadline_is_invalid),
+            cmocka_unit_test(check_get_until_error_on_timed_out),
+            cmocka_unit_test(
+                    check_get_until_error_on_timed_out_on_executor_thread),
+            cmocka_unit_test(check_get_until),
+            cmocka_unit_test(check_try_get_error_on_object_is_null),
+            cmocka_unit_test(check_try_get_error_on_out_is_null),
+            cmocka_unit_test(check_try_get_error_on_future_is_not_ready),
+            cmocka_unit_test(check_try_get_error_on_future_is_cancelled),
+            cmocka_unit_test(check_try_get),
     };
     //cmocka_set_message_output(CM_OUTPUT_XML);
     return cmocka_run_group_tests(tests, NULL, NULL);
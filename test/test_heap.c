@@ -0,0 +1,231 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <squid.h>
+
+#include "private/heap.h"
+
+#include <test/cmocka.h>
+
+static void check_invalidate_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_heap_invalidate(NULL));
+    assert_int_equal(SQUID_HEAP_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_invalidate(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_heap object = {};
+    assert_true(squid_heap_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_heap_init(NULL));
+    assert_int_equal(SQUID_HEAP_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_heap object;
+    assert_true(squid_heap_init(&object));
+    uintmax_t count;
+    assert_true(squid_heap_count(&object, &count));
+    assert_int_equal(count, 0);
+    assert_true(squid_heap_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_reserve_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_heap_reserve(NULL, 1));
+    assert_int_equal(SQUID_HEAP_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_reserve_error_on_memory_allocation_failed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_heap object;
+    assert_true(squid_heap_init(&object));
+    realloc_is_overridden = true;
+    assert_false(squid_heap_reserve(&object, 1));
+    realloc_is_overridden = false;
+    assert_int_equal(SQUID_HEAP_ERROR_MEMORY_ALLOCATION_FAILED, squid_error);
+    assert_false(squid_heap_reserve(&object, UINTMAX_MAX));
+    assert_int_equal(SQUID_HEAP_ERROR_MEMORY_ALLOCATION_FAILED, squid_error);
+    assert_true(squid_heap_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_reserve(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_heap object;
+    assert_true(squid_heap_init(&object));
+    assert_true(squid_heap_reserve(&object, 1000));
+    assert_true(object.size >= 1000);
+    /* reserved room cannot run out */
+    realloc_is_overridden = true;
+    for (uintmax_t i = 0; i < 1000; i++) {
+        assert_true(squid_heap_add(&object, i, NULL));
+    }
+    realloc_is_overridden = false;
+    assert_true(squid_heap_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_heap_add(NULL, 0, NULL));
+    assert_int_equal(SQUID_HEAP_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_error_on_memory_allocation_failed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_heap object;
+    assert_true(squid_heap_init(&object));
+    realloc_is_overridden = true;
+    assert_false(squid_heap_add(&object, 0, NULL));
+    realloc_is_overridden = false;
+    assert_int_equal(SQUID_HEAP_ERROR_MEMORY_ALLOCATION_FAILED, squid_error);
+    assert_true(squid_heap_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_remove_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_heap_remove(NULL, (void *) 1));
+    assert_int_equal(SQUID_HEAP_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_remove_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_heap_remove((void *) 1, NULL));
+    assert_int_equal(SQUID_HEAP_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_remove_error_on_heap_is_empty(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_heap object;
+    assert_true(squid_heap_init(&object));
+    void *out;
+    assert_false(squid_heap_remove(&object, &out));
+    assert_int_equal(SQUID_HEAP_ERROR_HEAP_IS_EMPTY, squid_error);
+    assert_true(squid_heap_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_and_remove(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_heap object;
+    assert_true(squid_heap_init(&object));
+    srand(42);
+    for (uintmax_t i = 0; i < 10000; i++) {
+        const uint64_t key = rand() % 1000;
+        assert_true(squid_heap_add(&object, key, (void *) (uintptr_t) key));
+    }
+    uint64_t previous = 0;
+    for (uintmax_t i = 0; i < 10000; i++) {
+        uint64_t first;
+        assert_true(squid_heap_first(&object, &first));
+        void *out;
+        assert_true(squid_heap_remove(&object, &out));
+        assert_int_equal((uintptr_t) out, first);
+        assert_true(first >= previous);
+        previous = first;
+    }
+    uintmax_t count;
+    assert_true(squid_heap_count(&object, &count));
+    assert_int_equal(count, 0);
+    assert_true(squid_heap_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_and_remove_with_equal_keys(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_heap object;
+    assert_true(squid_heap_init(&object));
+    for (uintptr_t i = 0; i < 1000; i++) {
+        assert_true(squid_heap_add(&object, i % 2, (void *) i));
+    }
+    /* equal keys come out in the order they went in */
+    for (uintptr_t i = 0; i < 1000; i++) {
+        void *out;
+        assert_true(squid_heap_remove(&object, &out));
+        assert_int_equal((uintptr_t) out, i < 500 ? 2 * i : 2 * (i - 500) + 1);
+    }
+    assert_true(squid_heap_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_first_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_heap_first(NULL, (void *) 1));
+    assert_int_equal(SQUID_HEAP_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_first_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_heap_first((void *) 1, NULL));
+    assert_int_equal(SQUID_HEAP_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_first_error_on_heap_is_empty(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_heap object;
+    assert_true(squid_heap_init(&object));
+    uint64_t out;
+    assert_false(squid_heap_first(&object, &out));
+    assert_int_equal(SQUID_HEAP_ERROR_HEAP_IS_EMPTY, squid_error);
+    assert_true(squid_heap_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_count_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_heap_count(NULL, (void *) 1));
+    assert_int_equal(SQUID_HEAP_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_count_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_heap_count((void *) 1, NULL));
+    assert_int_equal(SQUID_HEAP_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+int main(int argc, char *argv[]) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(check_invalidate_error_on_object_is_null),
+            cmocka_unit_test(check_invalidate),
+            cmocka_unit_test(check_init_error_on_object_is_null),
+            cmocka_unit_test(check_init),
+            cmocka_unit_test(check_reserve_error_on_object_is_null),
+            cmocka_unit_test(check_reserve_error_on_memory_allocation_failed),
+            cmocka_unit_test(check_reserve),
+            cmocka_unit_test(check_add_error_on_object_is_null),
+            cmocka_unit_test(check_add_error_on_memory_allocation_failed),
+            cmocka_unit_test(check_remove_error_on_object_is_null),
+            cmocka_unit_test(check_remove_error_on_out_is_null),
+            cmocka_unit_test(check_remove_error_on_heap_is_empty),
+            cmocka_unit_test(check_add_and_remove),
+            cmocka_unit_test(check_add_and_remove_with_equal_keys),
+            cmocka_unit_test(check_first_error_on_object_is_null),
+            cmocka_unit_test(check_first_error_on_out_is_null),
+            cmocka_unit_test(check_first_error_on_heap_is_empty),
+            cmocka_unit_test(check_count_error_on_object_is_null),
+            cmocka_unit_test(check_count_error_on_out_is_null),
+    };
+    //cmocka_set_message_output(CM_OUTPUT_XML);
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,226 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <pthread.h>
+#include <string.h>
+#include <squid.h>
+#if defined(__linux__)
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#include "private/numa.h"
+
+#include <test/cmocka.h>
+
+static void check_parse_error_on_list_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_numa_parse(NULL, (void *) 1));
+    assert_int_equal(SQUID_NUMA_ERROR_LIST_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_parse_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_numa_parse("0", NULL));
+    assert_int_equal(SQUID_NUMA_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_parse_error_on_list_is_invalid(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    const char *const lists[] = {
+            "a", "1-", "-1", "3-1", "1,", "1,,2", "1;2", "0-1024", "1024"
+    };
+    for (uintmax_t i = 0; i < sizeof(lists) / sizeof(*lists); i++) {
+        uint64_t cpus[SQUID_NUMA_WORDS];
+        assert_false(squid_numa_parse(lists[i], cpus));
+        assert_int_equal(SQUID_NUMA_ERROR_LIST_IS_INVALID, squid_error);
+    }
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_parse(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    uint64_t cpus[SQUID_NUMA_WORDS];
+    assert_true(squid_numa_parse("0-3,8,10-11,64,1023\n", cpus));
+    assert_int_equal(cpus[0], 0xd0f);
+    assert_int_equal(cpus[1], 1);
+    for (uintmax_t i = 2; i < SQUID_NUMA_WORDS - 1; i++) {
+        assert_int_equal(cpus[i], 0);
+    }
+    assert_int_equal(cpus[SQUID_NUMA_WORDS - 1], UINT64_C(1) << 63);
+    assert_true(squid_numa_parse("", cpus));
+    for (uintmax_t i = 0; i < SQUID_NUMA_WORDS; i++) {
+        assert_int_equal(cpus[i], 0);
+    }
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_count_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_numa_count(NULL));
+    assert_int_equal(SQUID_NUMA_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_count(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    uintmax_t count;
+    assert_true(squid_numa_count(&count));
+    assert_in_range(count, 1, SQUID_NUMA_NODES);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_cpus_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_numa_cpus(0, NULL));
+    assert_int_equal(SQUID_NUMA_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_cpus_error_on_node_is_out_of_bounds(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    uintmax_t count;
+    assert_true(squid_numa_count(&count));
+    uint64_t cpus[SQUID_NUMA_WORDS];
+    assert_false(squid_numa_cpus(count, cpus));
+    assert_int_equal(SQUID_NUMA_ERROR_NODE_IS_OUT_OF_BOUNDS, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_cpus(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    uintmax_t count;
+    assert_true(squid_numa_count(&count));
+    for (uintmax_t i = 0; i < count; i++) {
+        uint64_t cpus[SQUID_NUMA_WORDS];
+        assert_true(squid_numa_cpus(i, cpus));
+        bool is_empty = true;
+        for (uintmax_t k = 0; k < SQUID_NUMA_WORDS; k++) {
+            is_empty = is_empty && !cpus[k];
+        }
+        assert_false(is_empty);
+    }
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_current_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_numa_current(NULL));
+    assert_int_equal(SQUID_NUMA_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_current(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    uintmax_t count;
+    assert_true(squid_numa_count(&count));
+    uintmax_t node;
+    assert_true(squid_numa_current(&node));
+    assert_true(node < count);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_pin_error_on_cpus_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_numa_pin(NULL));
+    assert_int_equal(SQUID_NUMA_ERROR_CPUS_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_pin_error_on_cpus_is_empty(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    const uint64_t cpus[SQUID_NUMA_WORDS] = {0};
+    assert_false(squid_numa_pin(cpus));
+    assert_int_equal(SQUID_NUMA_ERROR_CPUS_IS_EMPTY, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+/* pins a thread of its own so that the test runner is left alone */
+static void *pin(void *const args) {
+    const uint64_t *const cpus = args;
+    return squid_numa_pin(cpus) ? NULL : (void *) (uintptr_t) squid_error;
+}
+
+static void check_pin_error_on_affinity_failed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    uint64_t cpus[SQUID_NUMA_WORDS];
+    assert_true(squid_numa_cpus(0, cpus));
+    /* the last CPU we can name is unlikely to exist */
+    if (cpus[SQUID_NUMA_WORDS - 1] & UINT64_C(1) << 63) {
+        return;
+    }
+    memset(cpus, 0, sizeof(cpus));
+    cpus[SQUID_NUMA_WORDS - 1] = UINT64_C(1) << 63;
+    pthread_t thread;
+    assert_int_equal(pthread_create(&thread, NULL, pin, cpus), 0);
+    void *result;
+    assert_int_equal(pthread_join(thread, &result), 0);
+    assert_int_equal((uintptr_t) result, SQUID_NUMA_ERROR_AFFINITY_FAILED);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+#if defined(__linux__)
+
+/* the first CPU the test process may run on */
+static unsigned first(void) {
+    const size_t bits = CHAR_BIT * sizeof(unsigned long);
+    unsigned long mask[SQUID_NUMA_CPUS / (CHAR_BIT * sizeof(unsigned long))]
+            = {0};
+    assert_true(syscall(SYS_sched_getaffinity, 0, sizeof(mask), mask) > 0);
+    unsigned i = 0;
+    while (i < SQUID_NUMA_CPUS && !(mask[i / bits] & 1UL << (i % bits))) {
+        i++;
+    }
+    assert_true(i < SQUID_NUMA_CPUS);
+    return i;
+}
+
+#endif
+
+static void check_pin(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    uint64_t cpus[SQUID_NUMA_WORDS] = {0};
+#if defined(__linux__)
+    const unsigned cpu = first();
+    cpus[cpu / 64] = UINT64_C(1) << (cpu % 64);
+#else
+    cpus[0] = 1;
+#endif
+    pthread_t thread;
+    assert_int_equal(pthread_create(&thread, NULL, pin, cpus), 0);
+    void *result;
+    assert_int_equal(pthread_join(thread, &result), 0);
+#if defined(__linux__)
+    assert_null(result);
+#else
+    /* there is no affinity to set anywhere else */
+    assert_int_equal((uintptr_t) result, SQUID_NUMA_ERROR_AFFINITY_FAILED);
+#endif
+    squid_error = SQUID_ERROR_NONE;
+}
+
+int main(int argc, char *argv[]) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(check_parse_error_on_list_is_null),
+            cmocka_unit_test(check_parse_error_on_out_is_null),
+            cmocka_unit_test(check_parse_error_on_list_is_invalid),
+            cmocka_unit_test(check_parse),
+            cmocka_unit_test(check_count_error_on_out_is_null),
+            cmocka_unit_test(check_count),
+            cmocka_unit_test(check_cpus_error_on_out_is_null),
+            cmocka_unit_test(check_cpus_error_on_node_is_out_of_bounds),
+            cmocka_unit_test(check_cpus),
+            cmocka_unit_test(check_current_error_on_out_is_null),
+            cmocka_unit_test(check_current),
+            cmocka_unit_test(check_pin_error_on_cpus_is_null),
+            cmocka_unit_test(check_pin_error_on_cpus_is_empty),
+            cmocka_unit_test(check_pin_error_on_affinity_failed),
+            cmocka_unit_test(check_pin),
+    };
+    //cmocka_set_message_output(CM_OUTPUT_XML);
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
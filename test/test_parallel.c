@@ -0,0 +1,449 @@
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <squid.h>
+
+#include "private/executer.h"
+
+#include <test/cmocka.h>
+
+static void nothing(const uintmax_t begin,
+                    const uintmax_t end,
+                    void *const context) {
+}
+
+static void check_for_error_on_executor_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_parallel_for(NULL, 0, 1, 0, nothing, NULL));
+    assert_int_equal(SQUID_PARALLEL_ERROR_EXECUTOR_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_for_error_on_function_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_parallel_for((void *) 1, 0, 1, 0, NULL, NULL));
+    assert_int_equal(SQUID_PARALLEL_ERROR_FUNCTION_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_for_error_on_range_is_invalid(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_parallel_for((void *) 1, 1, 0, 0, nothing, NULL));
+    assert_int_equal(SQUID_PARALLEL_ERROR_RANGE_IS_INVALID, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_for_error_on_memory_allocation_failed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    malloc_is_overridden = calloc_is_overridden = realloc_is_overridden
+            = posix_memalign_is_overridden = true;
+    assert_false(squid_parallel_for(executor, 0, 100, 0, nothing, NULL));
+    malloc_is_overridden = calloc_is_overridden = realloc_is_overridden
+            = posix_memalign_is_overridden = false;
+    assert_int_equal(SQUID_PARALLEL_ERROR_MEMORY_ALLOCATION_FAILED,
+                     squid_error);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+#define ITERATIONS                                          100000
+
+struct coverage {
+    atomic_uint visits[ITERATIONS];
+    atomic_uintmax_t calls;
+    atomic_uintmax_t largest;
+};
+
+static void visit(const uintmax_t begin,
+                  const uintmax_t end,
+                  void *const context) {
+    struct coverage *const coverage = context;
+    assert_true(begin < end);
+    atomic_fetch_add(&coverage->calls, 1);
+    uintmax_t largest = atomic_load(&coverage->largest);
+    while (end - begin > largest
+           && !atomic_compare_exchange_weak(&coverage->largest, &largest,
+                                            end - begin));
+    for (uintmax_t i = begin; i < end; i++) {
+        atomic_fetch_add(&coverage->visits[i], 1);
+    }
+}
+
+static void check_for_with_empty_range(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    static struct coverage coverage;
+    coverage = (struct coverage) {0};
+    assert_true(squid_parallel_for(executor, 7, 7, 0, visit, &coverage));
+    assert_int_equal(atomic_load(&coverage.calls), 0);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_for(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 4;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    static struct coverage coverage;
+    coverage = (struct coverage) {0};
+    assert_true(squid_parallel_for(executor, 0, ITERATIONS, 0, visit,
+                                   &coverage));
+    for (uintmax_t i = 0; i < ITERATIONS; i++) {
+        assert_int_equal(atomic_load(&coverage.visits[i]), 1);
+    }
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_for_with_grain(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 4;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    static struct coverage coverage;
+    coverage = (struct coverage) {0};
+    assert_true(squid_parallel_for(executor, 10, ITERATIONS, 7, visit,
+                                   &coverage));
+    for (uintmax_t i = 0; i < ITERATIONS; i++) {
+        assert_int_equal(atomic_load(&coverage.visits[i]), i < 10 ? 0 : 1);
+    }
+    assert_true(atomic_load(&coverage.largest) <= 7);
+    /* no more than one short chunk for each time the range was split */
+    assert_true(atomic_load(&coverage.calls) >= (ITERATIONS - 10) / 7);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_for_with_shutdown(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    assert_true(squid_executor_shutdown(executor));
+    /* calling thread does all of the work on its own */
+    static struct coverage coverage;
+    coverage = (struct coverage) {0};
+    assert_true(squid_parallel_for(executor, 0, ITERATIONS, 0, visit,
+                                   &coverage));
+    for (uintmax_t i = 0; i < ITERATIONS; i++) {
+        assert_int_equal(atomic_load(&coverage.visits[i]), 1);
+    }
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_for_with_caller_runs(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 1;
+    options.queue.capacity = 1;
+    options.queue.rejection = SQUID_EXECUTOR_REJECTION_CALLER_RUNS;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    static struct coverage coverage;
+    coverage = (struct coverage) {0};
+    assert_true(squid_parallel_for(executor, 0, ITERATIONS, 0, visit,
+                                   &coverage));
+    for (uintmax_t i = 0; i < ITERATIONS; i++) {
+        assert_int_equal(atomic_load(&coverage.visits[i]), 1);
+    }
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static struct squid_executor *nesting;
+
+static void nest(const uintmax_t begin,
+                 const uintmax_t end,
+                 void *const context) {
+    struct coverage *const coverage = context;
+    for (uintmax_t i = begin; i < end; i++) {
+        /* each outer iteration covers a row of inner ones */
+        assert_true(squid_parallel_for(nesting, i * 100, (i + 1) * 100, 0,
+                                       visit, coverage));
+    }
+}
+
+static void check_for_with_nesting(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 2;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    assert_true(triggerfish_strong_instance(instance, (void **) &nesting));
+    static struct coverage coverage;
+    coverage = (struct coverage) {0};
+    assert_true(squid_parallel_for(nesting, 0, ITERATIONS / 100, 1, nest,
+                                   &coverage));
+    for (uintmax_t i = 0; i < ITERATIONS; i++) {
+        assert_int_equal(atomic_load(&coverage.visits[i]), 1);
+    }
+    assert_true(squid_executor_shutdown(nesting));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void sum(const uintmax_t begin,
+                const uintmax_t end,
+                void *const partial,
+                void *const context) {
+    for (uintmax_t i = begin; i < end; i++) {
+        *(uintmax_t *) partial += i;
+    }
+}
+
+static void add(void *const partial,
+                const void *const other,
+                void *const context) {
+    *(uintmax_t *) partial += *(const uintmax_t *) other;
+}
+
+static const uintmax_t zero = 0;
+
+static const struct squid_parallel_reduction summation = {
+        .size = sizeof(uintmax_t),
+        .identity = &zero,
+        .accumulate = sum,
+        .combine = add
+};
+
+static void check_reduce_error_on_executor_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    uintmax_t out;
+    assert_false(squid_parallel_reduce(NULL, 0, 1, 0, &summation, NULL,
+                                       &out));
+    assert_int_equal(SQUID_PARALLEL_ERROR_EXECUTOR_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_reduce_error_on_reduction_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    uintmax_t out;
+    assert_false(squid_parallel_reduce((void *) 1, 0, 1, 0, NULL, NULL,
+                                       &out));
+    assert_int_equal(SQUID_PARALLEL_ERROR_REDUCTION_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_reduce_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_parallel_reduce((void *) 1, 0, 1, 0, &summation,
+                                       NULL, NULL));
+    assert_int_equal(SQUID_PARALLEL_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_reduce_error_on_reduction_is_invalid(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    uintmax_t out;
+    struct squid_parallel_reduction reduction = summation;
+    reduction.size = 0;
+    assert_false(squid_parallel_reduce((void *) 1, 0, 1, 0, &reduction,
+                                       NULL, &out));
+    assert_int_equal(SQUID_PARALLEL_ERROR_REDUCTION_IS_INVALID, squid_error);
+    reduction = summation;
+    reduction.identity = NULL;
+    assert_false(squid_parallel_reduce((void *) 1, 0, 1, 0, &reduction,
+                                       NULL, &out));
+    assert_int_equal(SQUID_PARALLEL_ERROR_REDUCTION_IS_INVALID, squid_error);
+    reduction = summation;
+    reduction.accumulate = NULL;
+    assert_false(squid_parallel_reduce((void *) 1, 0, 1, 0, &reduction,
+                                       NULL, &out));
+    assert_int_equal(SQUID_PARALLEL_ERROR_REDUCTION_IS_INVALID, squid_error);
+    reduction = summation;
+    reduction.combine = NULL;
+    assert_false(squid_parallel_reduce((void *) 1, 0, 1, 0, &reduction,
+                                       NULL, &out));
+    assert_int_equal(SQUID_PARALLEL_ERROR_REDUCTION_IS_INVALID, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_reduce_error_on_range_is_invalid(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    uintmax_t out;
+    assert_false(squid_parallel_reduce((void *) 1, 1, 0, 0, &summation,
+                                       NULL, &out));
+    assert_int_equal(SQUID_PARALLEL_ERROR_RANGE_IS_INVALID, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_reduce_error_on_memory_allocation_failed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    uintmax_t out;
+    malloc_is_overridden = calloc_is_overridden = realloc_is_overridden
+            = posix_memalign_is_overridden = true;
+    assert_false(squid_parallel_reduce(executor, 0, 100, 0, &summation,
+                                       NULL, &out));
+    malloc_is_overridden = calloc_is_overridden = realloc_is_overridden
+            = posix_memalign_is_overridden = false;
+    assert_int_equal(SQUID_PARALLEL_ERROR_MEMORY_ALLOCATION_FAILED,
+                     squid_error);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_reduce_with_empty_range(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    uintmax_t out = 42;
+    assert_true(squid_parallel_reduce(executor, 3, 3, 0, &summation, NULL,
+                                      &out));
+    assert_int_equal(out, 0);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_reduce(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 4;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    uintmax_t out;
+    assert_true(squid_parallel_reduce(executor, 0, 1000000, 0, &summation,
+                                      NULL, &out));
+    assert_int_equal(out, (uintmax_t) 1000000 * 999999 / 2);
+    assert_true(squid_parallel_reduce(executor, 5, 1000, 3, &summation,
+                                      NULL, &out));
+    assert_int_equal(out, (uintmax_t) 1000 * 999 / 2 - 10);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+struct bounds {
+    uintmax_t minimum;
+    uintmax_t maximum;
+};
+
+static void widen(const uintmax_t begin,
+                  const uintmax_t end,
+                  void *const partial,
+                  void *const context) {
+    const uintmax_t *const values = context;
+    struct bounds *const bounds = partial;
+    for (uintmax_t i = begin; i < end; i++) {
+        if (values[i] < bounds->minimum) {
+            bounds->minimum = values[i];
+        }
+        if (values[i] > bounds->maximum) {
+            bounds->maximum = values[i];
+        }
+    }
+}
+
+static void merge(void *const partial,
+                  const void *const other,
+                  void *const context) {
+    struct bounds *const bounds = partial;
+    const struct bounds *const with = other;
+    if (with->minimum < bounds->minimum) {
+        bounds->minimum = with->minimum;
+    }
+    if (with->maximum > bounds->maximum) {
+        bounds->maximum = with->maximum;
+    }
+}
+
+static void check_reduce_with_struct(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 4;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    static uintmax_t values[ITERATIONS];
+    srand(7);
+    for (uintmax_t i = 0; i < ITERATIONS; i++) {
+        values[i] = 1000 + rand() % 1000;
+    }
+    values[4321] = 3;
+    values[87654] = 5000;
+    const struct bounds identity = {
+            .minimum = UINTMAX_MAX,
+            .maximum = 0
+    };
+    const struct squid_parallel_reduction reduction = {
+            .size = sizeof(struct bounds),
+            .identity = &identity,
+            .accumulate = widen,
+            .combine = merge
+    };
+    struct bounds out;
+    assert_true(squid_parallel_reduce(executor, 0, ITERATIONS, 0, &reduction,
+                                      values, &out));
+    assert_int_equal(out.minimum, 3);
+    assert_int_equal(out.maximum, 5000);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+int main(int argc, char *argv[]) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(check_for_error_on_executor_is_null),
+            cmocka_unit_test(check_for_error_on_function_is_null),
+            cmocka_unit_test(check_for_error_on_range_is_invalid),
+            cmocka_unit_test(check_for_error_on_memory_allocation_failed),
+            cmocka_unit_test(check_for_with_empty_range),
+            cmocka_unit_test(check_for),
+            cmocka_unit_test(check_for_with_grain),
+            cmocka_unit_test(check_for_with_shutdown),
+            cmocka_unit_test(check_for_with_caller_runs),
+            cmocka_unit_test(check_for_with_nesting),
+            cmocka_unit_test(check_reduce_error_on_executor_is_null),
+            cmocka_unit_test(check_reduce_error_on_reduction_is_null),
+            cmocka_unit_test(check_reduce_error_on_out_is_null),
+            cmocka_unit_test(check_reduce_error_on_reduction_is_invalid),
+            cmocka_unit_test(check_reduce_error_on_range_is_invalid),
+            cmocka_unit_test(check_reduce_error_on_memory_allocation_failed),
+            cmocka_unit_test(check_reduce_with_empty_range),
+            cmocka_unit_test(check_reduce),
+            cmocka_unit_test(check_reduce_with_struct),
+    };
+    //cmocka_set_message_output(CM_OUTPUT_XML);
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,287 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <errno.h>
+#include <pthread.h>
+#include <squid.h>
+
+#include "private/pool.h"
+
+#include <test/cmocka.h>
+
+static void check_invalidate_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_pool_invalidate(NULL));
+    assert_int_equal(SQUID_POOL_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_invalidate(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_pool object = {};
+    assert_true(squid_pool_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_pool_init(NULL, 1));
+    assert_int_equal(SQUID_POOL_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init_error_on_size_is_invalid(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_pool object;
+    assert_false(squid_pool_init(&object, 0));
+    assert_int_equal(SQUID_POOL_ERROR_SIZE_IS_INVALID, squid_error);
+    assert_false(squid_pool_init(&object, SIZE_MAX));
+    assert_int_equal(SQUID_POOL_ERROR_SIZE_IS_INVALID, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init_error_on_memory_allocation_failed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_pool object;
+    pthread_mutex_init_is_overridden = true;
+    will_return(cmocka_test_pthread_mutex_init, ENOMEM);
+    assert_false(squid_pool_init(&object, 8));
+    pthread_mutex_init_is_overridden = false;
+    assert_int_equal(SQUID_POOL_ERROR_MEMORY_ALLOCATION_FAILED, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_pool object;
+    assert_true(squid_pool_init(&object, 8));
+    assert_true(squid_pool_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_acquire_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_pool_acquire(NULL, (void *) 1));
+    assert_int_equal(SQUID_POOL_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_acquire_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_pool_acquire((void *) 1, NULL));
+    assert_int_equal(SQUID_POOL_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_acquire_error_on_memory_allocation_failed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_pool object;
+    assert_true(squid_pool_init(&object, 8));
+    uint32_t index;
+    malloc_is_overridden = true;
+    assert_false(squid_pool_acquire(&object, &index));
+    malloc_is_overridden = false;
+    assert_int_equal(SQUID_POOL_ERROR_MEMORY_ALLOCATION_FAILED, squid_error);
+    assert_true(squid_pool_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_acquire(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_pool object;
+    assert_true(squid_pool_init(&object, sizeof(uintmax_t)));
+    uint32_t indices[1000];
+    for (uintmax_t i = 0; i < 1000; i++) {
+        assert_true(squid_pool_acquire(&object, &indices[i]));
+        uintmax_t *block;
+        assert_true(squid_pool_at(&object, indices[i], (void **) &block));
+        *block = i;
+    }
+    for (uintmax_t i = 0; i < 1000; i++) {
+        uintmax_t *block;
+        assert_true(squid_pool_at(&object, indices[i], (void **) &block));
+        assert_int_equal(*block, i);
+    }
+    uintmax_t hits;
+    uintmax_t misses;
+    assert_true(squid_pool_hits(&object, &hits));
+    assert_true(squid_pool_misses(&object, &misses));
+    assert_int_equal(hits, 0);
+    assert_int_equal(misses, 1000);
+    assert_true(squid_pool_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_release_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_pool_release(NULL, 1));
+    assert_int_equal(SQUID_POOL_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_release_error_on_index_is_invalid(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_pool object;
+    assert_true(squid_pool_init(&object, 8));
+    assert_false(squid_pool_release(&object, 0));
+    assert_int_equal(SQUID_POOL_ERROR_INDEX_IS_INVALID, squid_error);
+    assert_false(squid_pool_release(&object, 1));
+    assert_int_equal(SQUID_POOL_ERROR_INDEX_IS_INVALID, squid_error);
+    assert_true(squid_pool_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_release(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_pool object;
+    assert_true(squid_pool_init(&object, 8));
+    uint32_t index;
+    assert_true(squid_pool_acquire(&object, &index));
+    assert_true(squid_pool_release(&object, index));
+    uint32_t other;
+    assert_true(squid_pool_acquire(&object, &other));
+    assert_int_equal(index, other);
+    uintmax_t hits;
+    uintmax_t misses;
+    assert_true(squid_pool_hits(&object, &hits));
+    assert_true(squid_pool_misses(&object, &misses));
+    assert_int_equal(hits, 1);
+    assert_int_equal(misses, 1);
+    assert_true(squid_pool_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_at_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_pool_at(NULL, 1, (void *) 1));
+    assert_int_equal(SQUID_POOL_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_at_error_on_index_is_invalid(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_pool object;
+    assert_true(squid_pool_init(&object, 8));
+    void *out;
+    assert_false(squid_pool_at(&object, 1, &out));
+    assert_int_equal(SQUID_POOL_ERROR_INDEX_IS_INVALID, squid_error);
+    assert_true(squid_pool_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_at_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_pool object;
+    assert_true(squid_pool_init(&object, 8));
+    uint32_t index;
+    assert_true(squid_pool_acquire(&object, &index));
+    assert_false(squid_pool_at(&object, index, NULL));
+    assert_int_equal(SQUID_POOL_ERROR_OUT_IS_NULL, squid_error);
+    assert_true(squid_pool_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_hits_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_pool_hits(NULL, (void *) 1));
+    assert_int_equal(SQUID_POOL_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_hits_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_pool_hits((void *) 1, NULL));
+    assert_int_equal(SQUID_POOL_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_misses_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_pool_misses(NULL, (void *) 1));
+    assert_int_equal(SQUID_POOL_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_misses_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_pool_misses((void *) 1, NULL));
+    assert_int_equal(SQUID_POOL_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+#define THREADS     4
+#define ROUNDS      100000
+
+static void *churn(void *object) {
+    struct squid_pool *const pool = object;
+    for (uintmax_t i = 0; i < ROUNDS; i++) {
+        uint32_t index;
+        if (!squid_pool_acquire(pool, &index)) {
+            return (void *) 1;
+        }
+        atomic_uintmax_t *block;
+        if (!squid_pool_at(pool, index, (void **) &block)
+            || atomic_fetch_add(block, 1) & 1) {
+            /* somebody else is holding the same block */
+            return (void *) 1;
+        }
+        atomic_fetch_add(block, 1);
+        if (!squid_pool_release(pool, index)) {
+            return (void *) 1;
+        }
+    }
+    return NULL;
+}
+
+static void check_acquire_and_release_concurrently(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_pool object;
+    assert_true(squid_pool_init(&object, sizeof(atomic_uintmax_t)));
+    pthread_t threads[THREADS];
+    for (uintmax_t i = 0; i < THREADS; i++) {
+        assert_int_equal(0, pthread_create(&threads[i], NULL, churn,
+                                           &object));
+    }
+    for (uintmax_t i = 0; i < THREADS; i++) {
+        void *result;
+        assert_int_equal(0, pthread_join(threads[i], &result));
+        assert_null(result);
+    }
+    uintmax_t hits;
+    uintmax_t misses;
+    assert_true(squid_pool_hits(&object, &hits));
+    assert_true(squid_pool_misses(&object, &misses));
+    assert_int_equal(hits + misses, THREADS * ROUNDS);
+    assert_in_range(misses, 1, THREADS);
+    assert_true(squid_pool_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+int main(int argc, char *argv[]) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(check_invalidate_error_on_object_is_null),
+            cmocka_unit_test(check_invalidate),
+            cmocka_unit_test(check_init_error_on_object_is_null),
+            cmocka_unit_test(check_init_error_on_size_is_invalid),
+            cmocka_unit_test(check_init_error_on_memory_allocation_failed),
+            cmocka_unit_test(check_init),
+            cmocka_unit_test(check_acquire_error_on_object_is_null),
+            cmocka_unit_test(check_acquire_error_on_out_is_null),
+            cmocka_unit_test(check_acquire_error_on_memory_allocation_failed),
+            cmocka_unit_test(check_acquire),
+            cmocka_unit_test(check_release_error_on_object_is_null),
+            cmocka_unit_test(check_release_error_on_index_is_invalid),
+            cmocka_unit_test(check_release),
+            cmocka_unit_test(check_at_error_on_object_is_null),
+            cmocka_unit_test(check_at_error_on_index_is_invalid),
+            cmocka_unit_test(check_at_error_on_out_is_null),
+            cmocka_unit_test(check_hits_error_on_object_is_null),
+            cmocka_unit_test(check_hits_error_on_out_is_null),
+            cmocka_unit_test(check_misses_error_on_object_is_null),
+            cmocka_unit_test(check_misses_error_on_out_is_null),
+            cmocka_unit_test(check_acquire_and_release_concurrently),
+    };
+    //cmocka_set_message_output(CM_OUTPUT_XML);
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,373 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <pthread.h>
+#include <squid.h>
+
+#include "private/queue.h"
+
+#include <test/cmocka.h>
+
+static void check_invalidate_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_queue_invalidate(NULL));
+    assert_int_equal(SQUID_QUEUE_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_invalidate(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_queue object = {};
+    assert_true(squid_queue_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_queue_init(NULL));
+    assert_int_equal(SQUID_QUEUE_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init_error_on_memory_allocation_failed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_queue object;
+    malloc_is_overridden = true;
+    assert_false(squid_queue_init(&object));
+    malloc_is_overridden = false;
+    assert_int_equal(SQUID_QUEUE_ERROR_MEMORY_ALLOCATION_FAILED, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_queue object;
+    assert_true(squid_queue_init(&object));
+    bool is_empty;
+    assert_true(squid_queue_is_empty(&object, &is_empty));
+    assert_true(is_empty);
+    assert_true(squid_queue_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_queue_add(NULL, (void *) 1));
+    assert_int_equal(SQUID_QUEUE_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_remove_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_queue_remove(NULL, (void *) 1));
+    assert_int_equal(SQUID_QUEUE_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_remove_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_queue_remove((void *) 1, NULL));
+    assert_int_equal(SQUID_QUEUE_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_remove_error_on_queue_is_empty(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_queue object;
+    assert_true(squid_queue_init(&object));
+    void *out;
+    assert_false(squid_queue_remove(&object, &out));
+    assert_int_equal(SQUID_QUEUE_ERROR_QUEUE_IS_EMPTY, squid_error);
+    assert_true(squid_queue_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_and_remove(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_queue object;
+    assert_true(squid_queue_init(&object));
+    for (uintptr_t i = 1; i <= 100; i++) {
+        assert_true(squid_queue_add(&object, (void *) i));
+    }
+    bool is_empty;
+    assert_true(squid_queue_is_empty(&object, &is_empty));
+    assert_false(is_empty);
+    for (uintptr_t i = 1; i <= 100; i++) {
+        void *out;
+        assert_true(squid_queue_remove(&object, &out));
+        assert_ptr_equal(out, (void *) i);
+    }
+    assert_true(squid_queue_is_empty(&object, &is_empty));
+    assert_true(is_empty);
+    assert_true(squid_queue_add(&object, (void *) 1));
+    uintmax_t hits;
+    assert_true(squid_pool_hits(&object.nodes, &hits));
+    assert_int_equal(hits, 1);
+    assert_true(squid_queue_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_all_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_queue_add_all(NULL, (void *) 1, 1));
+    assert_int_equal(SQUID_QUEUE_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_all_error_on_items_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_queue_add_all((void *) 1, NULL, 1));
+    assert_int_equal(SQUID_QUEUE_ERROR_ITEMS_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_all_error_on_count_is_zero(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_queue_add_all((void *) 1, (void *) 1, 0));
+    assert_int_equal(SQUID_QUEUE_ERROR_COUNT_IS_ZERO, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_all_error_on_memory_allocation_failed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_queue object;
+    assert_true(squid_queue_init(&object));
+    void *items[100];
+    for (uintptr_t i = 0; i < 100; i++) {
+        items[i] = (void *) (1 + i);
+    }
+    /* the first slab is exhausted part way through the items */
+    malloc_is_overridden = true;
+    assert_false(squid_queue_add_all(&object, items, 100));
+    malloc_is_overridden = false;
+    assert_int_equal(SQUID_QUEUE_ERROR_MEMORY_ALLOCATION_FAILED, squid_error);
+    bool is_empty;
+    assert_true(squid_queue_is_empty(&object, &is_empty));
+    assert_true(is_empty);
+    assert_true(squid_queue_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_all(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_queue object;
+    assert_true(squid_queue_init(&object));
+    assert_true(squid_queue_add(&object, (void *) 1));
+    void *items[100];
+    for (uintptr_t i = 0; i < 100; i++) {
+        items[i] = (void *) (2 + i);
+    }
+    assert_true(squid_queue_add_all(&object, items, 100));
+    assert_true(squid_queue_add(&object, (void *) 102));
+    for (uintptr_t i = 1; i <= 102; i++) {
+        void *out;
+        assert_true(squid_queue_remove(&object, &out));
+        assert_ptr_equal(out, (void *) i);
+    }
+    bool is_empty;
+    assert_true(squid_queue_is_empty(&object, &is_empty));
+    assert_true(is_empty);
+    assert_true(squid_queue_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_is_empty_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_queue_is_empty(NULL, (void *) 1));
+    assert_int_equal(SQUID_QUEUE_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_is_empty_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_queue_is_empty((void *) 1, NULL));
+    assert_int_equal(SQUID_QUEUE_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+#define PRODUCERS   4
+#define CONSUMERS   4
+#define ITEMS       100000
+#define BATCH       10
+
+static struct squid_queue queue;
+static atomic_uintmax_t removed;
+static atomic_uintmax_t seen[1 + PRODUCERS * ITEMS];
+static uintptr_t last[CONSUMERS][PRODUCERS];
+
+static void *producer(void *object) {
+    const uintptr_t offset = (uintptr_t) object;
+    /* alternate between single items and batches of BATCH items */
+    for (uintptr_t i = 1; i <= ITEMS;) {
+        if (i % (2 * BATCH) == 1 && i + BATCH - 1 <= ITEMS) {
+            void *items[BATCH];
+            for (uintptr_t j = 0; j < BATCH; j++) {
+                items[j] = (void *) (offset * ITEMS + i + j);
+            }
+            if (!squid_queue_add_all(&queue, items, BATCH)) {
+                return (void *) 1;
+            }
+            i += BATCH;
+            continue;
+        }
+        if (!squid_queue_add(&queue, (void *) (offset * ITEMS + i))) {
+            return (void *) 1;
+        }
+        i++;
+    }
+    return NULL;
+}
+
+static bool consume(uintptr_t *const order, void *const item) {
+    atomic_fetch_add(&removed, 1);
+    const uintptr_t value = (uintptr_t) item;
+    atomic_fetch_add(&seen[value], 1);
+    /* items of the same producer must come out in order */
+    const uintptr_t from = (value - 1) / ITEMS;
+    if (value <= order[from]) {
+        return false;
+    }
+    order[from] = value;
+    return true;
+}
+
+static bool is_out_of_order;
+
+static void drain(void *const item, void *const args) {
+    if (!consume(args, item)) {
+        is_out_of_order = true;
+    }
+}
+
+static void *consumer(void *object) {
+    uintptr_t *const order = last[(uintptr_t) object];
+    while (atomic_load(&removed) < PRODUCERS * ITEMS) {
+        /* one of the consumers takes whatever is there in one go */
+        if (!object) {
+            uintmax_t count;
+            if (!squid_queue_drain(&queue, drain, order, &count)
+                || is_out_of_order) {
+                return (void *) 1;
+            }
+            continue;
+        }
+        void *out;
+        if (!squid_queue_remove(&queue, &out)) {
+            continue;
+        }
+        if (!consume(order, out)) {
+            return (void *) 1;
+        }
+    }
+    return NULL;
+}
+
+static void check_add_and_remove_concurrently(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_true(squid_queue_init(&queue));
+    pthread_t threads[PRODUCERS + CONSUMERS];
+    for (uintptr_t i = 0; i < CONSUMERS; i++) {
+        assert_int_equal(0, pthread_create(&threads[i], NULL, consumer,
+                                           (void *) i));
+    }
+    for (uintptr_t i = 0; i < PRODUCERS; i++) {
+        assert_int_equal(0, pthread_create(&threads[CONSUMERS + i], NULL,
+                                           producer, (void *) i));
+    }
+    for (uintmax_t i = 0; i < PRODUCERS + CONSUMERS; i++) {
+        void *result;
+        assert_int_equal(0, pthread_join(threads[i], &result));
+        assert_null(result);
+    }
+    for (uintmax_t i = 1; i <= PRODUCERS * ITEMS; i++) {
+        assert_int_equal(atomic_load(&seen[i]), 1);
+    }
+    assert_true(squid_queue_invalidate(&queue));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_drain_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_queue_drain(NULL, (void *) 1, NULL, (void *) 1));
+    assert_int_equal(SQUID_QUEUE_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_drain_error_on_function_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_queue_drain((void *) 1, NULL, NULL, (void *) 1));
+    assert_int_equal(SQUID_QUEUE_ERROR_FUNCTION_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_drain_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_queue_drain((void *) 1, (void *) 1, NULL, NULL));
+    assert_int_equal(SQUID_QUEUE_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void drained(void *const item, void *const args) {
+    uintptr_t *const expected = args;
+    assert_ptr_equal(item, (void *) *expected);
+    (*expected)++;
+}
+
+static void check_drain(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_queue object;
+    assert_true(squid_queue_init(&object));
+    uintptr_t expected = 1;
+    uintmax_t count;
+    assert_true(squid_queue_drain(&object, drained, &expected, &count));
+    assert_int_equal(count, 0);
+    for (uintptr_t i = 1; i <= 100; i++) {
+        assert_true(squid_queue_add(&object, (void *) i));
+    }
+    assert_true(squid_queue_drain(&object, drained, &expected, &count));
+    assert_int_equal(count, 100);
+    assert_int_equal(expected, 101);
+    bool is_empty;
+    assert_true(squid_queue_is_empty(&object, &is_empty));
+    assert_true(is_empty);
+    /* the queue keeps working with the old tail as its sentinel */
+    assert_true(squid_queue_add(&object, (void *) 101));
+    void *out;
+    assert_true(squid_queue_remove(&object, &out));
+    assert_ptr_equal(out, (void *) 101);
+    uintmax_t hits;
+    assert_true(squid_pool_hits(&object.nodes, &hits));
+    assert_int_equal(hits, 1);
+    assert_true(squid_queue_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+int main(int argc, char *argv[]) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(check_invalidate_error_on_object_is_null),
+            cmocka_unit_test(check_invalidate),
+            cmocka_unit_test(check_init_error_on_object_is_null),
+            cmocka_unit_test(check_init_error_on_memory_allocation_failed),
+            cmocka_unit_test(check_init),
+            cmocka_unit_test(check_add_error_on_object_is_null),
+            cmocka_unit_test(check_remove_error_on_object_is_null),
+            cmocka_unit_test(check_remove_error_on_out_is_null),
+            cmocka_unit_test(check_remove_error_on_queue_is_empty),
+            cmocka_unit_test(check_add_and_remove),
+            cmocka_unit_test(check_add_all_error_on_object_is_null),
+            cmocka_unit_test(check_add_all_error_on_items_is_null),
+            cmocka_unit_test(check_add_all_error_on_count_is_zero),
+            cmocka_unit_test(check_add_all_error_on_memory_allocation_failed),
+            cmocka_unit_test(check_add_all),
+            cmocka_unit_test(check_drain_error_on_object_is_null),
+            cmocka_unit_test(check_drain_error_on_function_is_null),
+            cmocka_unit_test(check_drain_error_on_out_is_null),
+            cmocka_unit_test(check_drain),
+            cmocka_unit_test(check_is_empty_error_on_object_is_null),
+            cmocka_unit_test(check_is_empty_error_on_out_is_null),
+            cmocka_unit_test(check_add_and_remove_concurrently),
+    };
+    //cmocka_set_message_output(CM_OUTPUT_XML);
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
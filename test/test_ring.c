@@ -0,0 +1,322 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <pthread.h>
+#include <sched.h>
+#include <squid.h>
+
+#include "private/ring.h"
+
+#include <test/cmocka.h>
+
+static void check_invalidate_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_ring_invalidate(NULL));
+    assert_int_equal(SQUID_RING_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_invalidate(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_ring object = {};
+    assert_true(squid_ring_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_ring_init(NULL, 1));
+    assert_int_equal(SQUID_RING_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init_error_on_capacity_is_invalid(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_ring object;
+    assert_false(squid_ring_init(&object, 0));
+    assert_int_equal(SQUID_RING_ERROR_CAPACITY_IS_INVALID, squid_error);
+    assert_false(squid_ring_init(&object, UINTMAX_MAX));
+    assert_int_equal(SQUID_RING_ERROR_CAPACITY_IS_INVALID, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init_error_on_memory_allocation_failed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_ring object;
+    malloc_is_overridden = true;
+    assert_false(squid_ring_init(&object, 1));
+    malloc_is_overridden = false;
+    assert_int_equal(SQUID_RING_ERROR_MEMORY_ALLOCATION_FAILED, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_ring object;
+    assert_true(squid_ring_init(&object, 3));
+    assert_int_equal(object.mask, 3);
+    /* slots start on a cache line boundary */
+    assert_int_equal((uintptr_t) object.slots % SQUID_RING_CACHE_LINE, 0);
+    uintmax_t count;
+    assert_true(squid_ring_count(&object, &count));
+    assert_int_equal(count, 0);
+    assert_true(squid_ring_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_ring_add(NULL, (void *) 1));
+    assert_int_equal(SQUID_RING_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_error_on_ring_is_full(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_ring object;
+    assert_true(squid_ring_init(&object, 4));
+    for (uintptr_t i = 1; i <= 4; i++) {
+        assert_true(squid_ring_add(&object, (void *) i));
+    }
+    assert_false(squid_ring_add(&object, (void *) 5));
+    assert_int_equal(SQUID_RING_ERROR_RING_IS_FULL, squid_error);
+    assert_true(squid_ring_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_remove_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_ring_remove(NULL, (void *) 1));
+    assert_int_equal(SQUID_RING_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_remove_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_ring_remove((void *) 1, NULL));
+    assert_int_equal(SQUID_RING_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_remove_error_on_ring_is_empty(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_ring object;
+    assert_true(squid_ring_init(&object, 4));
+    void *out;
+    assert_false(squid_ring_remove(&object, &out));
+    assert_int_equal(SQUID_RING_ERROR_RING_IS_EMPTY, squid_error);
+    assert_true(squid_ring_invalidate(&object));
+    assert_false(squid_ring_remove(&object, &out));
+    assert_int_equal(SQUID_RING_ERROR_RING_IS_EMPTY, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_and_remove(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_ring object;
+    assert_true(squid_ring_init(&object, 8));
+    /* go around the ring a few times */
+    for (uintptr_t i = 1; i <= 100; i++) {
+        assert_true(squid_ring_add(&object, (void *) i));
+        assert_true(squid_ring_add(&object, (void *) (1000 + i)));
+        void *out;
+        assert_true(squid_ring_remove(&object, &out));
+        assert_ptr_equal(out, (void *) i);
+        assert_true(squid_ring_remove(&object, &out));
+        assert_ptr_equal(out, (void *) (1000 + i));
+    }
+    uintmax_t count;
+    assert_true(squid_ring_count(&object, &count));
+    assert_int_equal(count, 0);
+    assert_true(squid_ring_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_all_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_ring_add_all(NULL, (void *) 1, 1));
+    assert_int_equal(SQUID_RING_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_all_error_on_items_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_ring_add_all((void *) 1, NULL, 1));
+    assert_int_equal(SQUID_RING_ERROR_ITEMS_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_all_error_on_count_is_zero(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_ring_add_all((void *) 1, (void *) 1, 0));
+    assert_int_equal(SQUID_RING_ERROR_COUNT_IS_ZERO, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_all_error_on_ring_is_full(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_ring object;
+    assert_true(squid_ring_init(&object, 4));
+    void *items[] = {(void *) 1, (void *) 2, (void *) 3, (void *) 4,
+                     (void *) 5};
+    assert_false(squid_ring_add_all(&object, items, 5));
+    assert_int_equal(SQUID_RING_ERROR_RING_IS_FULL, squid_error);
+    assert_true(squid_ring_add(&object, items[0]));
+    assert_true(squid_ring_add(&object, items[1]));
+    assert_false(squid_ring_add_all(&object, items + 2, 3));
+    assert_int_equal(SQUID_RING_ERROR_RING_IS_FULL, squid_error);
+    /* nothing was added by the failed attempts */
+    uintmax_t count;
+    assert_true(squid_ring_count(&object, &count));
+    assert_int_equal(count, 2);
+    assert_true(squid_ring_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_all(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_ring object;
+    assert_true(squid_ring_init(&object, 8));
+    void *items[] = {(void *) 2, (void *) 3, (void *) 4, (void *) 5,
+                     (void *) 6, (void *) 7};
+    for (uintptr_t lap = 0; lap < 10; lap++) {
+        assert_true(squid_ring_add(&object, (void *) 1));
+        assert_true(squid_ring_add_all(&object, items, 6));
+        assert_true(squid_ring_add(&object, (void *) 8));
+        for (uintptr_t i = 1; i <= 8; i++) {
+            void *out;
+            assert_true(squid_ring_remove(&object, &out));
+            assert_ptr_equal(out, (void *) i);
+        }
+    }
+    assert_true(squid_ring_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_count_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_ring_count(NULL, (void *) 1));
+    assert_int_equal(SQUID_RING_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_count_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_ring_count((void *) 1, NULL));
+    assert_int_equal(SQUID_RING_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+#define PRODUCERS   4
+#define CONSUMERS   4
+#define ITEMS       100000
+#define BATCH       10
+
+static struct squid_ring ring;
+static atomic_uintmax_t removed;
+static atomic_uintmax_t seen[1 + PRODUCERS * ITEMS];
+static uintptr_t last[CONSUMERS][PRODUCERS];
+
+static void *producer(void *object) {
+    const uintptr_t offset = (uintptr_t) object;
+    /* alternate between single items and batches of BATCH items */
+    for (uintptr_t i = 1; i <= ITEMS;) {
+        if (i % (2 * BATCH) == 1 && i + BATCH - 1 <= ITEMS) {
+            void *items[BATCH];
+            for (uintptr_t j = 0; j < BATCH; j++) {
+                items[j] = (void *) (offset * ITEMS + i + j);
+            }
+            if (squid_ring_add_all(&ring, items, BATCH)) {
+                i += BATCH;
+            } else if (SQUID_RING_ERROR_RING_IS_FULL != squid_error) {
+                return (void *) 1;
+            } else {
+                sched_yield();
+            }
+            continue;
+        }
+        if (squid_ring_add(&ring, (void *) (offset * ITEMS + i))) {
+            i++;
+        } else if (SQUID_RING_ERROR_RING_IS_FULL != squid_error) {
+            return (void *) 1;
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *consumer(void *object) {
+    uintptr_t *const order = last[(uintptr_t) object];
+    while (atomic_load(&removed) < PRODUCERS * ITEMS) {
+        void *out;
+        if (!squid_ring_remove(&ring, &out)) {
+            /* a producer may be part way through filling the slot */
+            sched_yield();
+            continue;
+        }
+        atomic_fetch_add(&removed, 1);
+        const uintptr_t value = (uintptr_t) out;
+        atomic_fetch_add(&seen[value], 1);
+        /* items of the same producer must come out in order */
+        const uintptr_t from = (value - 1) / ITEMS;
+        if (value <= order[from]) {
+            return (void *) 1;
+        }
+        order[from] = value;
+    }
+    return NULL;
+}
+
+static void check_add_and_remove_concurrently(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    /* small enough for producers to keep running into a full ring */
+    assert_true(squid_ring_init(&ring, 64));
+    pthread_t threads[PRODUCERS + CONSUMERS];
+    for (uintptr_t i = 0; i < CONSUMERS; i++) {
+        assert_int_equal(0, pthread_create(&threads[i], NULL, consumer,
+                                           (void *) i));
+    }
+    for (uintptr_t i = 0; i < PRODUCERS; i++) {
+        assert_int_equal(0, pthread_create(&threads[CONSUMERS + i], NULL,
+                                           producer, (void *) i));
+    }
+    for (uintmax_t i = 0; i < PRODUCERS + CONSUMERS; i++) {
+        void *result;
+        assert_int_equal(0, pthread_join(threads[i], &result));
+        assert_null(result);
+    }
+    for (uintmax_t i = 1; i <= PRODUCERS * ITEMS; i++) {
+        assert_int_equal(atomic_load(&seen[i]), 1);
+    }
+    assert_true(squid_ring_invalidate(&ring));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+int main(int argc, char *argv[]) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(check_invalidate_error_on_object_is_null),
+            cmocka_unit_test(check_invalidate),
+            cmocka_unit_test(check_init_error_on_object_is_null),
+            cmocka_unit_test(check_init_error_on_capacity_is_invalid),
+            cmocka_unit_test(check_init_error_on_memory_allocation_failed),
+            cmocka_unit_test(check_init),
+            cmocka_unit_test(check_add_error_on_object_is_null),
+            cmocka_unit_test(check_add_error_on_ring_is_full),
+            cmocka_unit_test(check_remove_error_on_object_is_null),
+            cmocka_unit_test(check_remove_error_on_out_is_null),
+            cmocka_unit_test(check_remove_error_on_ring_is_empty),
+            cmocka_unit_test(check_add_and_remove),
+            cmocka_unit_test(check_add_all_error_on_object_is_null),
+            cmocka_unit_test(check_add_all_error_on_items_is_null),
+            cmocka_unit_test(check_add_all_error_on_count_is_zero),
+            cmocka_unit_test(check_add_all_error_on_ring_is_full),
+            cmocka_unit_test(check_add_all),
+            cmocka_unit_test(check_count_error_on_object_is_null),
+            cmocka_unit_test(check_count_error_on_out_is_null),
+            cmocka_unit_test(check_add_and_remove_concurrently),
+    };
+    //cmocka_set_message_output(CM_OUTPUT_XML);
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,529 @@
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <time.h>
+#include <squid.h>
+
+#include "private/strand.h"
+#include "private/executer.h"
+#include "private/future.h"
+
+#include <test/cmocka.h>
+
+static void check_invalidate_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_strand_invalidate(NULL));
+    assert_int_equal(SQUID_STRAND_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_invalidate(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_strand object = {};
+    assert_true(squid_strand_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_strand_init(NULL, (void *) 1));
+    assert_int_equal(SQUID_STRAND_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init_error_on_executor_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_strand_init((void *) 1, NULL));
+    assert_int_equal(SQUID_STRAND_ERROR_EXECUTOR_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *executor;
+    assert_true(squid_executor_of(&executor));
+    struct squid_strand object;
+    assert_true(squid_strand_init(&object, executor));
+    uintmax_t pending;
+    assert_true(squid_strand_pending(&object, &pending));
+    assert_int_equal(pending, 0);
+    assert_true(squid_strand_invalidate(&object));
+    assert_true(triggerfish_strong_release(executor));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_of_error_on_executor_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_strand_of(NULL, (void *) 1));
+    assert_int_equal(SQUID_STRAND_ERROR_EXECUTOR_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_of_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_strand_of((void *) 1, NULL));
+    assert_int_equal(SQUID_STRAND_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_of_error_on_is_busy_shutting_down(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    assert_true(squid_executor_shutdown(executor));
+    struct triggerfish_strong *out;
+    assert_false(squid_strand_of(executor, &out));
+    assert_int_equal(SQUID_STRAND_ERROR_IS_BUSY_SHUTTING_DOWN, squid_error);
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_of_error_on_memory_allocation_failed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    struct triggerfish_strong *out;
+    malloc_is_overridden = calloc_is_overridden = realloc_is_overridden
+            = posix_memalign_is_overridden = true;
+    assert_false(squid_strand_of(executor, &out));
+    malloc_is_overridden = calloc_is_overridden = realloc_is_overridden
+            = posix_memalign_is_overridden = false;
+    assert_int_equal(SQUID_STRAND_ERROR_MEMORY_ALLOCATION_FAILED, squid_error);
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_of(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    struct triggerfish_strong *out;
+    assert_true(squid_strand_of(executor, &out));
+    assert_true(triggerfish_strong_release(out));
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_strand_submit(NULL, (void *) 1, NULL, (void *) 1));
+    assert_int_equal(SQUID_STRAND_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_error_on_function_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_strand_submit((void *) 1, NULL, NULL, (void *) 1));
+    assert_int_equal(SQUID_STRAND_ERROR_FUNCTION_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_strand_submit((void *) 1, (void *) 1, NULL, NULL));
+    assert_int_equal(SQUID_STRAND_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void nothing(void *const args,
+                    bool (*const is_cancelled)(void),
+                    struct triggerfish_strong **const out,
+                    uintmax_t *const error) {
+}
+
+static void check_submit_error_on_is_busy_shutting_down(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    struct triggerfish_strong *strand;
+    assert_true(squid_strand_of(executor, &strand));
+    struct squid_strand *object;
+    assert_true(triggerfish_strong_instance(strand, (void **) &object));
+    assert_true(squid_executor_shutdown(executor));
+    struct triggerfish_strong *out;
+    assert_false(squid_strand_submit(object, nothing, NULL, &out));
+    assert_int_equal(SQUID_STRAND_ERROR_IS_BUSY_SHUTTING_DOWN, squid_error);
+    assert_true(triggerfish_strong_release(strand));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_error_on_memory_allocation_failed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    struct triggerfish_strong *strand;
+    assert_true(squid_strand_of(executor, &strand));
+    struct squid_strand *object;
+    assert_true(triggerfish_strong_instance(strand, (void **) &object));
+    struct triggerfish_strong *out;
+    malloc_is_overridden = calloc_is_overridden = realloc_is_overridden
+            = posix_memalign_is_overridden = true;
+    assert_false(squid_strand_submit(object, nothing, NULL, &out));
+    malloc_is_overridden = calloc_is_overridden = realloc_is_overridden
+            = posix_memalign_is_overridden = false;
+    assert_int_equal(SQUID_STRAND_ERROR_MEMORY_ALLOCATION_FAILED, squid_error);
+    uintmax_t pending;
+    assert_true(squid_strand_pending(object, &pending));
+    assert_int_equal(pending, 0);
+    assert_true(triggerfish_strong_release(strand));
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+/* state that is only ever touched from within the tasks of one strand */
+struct tally {
+    atomic_bool is_busy;
+    uintmax_t count;
+    uintmax_t order[1000];
+    bool is_overlapped;
+};
+
+static void count(void *const args,
+                  bool (*const is_cancelled)(void),
+                  struct triggerfish_strong **const out,
+                  uintmax_t *const error) {
+    struct tally *const tally = args;
+    if (atomic_exchange(&tally->is_busy, true)) {
+        tally->is_overlapped = true;
+    }
+    tally->order[tally->count] = tally->count;
+    tally->count++;
+    atomic_store(&tally->is_busy, false);
+}
+
+static void check_submit(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 4;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    struct triggerfish_strong *strand;
+    assert_true(squid_strand_of(executor, &strand));
+    struct squid_strand *object;
+    assert_true(triggerfish_strong_instance(strand, (void **) &object));
+    static struct tally tally;
+    tally = (struct tally) {0};
+    struct triggerfish_strong *out[1000];
+    for (uintmax_t i = 0; i < 1000; i++) {
+        assert_true(squid_strand_submit(object, count, &tally, &out[i]));
+    }
+    for (uintmax_t i = 0; i < 1000; i++) {
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out[i], (void **) &future));
+        struct triggerfish_strong *result;
+        assert_true(squid_future_get(future, &result, NULL));
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    /* tasks ran one at a time in the order they were submitted */
+    assert_false(tally.is_overlapped);
+    assert_int_equal(tally.count, 1000);
+    for (uintmax_t i = 0; i < 1000; i++) {
+        assert_int_equal(tally.order[i], i);
+    }
+    uintmax_t pending;
+    assert_true(squid_strand_pending(object, &pending));
+    assert_int_equal(pending, 0);
+    assert_true(triggerfish_strong_release(strand));
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static struct squid_strand *feeding;
+
+static void feed(void *const args,
+                 bool (*const is_cancelled)(void),
+                 struct triggerfish_strong **const out,
+                 uintmax_t *const error) {
+    struct tally *const tally = args;
+    count(args, is_cancelled, out, error);
+    if (tally->count < 1000) {
+        /* task submitted from within the strand runs after this one */
+        struct triggerfish_strong *future;
+        assert_true(squid_strand_submit(feeding, feed, args, &future));
+        assert_true(triggerfish_strong_release(future));
+    }
+}
+
+static void check_submit_from_within_strand(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    struct triggerfish_strong *strand;
+    assert_true(squid_strand_of(executor, &strand));
+    assert_true(triggerfish_strong_instance(strand, (void **) &feeding));
+    static struct tally tally;
+    tally = (struct tally) {0};
+    struct triggerfish_strong *out;
+    assert_true(squid_strand_submit(feeding, feed, &tally, &out));
+    assert_true(triggerfish_strong_release(out));
+    const struct timespec delay = {
+            .tv_nsec = 1000000 /* 1 millisecond */
+    };
+    uintmax_t pending;
+    do {
+        nanosleep(&delay, NULL);
+        assert_true(squid_strand_pending(feeding, &pending));
+    } while (pending);
+    assert_false(tally.is_overlapped);
+    assert_int_equal(tally.count, 1000);
+    assert_true(triggerfish_strong_release(strand));
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_with_caller_runs(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 1;
+    options.queue.capacity = 1;
+    options.queue.rejection = SQUID_EXECUTOR_REJECTION_CALLER_RUNS;
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of_with_options(&options, &instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    struct triggerfish_strong *strand;
+    assert_true(squid_strand_of(executor, &strand));
+    struct squid_strand *object;
+    assert_true(triggerfish_strong_instance(strand, (void **) &object));
+    static struct tally tally;
+    tally = (struct tally) {0};
+    struct triggerfish_strong *out[1000];
+    for (uintmax_t i = 0; i < 1000; i++) {
+        assert_true(squid_strand_submit(object, count, &tally, &out[i]));
+    }
+    for (uintmax_t i = 0; i < 1000; i++) {
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out[i], (void **) &future));
+        struct triggerfish_strong *result;
+        assert_true(squid_future_get(future, &result, NULL));
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    assert_false(tally.is_overlapped);
+    assert_int_equal(tally.count, 1000);
+    assert_true(triggerfish_strong_release(strand));
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static atomic_bool is_open;
+
+static void gate(void *const args,
+                 bool (*const is_cancelled)(void),
+                 struct triggerfish_strong **const out,
+                 uintmax_t *const error) {
+    atomic_store((atomic_bool *) args, true);
+    const struct timespec delay = {
+            .tv_nsec = 1000000 /* 1 millisecond */
+    };
+    /* shutting down the executor opens it as well */
+    while (!atomic_load(&is_open) && !is_cancelled()) {
+        nanosleep(&delay, NULL);
+    }
+}
+
+/* single thread executor held up by a gate until the tasks are queued */
+static struct squid_executor *gated_of(struct triggerfish_strong **const out) {
+    struct squid_executor_options options;
+    assert_true(squid_executor_options_init(&options));
+    options.threads.maximum = 1;
+    assert_true(squid_executor_of_with_options(&options, out));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(*out, (void **) &executor));
+    atomic_store(&is_open, false);
+    static atomic_bool is_held;
+    atomic_store(&is_held, false);
+    assert_true(squid_executor_execute(executor, gate, &is_held));
+    const struct timespec delay = {
+            .tv_nsec = 1000000 /* 1 millisecond */
+    };
+    while (!atomic_load(&is_held)) {
+        nanosleep(&delay, NULL);
+    }
+    return executor;
+}
+
+static void check_submit_with_cancel(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    struct squid_executor *executor = gated_of(&instance);
+    struct triggerfish_strong *strand;
+    assert_true(squid_strand_of(executor, &strand));
+    struct squid_strand *object;
+    assert_true(triggerfish_strong_instance(strand, (void **) &object));
+    static struct tally tally;
+    tally = (struct tally) {0};
+    struct triggerfish_strong *out[3];
+    struct squid_future *futures[3];
+    for (uintmax_t i = 0; i < 3; i++) {
+        assert_true(squid_strand_submit(object, count, &tally, &out[i]));
+        assert_true(triggerfish_strong_instance(out[i],
+                                                (void **) &futures[i]));
+    }
+    /* first is queued on the executor while the others wait in the strand */
+    assert_true(squid_future_cancel(futures[0], NULL));
+    assert_true(squid_future_cancel(futures[1], NULL));
+    atomic_store(&is_open, true);
+    struct triggerfish_strong *result;
+    assert_true(squid_future_get(futures[2], &result, NULL));
+    assert_int_equal(tally.count, 1);
+    for (uintmax_t i = 0; i < 2; i++) {
+        assert_false(squid_future_get(futures[i], &result, NULL));
+        assert_int_equal(SQUID_FUTURE_ERROR_FUTURE_IS_CANCELLED, squid_error);
+    }
+    const struct timespec delay = {
+            .tv_nsec = 1000000 /* 1 millisecond */
+    };
+    uintmax_t pending;
+    do {
+        nanosleep(&delay, NULL);
+        assert_true(squid_strand_pending(object, &pending));
+    } while (pending);
+    for (uintmax_t i = 0; i < 3; i++) {
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    assert_true(triggerfish_strong_release(strand));
+    assert_true(squid_executor_shutdown(executor));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_with_shutdown(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    struct squid_executor *executor = gated_of(&instance);
+    struct triggerfish_strong *strand;
+    assert_true(squid_strand_of(executor, &strand));
+    struct squid_strand *object;
+    assert_true(triggerfish_strong_instance(strand, (void **) &object));
+    static struct tally tally;
+    tally = (struct tally) {0};
+    struct triggerfish_strong *out[1000];
+    for (uintmax_t i = 0; i < 1000; i++) {
+        assert_true(squid_strand_submit(object, count, &tally, &out[i]));
+    }
+    assert_true(squid_executor_shutdown(executor));
+    /* tasks left in the strand are cancelled one after the other */
+    for (uintmax_t i = 0; i < 1000; i++) {
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out[i], (void **) &future));
+        struct triggerfish_strong *result;
+        assert_false(squid_future_get(future, &result, NULL));
+        assert_int_equal(SQUID_FUTURE_ERROR_FUTURE_IS_CANCELLED, squid_error);
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    assert_int_equal(tally.count, 0);
+    uintmax_t pending;
+    assert_true(squid_strand_pending(object, &pending));
+    assert_int_equal(pending, 0);
+    assert_true(triggerfish_strong_release(strand));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_submit_with_shutdown_now(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct triggerfish_strong *instance;
+    struct squid_executor *executor = gated_of(&instance);
+    struct triggerfish_strong *strand;
+    assert_true(squid_strand_of(executor, &strand));
+    struct squid_strand *object;
+    assert_true(triggerfish_strong_instance(strand, (void **) &object));
+    static struct tally tally;
+    tally = (struct tally) {0};
+    struct triggerfish_strong *out[10];
+    for (uintmax_t i = 0; i < 10; i++) {
+        assert_true(squid_strand_submit(object, count, &tally, &out[i]));
+    }
+    uintmax_t drained;
+    assert_true(squid_executor_shutdown_now(executor, &drained));
+    assert_int_equal(drained, 1);
+    for (uintmax_t i = 0; i < 10; i++) {
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out[i], (void **) &future));
+        enum squid_future_status status;
+        assert_true(squid_future_status(future, &status));
+        assert_int_equal(status, SQUID_FUTURE_STATUS_CANCELLED);
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    assert_int_equal(tally.count, 0);
+    assert_true(triggerfish_strong_release(strand));
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_pending_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_strand_pending(NULL, (void *) 1));
+    assert_int_equal(SQUID_STRAND_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_pending_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_strand_pending((void *) 1, NULL));
+    assert_int_equal(SQUID_STRAND_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_advance_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_strand_advance(NULL));
+    assert_int_equal(SQUID_STRAND_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+int main(int argc, char *argv[]) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(check_invalidate_error_on_object_is_null),
+            cmocka_unit_test(check_invalidate),
+            cmocka_unit_test(check_init_error_on_object_is_null),
+            cmocka_unit_test(check_init_error_on_executor_is_null),
+            cmocka_unit_test(check_init),
+            cmocka_unit_test(check_of_error_on_executor_is_null),
+            cmocka_unit_test(check_of_error_on_out_is_null),
+            cmocka_unit_test(check_of_error_on_is_busy_shutting_down),
+            cmocka_unit_test(check_of_error_on_memory_allocation_failed),
+            cmocka_unit_test(check_of),
+            cmocka_unit_test(check_submit_error_on_object_is_null),
+            cmocka_unit_test(check_submit_error_on_function_is_null),
+            cmocka_unit_test(check_submit_error_on_out_is_null),
+            cmocka_unit_test(check_submit_error_on_is_busy_shutting_down),
+            cmocka_unit_test(check_submit_error_on_memory_allocation_failed),
+            cmocka_unit_test(check_submit),
+            cmocka_unit_test(check_submit_from_within_strand),
+            cmocka_unit_test(check_submit_with_caller_runs),
+            cmocka_unit_test(check_submit_with_cancel),
+            cmocka_unit_test(check_submit_with_shutdown),
+            cmocka_unit_test(check_submit_with_shutdown_now),
+            cmocka_unit_test(check_pending_error_on_object_is_null),
+            cmocka_unit_test(check_pending_error_on_out_is_null),
+            cmocka_unit_test(check_advance_error_on_object_is_null),
+    };
+    //cmocka_set_message_output(CM_OUTPUT_XML);
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
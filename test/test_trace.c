@@ -0,0 +1,164 @@
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <squid.h>
+
+#include "private/executer.h"
+#include "private/future.h"
+#include "private/trace.h"
+
+#include <test/cmocka.h>
+
+static void check_dump_error_on_path_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_trace_dump(NULL));
+    assert_int_equal(SQUID_TRACE_ERROR_PATH_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+#ifdef SQUID_TRACE
+
+static void check_dump_error_on_file_open_failed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_trace_dump("/non/existent/directory/trace.json"));
+    assert_int_equal(SQUID_TRACE_ERROR_FILE_OPEN_FAILED, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void function(void *const args,
+                     bool (*const is_cancelled)(void),
+                     struct triggerfish_strong **const out,
+                     uintmax_t *const error) {
+    atomic_fetch_add((atomic_uintmax_t *) args, 1);
+}
+
+/* dumps into a file of its own and counts how often pattern occurs in it */
+static uintmax_t occurrences(const char *const pattern) {
+    char path[] = "/tmp/squid-trace-XXXXXX";
+    const int descriptor = mkstemp(path);
+    assert_int_not_equal(descriptor, -1);
+    assert_int_equal(close(descriptor), 0);
+    assert_true(squid_trace_dump(path));
+    FILE *const file = fopen(path, "r");
+    assert_non_null(file);
+    assert_int_equal(fseek(file, 0, SEEK_END), 0);
+    const long size = ftell(file);
+    assert_true(size > 0);
+    rewind(file);
+    char *const contents = malloc(size + 1);
+    assert_non_null(contents);
+    assert_int_equal(fread(contents, 1, size, file), size);
+    contents[size] = '\0';
+    assert_int_equal(fclose(file), 0);
+    assert_int_equal(unlink(path), 0);
+    assert_ptr_equal(strstr(contents, "{\"displayTimeUnit\":\"ns\","
+                                      "\"traceEvents\":["), contents);
+    assert_int_equal(strcmp(contents + size - 3, "]}\n"), 0);
+    uintmax_t count = 0;
+    for (const char *at = contents; (at = strstr(at, pattern));
+         at += strlen(pattern)) {
+        count++;
+    }
+    free(contents);
+    return count;
+}
+
+static void check_dump(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    /* leave out whatever was recorded ahead of us */
+    occurrences("\"ph\"");
+    struct triggerfish_strong *instance;
+    assert_true(squid_executor_of(&instance));
+    struct squid_executor *executor;
+    assert_true(triggerfish_strong_instance(instance, (void **) &executor));
+    atomic_uintmax_t runs = 0;
+    struct triggerfish_strong *out[16];
+    for (uintmax_t i = 0; i < 16; i++) {
+        assert_true(squid_executor_submit(executor, function, &runs,
+                                          &out[i]));
+    }
+    for (uintmax_t i = 0; i < 16; i++) {
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out[i], (void **) &future));
+        struct triggerfish_strong *result;
+        assert_true(squid_future_get(future, &result, NULL));
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    assert_int_equal(atomic_load(&runs), 16);
+    assert_int_equal(occurrences("\"ph\":\"B\""), 16);
+    /* the first dump took the events out of the buffers */
+    assert_int_equal(occurrences("\"ph\":\"B\""), 0);
+    for (uintmax_t i = 0; i < 16; i++) {
+        assert_true(squid_executor_submit(executor, function, &runs,
+                                          &out[i]));
+    }
+    for (uintmax_t i = 0; i < 16; i++) {
+        struct squid_future *future;
+        assert_true(triggerfish_strong_instance(out[i], (void **) &future));
+        struct triggerfish_strong *result;
+        assert_true(squid_future_get(future, &result, NULL));
+        assert_true(triggerfish_strong_release(out[i]));
+    }
+    assert_int_equal(occurrences("\"ph\":\"f\""), 16);
+    assert_true(triggerfish_strong_release(instance));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_dump_pairs_events(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    occurrences("\"ph\"");
+    squid_trace_record(SQUID_TRACE_KIND_ENQUEUE, (void *) 1, NULL, 1000,
+                       1000);
+    squid_trace_record(SQUID_TRACE_KIND_START, (void *) 1, NULL, 1000, 3500);
+    squid_trace_record(SQUID_TRACE_KIND_FINISH, (void *) 1, NULL, 1000, 4000);
+    char path[] = "/tmp/squid-trace-XXXXXX";
+    const int descriptor = mkstemp(path);
+    assert_int_not_equal(descriptor, -1);
+    assert_int_equal(close(descriptor), 0);
+    assert_true(squid_trace_dump(path));
+    FILE *const file = fopen(path, "r");
+    assert_non_null(file);
+    char contents[4096];
+    const size_t size = fread(contents, 1, sizeof(contents) - 1, file);
+    contents[size] = '\0';
+    assert_int_equal(fclose(file), 0);
+    assert_int_equal(unlink(path), 0);
+    /* the flow ties the enqueue to the start and the wait is in µs */
+    assert_non_null(strstr(contents, "\"ph\":\"s\",\"id\":\"0x1:1000\""));
+    assert_non_null(strstr(contents, "\"ph\":\"f\",\"bp\":\"e\","
+                                     "\"id\":\"0x1:1000\""));
+    assert_non_null(strstr(contents, "\"waited_us\":2.500"));
+    assert_non_null(strstr(contents, "\"ph\":\"E\""));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+#else
+
+static void check_dump_error_on_is_disabled(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_trace_dump("trace.json"));
+    assert_int_equal(SQUID_TRACE_ERROR_IS_DISABLED, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+#endif
+
+int main(int argc, char *argv[]) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(check_dump_error_on_path_is_null),
+#ifdef SQUID_TRACE
+            cmocka_unit_test(check_dump_error_on_file_open_failed),
+            cmocka_unit_test(check_dump),
+            cmocka_unit_test(check_dump_pairs_events),
+#else
+            cmocka_unit_test(check_dump_error_on_is_disabled),
+#endif
+    };
+    //cmocka_set_message_output(CM_OUTPUT_XML);
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
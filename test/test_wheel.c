@@ -0,0 +1,361 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <squid.h>
+
+#include "private/wheel.h"
+
+#include <test/cmocka.h>
+
+static void check_invalidate_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_wheel_invalidate(NULL));
+    assert_int_equal(SQUID_WHEEL_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_invalidate(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_wheel object = {};
+    assert_true(squid_wheel_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_wheel_init(NULL, 0));
+    assert_int_equal(SQUID_WHEEL_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_init(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_wheel object;
+    assert_true(squid_wheel_init(&object, 42));
+    uintmax_t count;
+    assert_true(squid_wheel_count(&object, &count));
+    assert_int_equal(count, 0);
+    uint64_t next;
+    assert_false(squid_wheel_next(&object, &next));
+    assert_int_equal(SQUID_WHEEL_ERROR_WHEEL_IS_EMPTY, squid_error);
+    assert_true(squid_wheel_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_wheel_add(NULL, (void *) 1, 0));
+    assert_int_equal(SQUID_WHEEL_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_error_on_timer_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_wheel_add((void *) 1, NULL, 0));
+    assert_int_equal(SQUID_WHEEL_ERROR_TIMER_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_error_on_timer_is_armed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_wheel object;
+    assert_true(squid_wheel_init(&object, 0));
+    struct squid_wheel_timer timer = {};
+    assert_true(squid_wheel_add(&object, &timer, 10));
+    assert_false(squid_wheel_add(&object, &timer, 10));
+    assert_int_equal(SQUID_WHEEL_ERROR_TIMER_IS_ARMED, squid_error);
+    assert_true(squid_wheel_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_remove_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_wheel_remove(NULL, (void *) 1));
+    assert_int_equal(SQUID_WHEEL_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_remove_error_on_timer_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_wheel_remove((void *) 1, NULL));
+    assert_int_equal(SQUID_WHEEL_ERROR_TIMER_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_remove_error_on_timer_is_not_armed(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_wheel object;
+    assert_true(squid_wheel_init(&object, 0));
+    struct squid_wheel_timer timer = {};
+    assert_false(squid_wheel_remove(&object, &timer));
+    assert_int_equal(SQUID_WHEEL_ERROR_TIMER_IS_NOT_ARMED, squid_error);
+    assert_true(squid_wheel_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_add_and_remove(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_wheel object;
+    assert_true(squid_wheel_init(&object, 0));
+    struct squid_wheel_timer timers[3] = {};
+    assert_true(squid_wheel_add(&object, &timers[0], 5));
+    assert_true(squid_wheel_add(&object, &timers[1], 5000));
+    assert_true(squid_wheel_add(&object, &timers[2], 5000000));
+    uintmax_t count;
+    assert_true(squid_wheel_count(&object, &count));
+    assert_int_equal(count, 3);
+    bool is_armed;
+    for (uintmax_t i = 0; i < 3; i++) {
+        assert_true(squid_wheel_is_armed(&timers[i], &is_armed));
+        assert_true(is_armed);
+        assert_true(squid_wheel_remove(&object, &timers[i]));
+        assert_true(squid_wheel_is_armed(&timers[i], &is_armed));
+        assert_false(is_armed);
+    }
+    assert_true(squid_wheel_count(&object, &count));
+    assert_int_equal(count, 0);
+    for (uintmax_t i = 0; i < SQUID_WHEEL_LEVELS; i++) {
+        assert_int_equal(object.occupied[i], 0);
+    }
+    assert_true(squid_wheel_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_is_armed_error_on_timer_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_wheel_is_armed(NULL, (void *) 1));
+    assert_int_equal(SQUID_WHEEL_ERROR_TIMER_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_is_armed_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_wheel_is_armed((void *) 1, NULL));
+    assert_int_equal(SQUID_WHEEL_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_advance_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_wheel_advance(NULL, 0, (void *) 1, NULL, (void *) 1));
+    assert_int_equal(SQUID_WHEEL_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_advance_error_on_function_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_wheel_advance((void *) 1, 0, NULL, NULL, (void *) 1));
+    assert_int_equal(SQUID_WHEEL_ERROR_FUNCTION_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_advance_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_wheel_advance((void *) 1, 0, (void *) 1, NULL, NULL));
+    assert_int_equal(SQUID_WHEEL_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+struct expired {
+    uint64_t now;
+    uintmax_t count;
+    uint64_t late;
+};
+
+static void expire(struct squid_wheel_timer *const timer, void *const args) {
+    struct expired *const expired = args;
+    assert_true(timer->expiry <= expired->now);
+    if (expired->now - timer->expiry > expired->late) {
+        expired->late = expired->now - timer->expiry;
+    }
+    expired->count++;
+}
+
+static void check_advance(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_wheel object;
+    assert_true(squid_wheel_init(&object, 100));
+    /* spread over every level and beyond the reach of the wheel */
+    const uint64_t expiries[] = {
+            100, 101, 163, 164, 4000, 4195, 300000, 17000000, 1100000000,
+            (uint64_t) 1 << 40
+    };
+    const uintmax_t count = sizeof(expiries) / sizeof(expiries[0]);
+    struct squid_wheel_timer timers[sizeof(expiries) / sizeof(expiries[0])]
+            = {};
+    for (uintmax_t i = 0; i < count; i++) {
+        assert_true(squid_wheel_add(&object, &timers[i], expiries[i]));
+    }
+    struct expired expired = {0};
+    uintmax_t out;
+    for (uintmax_t i = 0; i < count; i++) {
+        /* nothing expires before its time */
+        expired.now = expiries[i] - 1;
+        assert_true(squid_wheel_advance(&object, expired.now, expire,
+                                        &expired, &out));
+        assert_int_equal(expired.count, i);
+        uint64_t next;
+        assert_true(squid_wheel_next(&object, &next));
+        assert_true(next <= expiries[i]);
+        expired.now = expiries[i];
+        assert_true(squid_wheel_advance(&object, expired.now, expire,
+                                        &expired, &out));
+        assert_int_equal(out, 1);
+        assert_int_equal(expired.count, 1 + i);
+    }
+    assert_int_equal(expired.late, 0);
+    assert_true(squid_wheel_next(&object, &(uint64_t) {0}) == false);
+    assert_true(squid_wheel_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_advance_with_expiry_in_the_past(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_wheel object;
+    assert_true(squid_wheel_init(&object, 1000));
+    struct squid_wheel_timer timer = {};
+    assert_true(squid_wheel_add(&object, &timer, 10));
+    struct expired expired = {.now = 1000, .late = 0};
+    uintmax_t out;
+    assert_true(squid_wheel_advance(&object, 1000, expire, &expired, &out));
+    assert_int_equal(out, 1);
+    assert_true(squid_wheel_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static struct squid_wheel *rearming;
+
+static void rearm(struct squid_wheel_timer *const timer, void *const args) {
+    uintmax_t *const count = args;
+    (*count)++;
+    /* lands a full turn of the lowest level later, not in this tick */
+    assert_true(squid_wheel_add(rearming, timer, timer->expiry + 64));
+}
+
+static void check_advance_with_rearm(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_wheel object;
+    assert_true(squid_wheel_init(&object, 0));
+    rearming = &object;
+    struct squid_wheel_timer timer = {};
+    assert_true(squid_wheel_add(&object, &timer, 1));
+    uintmax_t count = 0;
+    uintmax_t out;
+    assert_true(squid_wheel_advance(&object, 1, rearm, &count, &out));
+    assert_int_equal(count, 1);
+    assert_true(squid_wheel_advance(&object, 64, rearm, &count, &out));
+    assert_int_equal(count, 1);
+    assert_true(squid_wheel_advance(&object, 65 + 64 * 9, rearm, &count,
+                                    &out));
+    assert_int_equal(count, 11);
+    assert_true(squid_wheel_remove(&object, &timer));
+    assert_true(squid_wheel_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_drain_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_wheel_drain(NULL, (void *) 1, NULL, (void *) 1));
+    assert_int_equal(SQUID_WHEEL_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_drain_error_on_function_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_wheel_drain((void *) 1, NULL, NULL, (void *) 1));
+    assert_int_equal(SQUID_WHEEL_ERROR_FUNCTION_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_drain_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_wheel_drain((void *) 1, (void *) 1, NULL, NULL));
+    assert_int_equal(SQUID_WHEEL_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void count(struct squid_wheel_timer *const timer, void *const args) {
+    (*(uintmax_t *) args)++;
+}
+
+static void check_drain(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    struct squid_wheel object;
+    assert_true(squid_wheel_init(&object, 0));
+    struct squid_wheel_timer timers[100] = {};
+    for (uintmax_t i = 0; i < 100; i++) {
+        assert_true(squid_wheel_add(&object, &timers[i], i * i * i * i));
+    }
+    uintmax_t counted = 0;
+    uintmax_t out;
+    assert_true(squid_wheel_drain(&object, count, &counted, &out));
+    assert_int_equal(out, 100);
+    assert_int_equal(counted, 100);
+    assert_true(squid_wheel_count(&object, &out));
+    assert_int_equal(out, 0);
+    assert_true(squid_wheel_invalidate(&object));
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_next_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_wheel_next(NULL, (void *) 1));
+    assert_int_equal(SQUID_WHEEL_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_next_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_wheel_next((void *) 1, NULL));
+    assert_int_equal(SQUID_WHEEL_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_count_error_on_object_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_wheel_count(NULL, (void *) 1));
+    assert_int_equal(SQUID_WHEEL_ERROR_OBJECT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+static void check_count_error_on_out_is_null(void **state) {
+    squid_error = SQUID_ERROR_NONE;
+    assert_false(squid_wheel_count((void *) 1, NULL));
+    assert_int_equal(SQUID_WHEEL_ERROR_OUT_IS_NULL, squid_error);
+    squid_error = SQUID_ERROR_NONE;
+}
+
+int main(int argc, char *argv[]) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(check_invalidate_error_on_object_is_null),
+            cmocka_unit_test(check_invalidate),
+            cmocka_unit_test(check_init_error_on_object_is_null),
+            cmocka_unit_test(check_init),
+            cmocka_unit_test(check_add_error_on_object_is_null),
+            cmocka_unit_test(check_add_error_on_timer_is_null),
+            cmocka_unit_test(check_add_error_on_timer_is_armed),
+            cmocka_unit_test(check_remove_error_on_object_is_null),
+            cmocka_unit_test(check_remove_error_on_timer_is_null),
+            cmocka_unit_test(check_remove_error_on_timer_is_not_armed),
+            cmocka_unit_test(check_add_and_remove),
+            cmocka_unit_test(check_is_armed_error_on_timer_is_null),
+            cmocka_unit_test(check_is_armed_error_on_out_is_null),
+            cmocka_unit_test(check_advance_error_on_object_is_null),
+            cmocka_unit_test(check_advance_error_on_function_is_null),
+            cmocka_unit_test(check_advance_error_on_out_is_null),
+            cmocka_unit_test(check_advance),
+            cmocka_unit_test(check_advance_with_expiry_in_the_past),
+            cmocka_unit_test(check_advance_with_rearm),
+            cmocka_unit_test(check_drain_error_on_object_is_null),
+            cmocka_unit_test(check_drain_error_on_function_is_null),
+            cmocka_unit_test(check_drain_error_on_out_is_null),
+            cmocka_unit_test(check_drain),
+            cmocka_unit_test(check_next_error_on_object_is_null),
+            cmocka_unit_test(check_next_error_on_out_is_null),
+            cmocka_unit_test(check_count_error_on_object_is_null),
+            cmocka_unit_test(check_count_error_on_out_is_null),
+    };
+    //cmocka_set_message_output(CM_OUTPUT_XML);
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}